@@ -0,0 +1,131 @@
+#ifndef ARRAY_INDEX_HPP
+#define ARRAY_INDEX_HPP
+
+#include "../types/json_array.hpp"
+#include "../types/json_object.hpp"
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+// An index on one field of the records in an array, so that elements are
+// found by the value of that field without scanning the array. The path is
+// dotted, as for column_table. Only elements that are objects with a null,
+// boolean, number or string at the path are indexed.
+//
+// A hash index finds equal keys; a sorted index also finds ranges, in key
+// order, where null < booleans < numbers < strings. Elements with equal keys
+// are returned in array order.
+//
+// The index follows json_array::version: on the next lookup after the
+// array changed, elements appended since are added and any other change
+// rebuilds it. Call rebuild() after modifying elements through references
+// the array handed out before. Lookups may run concurrently as long as the
+// array is not modified meanwhile.
+class array_index {
+public:
+    enum class kind {
+        hash,
+        sorted
+    };
+
+    static constexpr size_t npos = std::numeric_limits<size_t>::max();
+
+    // A value to look up, referring to the string it is made from
+    class key {
+    public:
+        key(std::nullptr_t);
+        key(bool value);
+        key(double value);
+
+        // Any integer type, so std::int64_t and size_t ids are not
+        // ambiguous between the double and bool overloads
+        template <typename T, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value, int>::type = 0>
+        key(T value) : type_(json_type::number), boolean_(false), number_(static_cast<double>(value)) {}
+        key(const char* value);
+        key(std::string_view value);
+        key(const std::string& value);
+        key(const json_value& value);
+
+    private:
+        friend class array_index;
+
+        json_type type_;
+        bool boolean_;
+        double number_;
+        std::string_view string_;
+    };
+
+    // The array must outlive the index
+    array_index(const json_array& array, std::string_view path, kind type = kind::hash);
+
+    // First element whose field equals k, or nullptr
+    const json_value* find(const key& k) const;
+    // Throws std::out_of_range if there is none
+    const json_value& at(const key& k) const;
+    // Position of that element in the array, or npos
+    size_t position(const key& k) const;
+    std::vector<const json_value*> find_all(const key& k) const;
+    // Elements whose field is between low and high inclusive, in key order;
+    // throws std::runtime_error for hash indexes
+    std::vector<const json_value*> range(const key& low, const key& high) const;
+
+    const std::string& path() const;
+    kind type() const;
+    // Number of indexed elements
+    size_t size() const;
+    void rebuild();
+
+private:
+    struct slot {
+        size_t hash;
+        // Positions of the first and last element with the key, chained in
+        // between through next_; first is npos for empty slots
+        size_t first;
+        size_t last;
+    };
+
+    const json_array& array_;
+    std::string path_;
+    kind type_;
+    std::vector<std::string> segments_;
+    // Cache the offsets of the segments while indexing rows of one shape
+    std::vector<json_object::member_key> member_keys_;
+
+    mutable std::mutex mutex_;
+    // Version of the array the index was brought up to date with
+    mutable std::atomic<std::uint64_t> version_;
+    // Elements looked at so far, those indexed and their distinct keys
+    mutable size_t scanned_;
+    mutable size_t count_;
+    mutable size_t distinct_;
+    mutable std::vector<slot> slots_;
+    mutable std::vector<size_t> next_;
+    // Positions sorted by key, for sorted indexes
+    mutable std::vector<size_t> order_;
+
+    void update() const;
+    // Brings the index up to date with the array, adding the elements
+    // appended since unless full is set or the array was rewritten
+    void refresh(bool full) const;
+    void add(size_t position, const json_value& element) const;
+    void grow() const;
+    // Field of an element while indexing, and of an indexed element
+    const json_value* resolve(const json_value& element) const;
+    key key_of(size_t position) const;
+    size_t lookup(const key& k) const;
+    // First entry of order_ not ordered before k if inclusive, else the
+    // first one ordered after k
+    size_t bound(const key& k, bool inclusive) const;
+
+    static bool indexable(const json_value* value);
+    static size_t hash(const key& k);
+    // Negative, zero or positive as a orders before, with or after b
+    static int compare(const key& a, const key& b);
+};
+
+#endif // ARRAY_INDEX_HPP
@@ -0,0 +1,54 @@
+#ifndef COLUMN_BUILDER_HPP
+#define COLUMN_BUILDER_HPP
+
+#include "column_table.hpp"
+#include "../parser/json_handler.hpp"
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Handler that fills a column_table straight from parse events. The
+// document must be an array; each element is a row. Numbers are only
+// converted when they land in a requested column, and subtrees that
+// cannot contain a requested path are skipped.
+class column_builder : public json_handler {
+public:
+    column_builder(column_table& table);
+
+    bool null_value() override;
+    bool boolean_value(bool value) override;
+    bool number_value(std::string& lexeme) override;
+    bool string_value(std::string& value) override;
+    bool begin_object() override;
+    bool key(std::string& key) override;
+    bool end_object() override;
+    bool begin_array() override;
+    bool end_array() override;
+
+    parse_error failure() const override;
+
+private:
+    enum class frame_kind {
+        rows,
+        record,
+        skipped
+    };
+
+    struct frame {
+        frame_kind kind;
+        size_t base;
+    };
+
+    column_table& table_;
+    std::unordered_map<std::string, column*> targets_;
+    std::unordered_set<std::string> prefixes_;
+    std::vector<frame> stack_;
+    std::string path_;
+    parse_error failure_;
+
+    bool begin_value(column*& target);
+    bool begin_container(bool is_object);
+};
+
+#endif // COLUMN_BUILDER_HPP
@@ -0,0 +1,119 @@
+#ifndef COLUMN_TABLE_HPP
+#define COLUMN_TABLE_HPP
+
+#include "../types/json_array.hpp"
+#include "../parser/parse_options.hpp"
+#include "../utils/numeric_kernels.hpp"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// One field of an array of records, stored contiguously. The column's type
+// is that of the first non-null value; missing fields, nulls and values of
+// any other type (counted by mismatch_count) are null rows. Null rows hold
+// 0, false or "" in the data buffers, and validity() has a set bit for
+// every non-null row.
+class column {
+public:
+    enum class kind {
+        null,
+        number,
+        boolean,
+        string
+    };
+
+    using bitmap = std::vector<std::uint64_t>;
+    using comparison = numeric_kernels::comparison;
+
+    column(std::string path);
+
+    const std::string& path() const;
+    kind type() const;
+    size_t size() const;
+    size_t null_count() const;
+    size_t mismatch_count() const;
+    bool is_null(size_t row) const;
+
+    double number(size_t row) const;
+    bool boolean(size_t row) const;
+    std::string_view string(size_t row) const;
+
+    const bitmap& validity() const;
+    const std::vector<double>& numbers() const;
+    const std::vector<std::uint8_t>& booleans() const;
+    // Row i is string_data()[string_offsets()[i], string_offsets()[i + 1])
+    const std::string& string_data() const;
+    const std::vector<size_t>& string_offsets() const;
+
+    // Aggregates over non-null rows, optionally restricted to the rows set
+    // in a bitmap such as one returned by filter(). min() and max() throw
+    // std::runtime_error when no row is selected.
+    size_t count() const;
+    size_t count(const bitmap& rows) const;
+    double sum() const;
+    double sum(const bitmap& rows) const;
+    double min() const;
+    double min(const bitmap& rows) const;
+    double max() const;
+    double max(const bitmap& rows) const;
+    // Non-null rows whose value compares true against value
+    bitmap filter(comparison op, double value) const;
+
+private:
+    friend class column_table;
+    friend class column_builder;
+
+    std::string path_;
+    kind type_;
+    size_t size_;
+    size_t mismatches_;
+    bitmap validity_;
+    std::vector<double> numbers_;
+    std::vector<std::uint8_t> booleans_;
+    std::string chars_;
+    std::vector<size_t> offsets_;
+
+    void append_null();
+    // Each setter fills the last row
+    void set_number(double value);
+    void set_boolean(bool value);
+    void set_string(std::string_view value);
+    bool adopt(kind type);
+    void require(kind type) const;
+    bool has_numbers() const;
+    void check_row(size_t row) const;
+    bitmap selected(const bitmap& rows) const;
+};
+
+// Struct-of-arrays view of an array of objects. Fields are named by dotted
+// paths ("user.address.city") that descend through nested objects.
+class column_table {
+public:
+    column_table(const std::vector<std::string>& paths);
+
+    // Extract from a tree; rows that are not objects are all null
+    static column_table from_array(const json_array& rows, const std::vector<std::string>& paths);
+    // Extract while parsing text, which must be an array, without building
+    // a tree. Throws std::runtime_error if the text is not valid JSON or
+    // not an array.
+    static column_table parse(const std::string& text, const std::vector<std::string>& paths,
+                              const parse_options& options = parse_options());
+
+    size_t rows() const;
+    size_t column_count() const;
+    const column& operator[](size_t index) const;
+    // Throws std::out_of_range if path was not extracted
+    const column& operator[](std::string_view path) const;
+    const column* find(std::string_view path) const;
+
+private:
+    friend class column_builder;
+
+    std::vector<column> columns_;
+    size_t rows_;
+
+    void append_row();
+};
+
+#endif // COLUMN_TABLE_HPP
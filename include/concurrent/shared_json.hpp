@@ -0,0 +1,33 @@
+#ifndef SHARED_JSON_HPP
+#define SHARED_JSON_HPP
+
+#include "../types/json_value.hpp"
+#include <functional>
+#include <memory>
+#include <mutex>
+
+// A document shared between threads. Readers take an immutable snapshot
+// and read it through the const API without any lock; writers publish a
+// new version, which readers pick up on their next load(). Snapshots stay
+// valid for as long as a reader holds them.
+class shared_json {
+public:
+    using snapshot = std::shared_ptr<const json_value>;
+
+    shared_json();
+    shared_json(const json_value& value);
+    shared_json(json_value&& value);
+    shared_json(const shared_json&) = delete;
+    shared_json& operator=(const shared_json&) = delete;
+
+    snapshot load() const;
+    void store(const json_value& value);
+    void store(json_value&& value);
+    void update(const std::function<void(json_value&)>& mutator);
+
+private:
+    snapshot current_;
+    std::mutex writer_mutex_;
+};
+
+#endif // SHARED_JSON_HPP
@@ -0,0 +1,55 @@
+#ifndef CBOR_HPP
+#define CBOR_HPP
+
+#include "../types/json_value.hpp"
+#include "../parser/parse_options.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// CBOR (RFC 8949) encoding of json_value trees.
+// Integral numbers are written as CBOR integers, other numbers as the
+// narrowest float that round-trips. Decoding accepts definite and
+// indefinite length items, skips tags and maps undefined to null. Arrays
+// and maps nested deeper than parse_options::max_depth are rejected, so
+// hostile input cannot exhaust the call stack.
+class cbor_encoder {
+public:
+    cbor_encoder(std::vector<std::uint8_t>& out);
+
+    void encode(const json_value& value);
+
+private:
+    std::vector<std::uint8_t>& out_;
+
+    void write_head(std::uint8_t major, std::uint64_t argument);
+    void write_number(double value);
+    void write_string(const std::string& value);
+};
+
+class cbor_decoder {
+public:
+    cbor_decoder(const std::uint8_t* data, size_t size, const parse_options& options = parse_options());
+    cbor_decoder(const std::vector<std::uint8_t>& data, const parse_options& options = parse_options());
+
+    json_value decode();
+
+private:
+    const std::uint8_t* data_;
+    size_t size_;
+    size_t pos_;
+    size_t depth_;
+    size_t max_depth_;
+
+    std::uint8_t consume();
+    std::uint64_t read_uint(size_t bytes);
+    std::uint64_t read_argument(std::uint8_t info);
+    bool at_break() const;
+    json_value decode_item();
+    std::string decode_text(std::uint8_t info);
+    json_value decode_array(std::uint8_t info);
+    json_value decode_object(std::uint8_t info);
+    json_value decode_simple(std::uint8_t info);
+};
+
+#endif // CBOR_HPP
@@ -0,0 +1,736 @@
+#ifndef CONST_JSON_HPP
+#define CONST_JSON_HPP
+
+#include "../types/json_value.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+// JSON parsed at compile time into a read-only array of nodes. Nodes are
+// stored in document order; an object's children alternate key (a string
+// node) and value. String contents and number lexemes live in a separate
+// character pool.
+struct const_json_node {
+    json_type type = json_type::null;
+    bool boolean = false;
+    // False if number is only an approximation of the lexeme; reads then
+    // convert the lexeme at run time
+    bool exact = true;
+    double number = 0.0;
+    // Strings: decoded text in the pool. Numbers: lexeme in the pool.
+    // Containers: size is the number of elements or members.
+    size_t begin = 0;
+    size_t size = 0;
+    // Index of the first node after this value's subtree
+    size_t next = 0;
+};
+
+// Mirrors tape_view. Accessors are constexpr, except that reading a number
+// the compiler could not convert exactly, and to_value(), run at run time.
+class const_json_view {
+public:
+    constexpr const_json_view(const const_json_node* nodes, const char* chars, size_t index)
+        : nodes_(nodes), chars_(chars), index_(index) {}
+
+    constexpr json_type type() const { return node().type; }
+    constexpr bool is_null() const { return type() == json_type::null; }
+    constexpr bool is_boolean() const { return type() == json_type::boolean; }
+    constexpr bool is_number() const { return type() == json_type::number; }
+    constexpr bool is_string() const { return type() == json_type::string; }
+    constexpr bool is_array() const { return type() == json_type::array; }
+    constexpr bool is_object() const { return type() == json_type::object; }
+
+    constexpr bool as_boolean() const {
+        if (!is_boolean()) {
+            throw std::runtime_error("Value is not boolean");
+        }
+
+        return node().boolean;
+    }
+
+    constexpr double as_number() const {
+        if (!is_number()) {
+            throw std::runtime_error("Value is not number");
+        }
+
+        return node().exact ? node().number : parse_number();
+    }
+
+    constexpr std::string_view as_string() const {
+        if (!is_string()) {
+            throw std::runtime_error("Value is not string");
+        }
+
+        return std::string_view(chars_ + node().begin, node().size);
+    }
+
+    constexpr size_t size() const {
+        if (!is_array() && !is_object()) {
+            throw std::runtime_error("Value is not a container");
+        }
+
+        return node().size;
+    }
+
+    constexpr const_json_view operator[](size_t index) const {
+        if (!is_array()) {
+            throw std::runtime_error("Value is not array");
+        }
+
+        if (index >= node().size) {
+            throw std::out_of_range("Index out of range: " + std::to_string(index));
+        }
+
+        return const_json_view(nodes_, chars_, child(index));
+    }
+
+    constexpr const_json_view operator[](std::string_view key) const {
+        size_t value = 0;
+        if (!find(key, value)) {
+            throw std::out_of_range("Key not found: " + std::string(key));
+        }
+
+        return const_json_view(nodes_, chars_, value);
+    }
+
+    constexpr bool contains(std::string_view key) const {
+        size_t value = 0;
+        return find(key, value);
+    }
+
+    constexpr std::string_view key_at(size_t index) const {
+        return const_json_view(nodes_, chars_, member(index)).as_string();
+    }
+
+    constexpr const_json_view value_at(size_t index) const {
+        return const_json_view(nodes_, chars_, nodes_[member(index)].next);
+    }
+
+    // Copies the subtree into a mutable tree
+    json_value to_value() const;
+
+private:
+    const const_json_node* nodes_;
+    const char* chars_;
+    size_t index_;
+
+    constexpr const const_json_node& node() const { return nodes_[index_]; }
+
+    // Node index of the position-th child, counting keys as children
+    constexpr size_t child(size_t position) const {
+        size_t index = index_ + 1;
+        for (size_t i = 0; i < position; ++i) {
+            index = nodes_[index].next;
+        }
+
+        return index;
+    }
+
+    // Node index of the key of the index-th member
+    constexpr size_t member(size_t index) const {
+        if (!is_object()) {
+            throw std::runtime_error("Value is not object");
+        }
+
+        if (index >= node().size) {
+            throw std::out_of_range("Index out of range: " + std::to_string(index));
+        }
+
+        size_t key = index_ + 1;
+        for (size_t i = 0; i < index; ++i) {
+            key = nodes_[nodes_[key].next].next;
+        }
+
+        return key;
+    }
+
+    constexpr bool find(std::string_view key, size_t& value) const {
+        if (!is_object()) {
+            throw std::runtime_error("Value is not object");
+        }
+
+        size_t index = index_ + 1;
+        for (size_t i = 0; i < node().size; ++i) {
+            const const_json_node& k = nodes_[index];
+            if (std::string_view(chars_ + k.begin, k.size) == key) {
+                value = k.next;
+                return true;
+            }
+
+            index = nodes_[k.next].next;
+        }
+
+        return false;
+    }
+
+    double parse_number() const;
+};
+
+template <size_t Nodes, size_t Chars>
+struct const_json_document {
+    std::array<const_json_node, Nodes> nodes{};
+    std::array<char, Chars + 1> chars{};
+
+    constexpr const_json_view root() const {
+        return const_json_view(nodes.data(), chars.data(), 0);
+    }
+};
+
+// The compile-time parser. measure() validates the text and sizes the
+// document, compile() fills a document of those sizes; JSON_LITERAL wraps
+// both. The grammar and string rules match the run-time parser with its
+// default options (UTF-8 is validated), and nesting is limited to
+// max_depth.
+class const_json {
+public:
+    static constexpr size_t max_depth = 64;
+
+    struct sizes {
+        bool ok;
+        size_t error_offset;
+        size_t nodes;
+        size_t chars;
+    };
+
+    static constexpr sizes measure(std::string_view text) {
+        counter sink;
+        return run(text, sink);
+    }
+
+    template <size_t Nodes, size_t Chars>
+    static constexpr const_json_document<Nodes, Chars> compile(std::string_view text) {
+        const_json_document<Nodes, Chars> document{};
+        filler<Nodes, Chars> sink{document};
+        run(text, sink);
+        return document;
+    }
+
+private:
+    struct counter {
+        size_t nodes = 0;
+        size_t chars = 0;
+        const_json_node scratch{};
+
+        constexpr size_t add_node() { return nodes++; }
+        constexpr const_json_node& node(size_t) { return scratch; }
+        constexpr void put(char) { ++chars; }
+    };
+
+    // Writes past the measured sizes (only possible for invalid text,
+    // which fails the static_assert anyway) are dropped
+    template <size_t Nodes, size_t Chars>
+    struct filler {
+        const_json_document<Nodes, Chars>& document;
+        size_t nodes = 0;
+        size_t chars = 0;
+        const_json_node scratch{};
+
+        constexpr size_t add_node() { return nodes++; }
+
+        constexpr const_json_node& node(size_t index) {
+            return index < Nodes ? document.nodes[index] : scratch;
+        }
+
+        constexpr void put(char c) {
+            if (chars < Chars) {
+                document.chars[chars] = c;
+            }
+
+            ++chars;
+        }
+    };
+
+    static constexpr bool is_digit(char c) {
+        return c >= '0' && c <= '9';
+    }
+
+    static constexpr void skip_whitespace(std::string_view text, size_t& pos) {
+        while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\t' || text[pos] == '\n' || text[pos] == '\r')) {
+            ++pos;
+        }
+    }
+
+    static constexpr bool keyword(std::string_view text, size_t pos, std::string_view word) {
+        return text.substr(pos, word.size()) == word;
+    }
+
+    static constexpr int hex_digit(char c) {
+        if (c >= '0' && c <= '9') {
+            return c - '0';
+        }
+
+        if (c >= 'a' && c <= 'f') {
+            return c - 'a' + 10;
+        }
+
+        if (c >= 'A' && c <= 'F') {
+            return c - 'A' + 10;
+        }
+
+        return -1;
+    }
+
+    static constexpr bool hex4(std::string_view text, size_t pos, std::uint32_t& value) {
+        if (pos + 4 > text.size()) {
+            return false;
+        }
+
+        value = 0;
+        for (size_t i = 0; i < 4; ++i) {
+            int digit = hex_digit(text[pos + i]);
+            if (digit < 0) {
+                return false;
+            }
+
+            value = value << 4 | static_cast<std::uint32_t>(digit);
+        }
+
+        return true;
+    }
+
+    // Length of the well-formed UTF-8 sequence at pos, or 0
+    static constexpr size_t utf8_length(std::string_view text, size_t pos) {
+        unsigned char lead = static_cast<unsigned char>(text[pos]);
+        size_t length = 0;
+        std::uint32_t code_point = 0;
+        if (lead < 0xC2) {
+            return 0;
+        }
+        else if (lead < 0xE0) {
+            length = 2;
+            code_point = lead & 0x1F;
+        }
+        else if (lead < 0xF0) {
+            length = 3;
+            code_point = lead & 0x0F;
+        }
+        else if (lead < 0xF5) {
+            length = 4;
+            code_point = lead & 0x07;
+        }
+        else {
+            return 0;
+        }
+
+        if (pos + length > text.size()) {
+            return 0;
+        }
+
+        for (size_t i = 1; i < length; ++i) {
+            unsigned char byte = static_cast<unsigned char>(text[pos + i]);
+            if ((byte & 0xC0) != 0x80) {
+                return 0;
+            }
+
+            code_point = code_point << 6 | (byte & 0x3F);
+        }
+
+        if (length == 3 && (code_point < 0x800 || (code_point >= 0xD800 && code_point <= 0xDFFF))) {
+            return 0;
+        }
+
+        if (length == 4 && (code_point < 0x10000 || code_point > 0x10FFFF)) {
+            return 0;
+        }
+
+        return length;
+    }
+
+    template <typename Sink>
+    static constexpr void put_utf8(Sink& sink, std::uint32_t code_point) {
+        if (code_point < 0x80) {
+            sink.put(static_cast<char>(code_point));
+        }
+        else if (code_point < 0x800) {
+            sink.put(static_cast<char>(0xC0 | (code_point >> 6)));
+            sink.put(static_cast<char>(0x80 | (code_point & 0x3F)));
+        }
+        else if (code_point < 0x10000) {
+            sink.put(static_cast<char>(0xE0 | (code_point >> 12)));
+            sink.put(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+            sink.put(static_cast<char>(0x80 | (code_point & 0x3F)));
+        }
+        else {
+            sink.put(static_cast<char>(0xF0 | (code_point >> 18)));
+            sink.put(static_cast<char>(0x80 | ((code_point >> 12) & 0x3F)));
+            sink.put(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+            sink.put(static_cast<char>(0x80 | (code_point & 0x3F)));
+        }
+    }
+
+    // pos is at the opening quote; on failure it is left at the error
+    template <typename Sink>
+    static constexpr bool parse_string(std::string_view text, size_t& pos, Sink& sink) {
+        size_t index = sink.add_node();
+        size_t begin = sink.chars;
+        ++pos;
+        while (pos < text.size()) {
+            char c = text[pos];
+            if (c == '"') {
+                ++pos;
+                const_json_node& node = sink.node(index);
+                node.type = json_type::string;
+                node.begin = begin;
+                node.size = sink.chars - begin;
+                node.next = index + 1;
+                return true;
+            }
+
+            if (c == '\\') {
+                if (pos + 1 >= text.size()) {
+                    return false;
+                }
+
+                char escape = text[pos + 1];
+                switch (escape) {
+                    case '"': sink.put('"'); break;
+                    case '\\': sink.put('\\'); break;
+                    case '/': sink.put('/'); break;
+                    case 'b': sink.put('\b'); break;
+                    case 'f': sink.put('\f'); break;
+                    case 'n': sink.put('\n'); break;
+                    case 'r': sink.put('\r'); break;
+                    case 't': sink.put('\t'); break;
+                    case 'u': {
+                        std::uint32_t code_point = 0;
+                        if (!hex4(text, pos + 2, code_point)) {
+                            return false;
+                        }
+
+                        pos += 6;
+                        if (code_point >= 0xDC00 && code_point <= 0xDFFF) {
+                            return false;
+                        }
+
+                        if (code_point >= 0xD800 && code_point <= 0xDBFF) {
+                            std::uint32_t low = 0;
+                            if (!keyword(text, pos, "\\u") || !hex4(text, pos + 2, low) || low < 0xDC00 || low > 0xDFFF) {
+                                return false;
+                            }
+
+                            pos += 6;
+                            code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low - 0xDC00);
+                        }
+
+                        put_utf8(sink, code_point);
+                        continue;
+                    }
+                    default:
+                        return false;
+                }
+
+                pos += 2;
+                continue;
+            }
+
+            unsigned char byte = static_cast<unsigned char>(c);
+            if (byte < 0x20) {
+                return false;
+            }
+
+            size_t length = byte < 0x80 ? 1 : utf8_length(text, pos);
+            if (length == 0) {
+                return false;
+            }
+
+            for (size_t i = 0; i < length; ++i) {
+                sink.put(text[pos + i]);
+            }
+
+            pos += length;
+        }
+
+        return false;
+    }
+
+    static constexpr double max_double = 1.7976931348623157e308;
+
+    // The first 17 significant digits of a digits-long significand
+    static constexpr std::uint64_t leading_digits(std::uint64_t mantissa, int digits) {
+        for (; digits > 17; --digits) {
+            mantissa /= 10;
+        }
+
+        for (; digits < 17; ++digits) {
+            mantissa *= 10;
+        }
+
+        return mantissa;
+    }
+
+    static constexpr double power_of_ten(int exponent) {
+        double result = 1.0;
+        for (int i = 0; i < exponent; ++i) {
+            result *= 10.0;
+        }
+
+        return result;
+    }
+
+    // Converts exactly when the significand has at most 15 digits and the
+    // decimal exponent is within 22 (both factors are then exact doubles);
+    // otherwise stores an approximation and marks the node inexact
+    template <typename Sink>
+    static constexpr bool parse_number(std::string_view text, size_t& pos, Sink& sink) {
+        size_t start = pos;
+        bool negative = false;
+        if (text[pos] == '-') {
+            negative = true;
+            ++pos;
+        }
+
+        if (pos >= text.size() || !is_digit(text[pos])) {
+            return false;
+        }
+
+        std::uint64_t mantissa = 0;
+        int digits = 0;
+        int exponent = 0;
+        bool truncated = false;
+        auto add_digit = [&](char c, bool fraction) {
+            int digit = c - '0';
+            if (mantissa == 0 && digit == 0) {
+                exponent -= fraction ? 1 : 0;
+            }
+            else if (digits < 19) {
+                mantissa = mantissa * 10 + static_cast<std::uint64_t>(digit);
+                ++digits;
+                exponent -= fraction ? 1 : 0;
+            }
+            else {
+                truncated = true;
+                exponent += fraction ? 0 : 1;
+            }
+        };
+
+        if (text[pos] == '0') {
+            ++pos;
+        }
+        else {
+            while (pos < text.size() && is_digit(text[pos])) {
+                add_digit(text[pos++], false);
+            }
+        }
+
+        if (pos < text.size() && text[pos] == '.') {
+            ++pos;
+            if (pos >= text.size() || !is_digit(text[pos])) {
+                return false;
+            }
+
+            while (pos < text.size() && is_digit(text[pos])) {
+                add_digit(text[pos++], true);
+            }
+        }
+
+        if (pos < text.size() && (text[pos] == 'e' || text[pos] == 'E')) {
+            ++pos;
+            bool negative_exponent = false;
+            if (pos < text.size() && (text[pos] == '+' || text[pos] == '-')) {
+                negative_exponent = text[pos] == '-';
+                ++pos;
+            }
+
+            if (pos >= text.size() || !is_digit(text[pos])) {
+                return false;
+            }
+
+            int written = 0;
+            while (pos < text.size() && is_digit(text[pos])) {
+                if (written < 100000) {
+                    written = written * 10 + (text[pos] - '0');
+                }
+
+                ++pos;
+            }
+
+            exponent += negative_exponent ? -written : written;
+        }
+
+        double value = 0.0;
+        bool exact = mantissa == 0 || (!truncated && digits <= 15 && exponent >= -22 && exponent <= 22);
+        if (mantissa != 0) {
+            // Decimal exponent of the leading digit. Overflow is not allowed
+            // in constant evaluation, so range is checked on the digits: a
+            // magnitude of 308 is out of range once the leading 17 digits
+            // exceed those of the largest double.
+            int magnitude = digits - 1 + exponent;
+            if (magnitude > 308 || (magnitude == 308 && leading_digits(mantissa, digits) > 17976931348623157ULL)) {
+                return false;
+            }
+
+            if (exact) {
+                value = static_cast<double>(mantissa);
+                value = exponent >= 0 ? value * power_of_ten(exponent) : value / power_of_ten(-exponent);
+            }
+            else {
+                value = static_cast<double>(mantissa) / power_of_ten(digits - 1);
+                for (int i = 0; i < magnitude; ++i) {
+                    if (value > max_double / 10.0) {
+                        value = max_double;
+                        break;
+                    }
+
+                    value *= 10.0;
+                }
+
+                for (int i = 0; i > magnitude && value != 0.0; --i) {
+                    value /= 10.0;
+                }
+            }
+        }
+
+        size_t index = sink.add_node();
+        size_t begin = sink.chars;
+        for (size_t i = start; i < pos; ++i) {
+            sink.put(text[i]);
+        }
+
+        const_json_node& node = sink.node(index);
+        node.type = json_type::number;
+        node.number = negative ? -value : value;
+        node.exact = exact;
+        node.begin = begin;
+        node.size = pos - start;
+        node.next = index + 1;
+        return true;
+    }
+
+    template <typename Sink>
+    static constexpr sizes run(std::string_view text, Sink& sink) {
+        enum class state { value, key, after_value };
+
+        struct frame {
+            size_t node = 0;
+            size_t count = 0;
+            bool is_object = false;
+        };
+
+        frame stack[max_depth] = {};
+        size_t depth = 0;
+        size_t pos = 0;
+        skip_whitespace(text, pos);
+        state current = state::value;
+        while (true) {
+            if (current == state::value) {
+                if (pos >= text.size()) {
+                    return sizes{false, pos, 0, 0};
+                }
+
+                char c = text[pos];
+                if (c == '{' || c == '[') {
+                    bool is_object = c == '{';
+                    if (depth == max_depth) {
+                        return sizes{false, pos, 0, 0};
+                    }
+
+                    size_t index = sink.add_node();
+                    sink.node(index).type = is_object ? json_type::object : json_type::array;
+                    ++pos;
+                    skip_whitespace(text, pos);
+                    if (pos < text.size() && text[pos] == (is_object ? '}' : ']')) {
+                        ++pos;
+                        sink.node(index).next = index + 1;
+                        current = state::after_value;
+                        continue;
+                    }
+
+                    stack[depth++] = frame{index, 0, is_object};
+                    current = is_object ? state::key : state::value;
+                    continue;
+                }
+
+                if (c == '"') {
+                    if (!parse_string(text, pos, sink)) {
+                        return sizes{false, pos, 0, 0};
+                    }
+                }
+                else if (c == '-' || is_digit(c)) {
+                    if (!parse_number(text, pos, sink)) {
+                        return sizes{false, pos, 0, 0};
+                    }
+                }
+                else if (keyword(text, pos, "true") || keyword(text, pos, "false")) {
+                    bool value = c == 't';
+                    size_t index = sink.add_node();
+                    const_json_node& node = sink.node(index);
+                    node.type = json_type::boolean;
+                    node.boolean = value;
+                    node.next = index + 1;
+                    pos += value ? 4 : 5;
+                }
+                else if (keyword(text, pos, "null")) {
+                    size_t index = sink.add_node();
+                    sink.node(index).next = index + 1;
+                    pos += 4;
+                }
+                else {
+                    return sizes{false, pos, 0, 0};
+                }
+
+                current = state::after_value;
+            }
+            else if (current == state::key) {
+                if (pos >= text.size() || text[pos] != '"' || !parse_string(text, pos, sink)) {
+                    return sizes{false, pos, 0, 0};
+                }
+
+                skip_whitespace(text, pos);
+                if (pos >= text.size() || text[pos] != ':') {
+                    return sizes{false, pos, 0, 0};
+                }
+
+                ++pos;
+                skip_whitespace(text, pos);
+                current = state::value;
+            }
+            else {
+                skip_whitespace(text, pos);
+                if (depth == 0) {
+                    if (pos != text.size()) {
+                        return sizes{false, pos, 0, 0};
+                    }
+
+                    return sizes{true, 0, sink.nodes, sink.chars};
+                }
+
+                frame& top = stack[depth - 1];
+                ++top.count;
+                if (pos < text.size() && text[pos] == ',') {
+                    ++pos;
+                    skip_whitespace(text, pos);
+                    current = top.is_object ? state::key : state::value;
+                    continue;
+                }
+
+                if (pos < text.size() && text[pos] == (top.is_object ? '}' : ']')) {
+                    ++pos;
+                    const_json_node& node = sink.node(top.node);
+                    node.size = top.count;
+                    node.next = sink.nodes;
+                    --depth;
+                    continue;
+                }
+
+                return sizes{false, pos, 0, 0};
+            }
+        }
+    }
+};
+
+// Validates and lays out a JSON string literal at compile time, evaluating
+// to a const_json_view of a static document. Malformed JSON is a compile
+// error.
+#define JSON_LITERAL(text)                                                                        \
+    ([]() -> const_json_view {                                                                    \
+        constexpr const_json::sizes json_literal_sizes = const_json::measure(text);               \
+        static_assert(json_literal_sizes.ok, "Malformed JSON literal");                           \
+        static constexpr auto json_literal_document =                                             \
+            const_json::compile<json_literal_sizes.nodes, json_literal_sizes.chars>(text);        \
+        return json_literal_document.root();                                                      \
+    }())
+
+#endif // CONST_JSON_HPP
@@ -0,0 +1,118 @@
+#ifndef TAPE_HPP
+#define TAPE_HPP
+
+#include "../types/json_value.hpp"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Flat on-disk layout of a document that can be memory mapped and queried
+// without deserialization. The file holds a header, a tape of 64-bit words,
+// a pool of doubles and a pool of length-prefixed strings, all in native
+// byte order. Each word carries a type tag in its top byte and a payload
+// in the remaining 56 bits:
+//   null/false/true  no payload
+//   number           index into the number pool
+//   string           byte offset into the string pool
+//   array            tape index of a record: count, then one word per element
+//   object           tape index of a record: count, then (key, value) word
+//                    pairs sorted by key so lookups are a binary search
+// A child record always follows the record that refers to it, which the
+// reader checks, so a corrupt tape cannot refer back to an enclosing
+// container and loop.
+class tape_writer {
+public:
+    tape_writer(const json_value& root);
+
+    void write(std::vector<std::uint8_t>& out) const;
+    void write_file(const std::string& file_path) const;
+
+private:
+    std::vector<std::uint64_t> tape_;
+    std::vector<double> numbers_;
+    std::string strings_;
+    std::unordered_map<std::string, std::uint64_t> string_offsets_;
+    std::uint64_t root_;
+
+    std::uint64_t emit(const json_value& value);
+    std::uint64_t emit_string(const std::string& value);
+};
+
+class tape_document;
+
+class tape_view {
+public:
+    json_type type() const;
+    bool is_null() const;
+    bool is_boolean() const;
+    bool is_number() const;
+    bool is_string() const;
+    bool is_array() const;
+    bool is_object() const;
+
+    bool as_boolean() const;
+    double as_number() const;
+    std::string_view as_string() const;
+
+    size_t size() const;
+    tape_view operator[](size_t index) const;
+    tape_view operator[](std::string_view key) const;
+    bool contains(std::string_view key) const;
+    std::string_view key_at(size_t index) const;
+    tape_view value_at(size_t index) const;
+
+    json_value to_value() const;
+
+private:
+    friend class tape_document;
+
+    tape_view(const tape_document& doc, std::uint64_t word);
+
+    const tape_document* doc_;
+    std::uint64_t word_;
+
+    std::uint64_t payload() const;
+    const std::uint64_t* record() const;
+    // View of a word of this container's record, rejecting containers
+    // that do not follow it
+    tape_view child(const std::uint64_t* rec, std::uint64_t word) const;
+    json_value to_value(size_t depth) const;
+    bool find(std::string_view key, std::uint64_t& word) const;
+};
+
+class tape_document {
+public:
+    static tape_document open(const std::string& file_path);
+
+    tape_document(const std::uint8_t* data, size_t size);
+    tape_document(const tape_document&) = delete;
+    tape_document(tape_document&& other) noexcept;
+    tape_document& operator=(const tape_document&) = delete;
+    tape_document& operator=(tape_document&& other) noexcept;
+    ~tape_document();
+
+    tape_view root() const;
+
+private:
+    friend class tape_view;
+
+    tape_document();
+
+    void* mapping_;
+    size_t mapping_size_;
+    const std::uint64_t* tape_;
+    std::uint64_t tape_count_;
+    const double* numbers_;
+    std::uint64_t numbers_count_;
+    const char* strings_;
+    std::uint64_t strings_size_;
+    std::uint64_t root_;
+
+    void load(const std::uint8_t* data, size_t size);
+    void unmap();
+    std::string_view string_at(std::uint64_t offset) const;
+};
+
+#endif // TAPE_HPP
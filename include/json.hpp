@@ -8,26 +8,43 @@
 #include "types/json_string.hpp"
 #include "types/json_array.hpp"
 #include "types/json_object.hpp"
+#include "parser/parse_options.hpp"
+#include "parser/parse_result.hpp"
+#include <cstdint>
 #include <string>
+#include <vector>
 
 class json {
 public:
     json();
-    json(const std::string& file_path);
+    json(const std::string& file_path, const parse_options& options = parse_options());
     json(const json& other);
     json(json&& other) noexcept;
     json& operator=(const json& other);
     json& operator=(json&& other) noexcept;
 
-    static json parse(const std::string& json_string);
+    static json parse(const std::string& json_string, const parse_options& options = parse_options());
+    static parse_result try_parse(const std::string& json_string, const parse_options& options = parse_options()) noexcept;
+    // Reuse target's existing storage instead of building a fresh tree
+    static void parse_into(json& target, const std::string& json_string, const parse_options& options = parse_options());
+    static parse_result try_parse_into(json& target, const std::string& json_string, const parse_options& options = parse_options()) noexcept;
+    // Checks that data would parse, with the same error and offset, without
+    // building a tree or allocating (see json_validator)
+    static parse_status validate(const char* data, size_t size, const parse_options& options = parse_options()) noexcept;
     static json object();
     static json array();
+    // Throws std::runtime_error on malformed input or nesting deeper than
+    // options.max_depth
+    static json from_cbor(const std::vector<std::uint8_t>& data, const parse_options& options = parse_options());
 
     json_value& get_json();
     const json_value& get_json() const;
 
-    std::string get_context(int indent = -1) const;
+    // memoize: see json_value::dump_to
+    std::string get_context(int indent = -1, bool ascii_only = false, bool memoize = false) const;
     void write_file(const std::string& file_path, int indent = 2) const;
+    std::vector<std::uint8_t> to_cbor() const;
+    void write_tape(const std::string& file_path) const;
 
 private:
     json_value json_data_;
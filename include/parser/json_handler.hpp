@@ -0,0 +1,31 @@
+#ifndef JSON_HANDLER_HPP
+#define JSON_HANDLER_HPP
+
+#include "parse_result.hpp"
+#include <string>
+
+// Receives the events of a parse in document order. String arguments refer
+// to the lexer's buffers and may be moved from. Returning false stops the
+// parse; failure() then supplies the reported error.
+class json_handler {
+public:
+    virtual ~json_handler() = default;
+
+    virtual bool null_value() = 0;
+    virtual bool boolean_value(bool value) = 0;
+    virtual bool number_value(std::string& lexeme) = 0;
+    virtual bool string_value(std::string& value) = 0;
+    virtual bool begin_object() = 0;
+    virtual bool key(std::string& key) = 0;
+    virtual bool end_object() = 0;
+    virtual bool begin_array() = 0;
+    virtual bool end_array() = 0;
+
+    // With parse_options::preserve_source, called after each end_object()
+    // or end_array() with the byte range the container spans in the input
+    virtual void container_source(size_t begin, size_t end);
+
+    virtual parse_error failure() const;
+};
+
+#endif // JSON_HANDLER_HPP
@@ -0,0 +1,50 @@
+#ifndef JSON_VALIDATOR_HPP
+#define JSON_VALIDATOR_HPP
+
+#include "parse_options.hpp"
+#include "parse_result.hpp"
+#include <cstddef>
+#include <cstdint>
+
+// Checks that text is a JSON document the parser would accept with the same
+// options, reporting the same error and offset, without building anything
+// or allocating. Nesting is tracked in fixed arrays, so documents nested
+// deeper than max_nesting fail with depth_limit_exceeded whatever
+// options.max_depth allows.
+class json_validator {
+public:
+    static constexpr size_t max_nesting = 1024;
+
+    json_validator(const char* data, size_t size, const parse_options& options = parse_options());
+
+    parse_status run();
+
+private:
+    enum class token_type : std::uint8_t {
+        l_brace, r_brace, l_bracket, r_bracket, colon, comma,
+        string, number, literal, end, error
+    };
+
+    const char* data_;
+    size_t size_;
+    size_t pos_;
+    parse_options options_;
+    token_type type_;
+    size_t offset_;
+    parse_status status_;
+    // One bit per open container, set for objects, and its element count
+    std::uint64_t objects_[max_nesting / 64];
+    size_t counts_[max_nesting];
+
+    bool next_token();
+    void scan_string();
+    bool scan_unicode_escape(size_t& length);
+    bool scan_hex4(std::uint32_t& value);
+    void scan_number();
+    void scan_keyword();
+    bool finite_number(size_t start) const;
+    void fail_token(parse_error error, size_t offset);
+    parse_status fail(parse_error error);
+};
+
+#endif // JSON_VALIDATOR_HPP
@@ -1,34 +1,49 @@
 #ifndef LEXER_HPP
 #define LEXER_HPP
 
+#include "parse_options.hpp"
+#include "parse_result.hpp"
 #include <string>
-#include <stdexcept>
-#include <cctype>
+#include <cstdint>
 
+// Errors never throw: an error token is returned and the reason and byte
+// offset are available through error() and error_offset().
 class lexer {
 public:
     enum class token_type {
         l_brace, r_brace, l_bracket, r_bracket, colon, comma,
-        string, number, true_val, false_val, null, end
+        string, number, true_val, false_val, null, end, error
     };
 
     struct token {
         token_type type;
         std::string value;
+        size_t offset;
     };
 
-    lexer(const std::string& input);
+    lexer(const std::string& input, const parse_options& options = parse_options());
     token next_token();
+    void next_token(token& tok);
+
+    parse_error error() const;
+    size_t error_offset() const;
 
 private:
     const std::string& input_;
     size_t pos_;
-    
+    bool validate_utf8_;
+    size_t max_string_length_;
+    parse_error error_;
+    size_t error_offset_;
+
     char peek() const;
     char consume();
     void skip_whitespace();
-    token lex_string();
-    token lex_number();
-    token lex_keyword();
+    void lex_string(token& tok);
+    bool lex_unicode_escape(std::uint32_t& code_point);
+    bool lex_hex4(std::uint32_t& value);
+    void lex_number(token& tok);
+    void lex_keyword(token& tok);
+    void fail(token& tok, parse_error error, size_t offset);
 };
-#endif // LEXER_HPP
\ No newline at end of file
+#endif // LEXER_HPP
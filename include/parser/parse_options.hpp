@@ -0,0 +1,35 @@
+#ifndef PARSE_OPTIONS_HPP
+#define PARSE_OPTIONS_HPP
+
+#include <cstddef>
+#include <limits>
+
+struct parse_options {
+    // Reject strings that are not well-formed UTF-8
+    bool validate_utf8 = true;
+
+    // Store arrays made only of numbers or only of booleans as packed
+    // buffers (see json_array::get_packing)
+    bool pack_arrays = true;
+
+    // Keep a copy of the input and record the text of every array and
+    // object, so that compact dumps copy unmodified containers verbatim
+    // (see json_array::source)
+    bool preserve_source = false;
+
+    // Store numbers as their text and convert them on first read. Dumps
+    // write the text unchanged; arrays of numbers are not packed.
+    bool lazy_numbers = false;
+
+    // Share structurally equal subtrees and scalars of the result (see
+    // json_interner)
+    bool deduplicate = false;
+
+    // Limits protecting against hostile input; exceeding one fails the parse
+    size_t max_depth = 1000;
+    size_t max_document_size = std::numeric_limits<size_t>::max();
+    size_t max_string_length = std::numeric_limits<size_t>::max();
+    size_t max_container_elements = std::numeric_limits<size_t>::max();
+};
+
+#endif // PARSE_OPTIONS_HPP
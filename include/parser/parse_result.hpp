@@ -0,0 +1,76 @@
+#ifndef PARSE_RESULT_HPP
+#define PARSE_RESULT_HPP
+
+#include "../types/json_value.hpp"
+#include <string>
+#include <string_view>
+
+enum class parse_error {
+    none,
+    unexpected_end,
+    invalid_character,
+    invalid_keyword,
+    invalid_number,
+    invalid_escape,
+    invalid_unicode_escape,
+    invalid_utf8,
+    control_character,
+    unterminated_string,
+    expected_value,
+    expected_key,
+    expected_colon,
+    expected_comma_or_brace,
+    expected_comma_or_bracket,
+    trailing_content,
+    depth_limit_exceeded,
+    document_too_large,
+    string_too_long,
+    too_many_elements,
+    rejected_by_handler,
+    schema_violation,
+    out_of_memory
+};
+
+const char* parse_error_message(parse_error error);
+
+// Outcome of a check that builds no value (see json::validate): only the
+// error code and the byte offset it was found at
+struct parse_status {
+    parse_error error = parse_error::none;
+    size_t offset = 0;
+
+    bool ok() const { return error == parse_error::none; }
+    explicit operator bool() const { return ok(); }
+    const char* message() const { return parse_error_message(error); }
+};
+
+// Outcome of a non-throwing parse. On failure only the error code and byte
+// offset are recorded; line() and column() are derived on demand from the
+// input, which must still be alive when they are called.
+class parse_result {
+public:
+    parse_result();
+    parse_result(json_value&& value);
+    parse_result(parse_error error, size_t offset, std::string_view input);
+
+    bool ok() const;
+    explicit operator bool() const;
+
+    parse_error error() const;
+    const char* message() const;
+    size_t offset() const;
+    size_t line() const;
+    size_t column() const;
+    std::string describe() const;
+
+    json_value& value();
+    const json_value& value() const;
+
+private:
+    json_value value_;
+    parse_error error_;
+    size_t offset_;
+    std::string_view input_;
+};
+
+#endif // PARSE_RESULT_HPP
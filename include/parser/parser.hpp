@@ -2,25 +2,52 @@
 #define PARSER_HPP
 
 #include "lexer.hpp"
+#include "json_handler.hpp"
+#include "parse_result.hpp"
 #include "../types/json_value.hpp"
+#include <memory>
+#include <vector>
 
+// Non-recursive parser: nesting is tracked on an explicit stack, so deep
+// documents cost heap rather than call stack and are bounded by the
+// limits in parse_options.
 class parser {
 public:
-    parser(const std::string& input);
+    parser(const std::string& input, const parse_options& options = parse_options());
+
+    // Throws std::runtime_error describing the first error
     json_value parse();
+    // Reports errors through the result instead of throwing
+    parse_result try_parse() noexcept;
+    // Streams events to handler without building a tree. An exception
+    // thrown by the handler is reported as rejected_by_handler, except
+    // std::bad_alloc and std::length_error, reported as out_of_memory.
+    parse_result try_parse(json_handler& handler) noexcept;
+    // Overwrite target in place, reusing its nodes and buffers. On failure
+    // target holds a valid but partially updated tree.
+    void parse_into(json_value& target);
+    parse_result try_parse_into(json_value& target) noexcept;
 
 private:
+    struct frame {
+        bool is_object;
+        size_t count;
+        size_t begin;
+    };
+
+    const std::string& input_;
+    parse_options options_;
     lexer lexer_;
     lexer::token current_token_;
+    std::vector<frame> stack_;
+    parse_error error_;
+    size_t error_offset_;
 
-    void next_token();
-    json_value parse_value();
-    json_value parse_object();
-    json_value parse_array();
-    json_value parse_string();
-    json_value parse_number();
-    json_value parse_boolean();
-    json_value parse_null();
+    bool next_token();
+    bool fail(parse_error error);
+    bool reject(const json_handler& handler);
+    std::shared_ptr<const std::string> retained_input() const;
+    bool run(json_handler& handler);
 };
 
 #endif // PARSER_HPP
@@ -0,0 +1,105 @@
+#ifndef TREE_BUILDER_HPP
+#define TREE_BUILDER_HPP
+
+#include "json_handler.hpp"
+#include "parse_options.hpp"
+#include "../types/json_value.hpp"
+#include "../types/json_array.hpp"
+#include "../types/object_shape.hpp"
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+// Handler that assembles parse events into a json_value tree. With reuse
+// set, the tree already in root is overwritten in place: nodes whose type
+// matches keep their storage, array tails and stale object keys are
+// dropped at the end of each container. With pack_arrays set, scalars of
+// the innermost array are buffered until it turns out to be homogeneous
+// (stored packed) or not (buffered values are placed as usual). With
+// lazy_numbers set, numbers keep their lexeme instead, and with deduplicate
+// set the finished tree is interned. Given the input, each container
+// records the text it was parsed from.
+//
+// New objects are shaped: the members of an open object are staged on a
+// stack, and when it closes, objects with the same keys in the same order
+// share one object_shape. Objects with repeated keys, very many keys or
+// keys in too many different orders are built standalone.
+class tree_builder : public json_handler {
+public:
+    tree_builder(json_value& root, bool reuse = false, const parse_options& options = parse_options(),
+                 std::shared_ptr<const std::string> input = nullptr);
+
+    bool null_value() override;
+    bool boolean_value(bool value) override;
+    bool number_value(std::string& lexeme) override;
+    bool string_value(std::string& value) override;
+    bool begin_object() override;
+    bool key(std::string& key) override;
+    bool end_object() override;
+    bool begin_array() override;
+    bool end_array() override;
+    void container_source(size_t begin, size_t end) override;
+
+    parse_error failure() const override;
+
+private:
+    struct frame {
+        json_array* arr;
+        json_object* obj;
+        size_t index;
+        size_t touched_begin;
+        bool packable;
+        json_array::packing packed;
+        // Shape of the members staged so far from members_begin, or npos
+        // for an object built standalone
+        size_t shape;
+        size_t members_begin;
+    };
+
+    // Node 0 is the empty object and every other node extends its parent
+    // by one key; the object_shape is only built once an object closes on
+    // the node
+    struct shape_node {
+        std::string key;
+        size_t parent;
+        size_t size;
+        // The key already appears among the parent's
+        bool repeated;
+        std::unordered_map<std::string, size_t> transitions;
+        std::shared_ptr<const object_shape> shape;
+    };
+
+    json_value& root_;
+    bool reuse_;
+    bool pack_arrays_;
+    bool lazy_numbers_;
+    bool deduplicate_;
+    std::shared_ptr<const std::string> input_;
+    // The container most recently closed, for container_source
+    json_array* closed_array_;
+    json_object* closed_object_;
+    std::vector<frame> stack_;
+    std::vector<const json_value*> touched_;
+    std::vector<double> pending_numbers_;
+    std::vector<std::uint8_t> pending_booleans_;
+    std::string key_;
+    std::vector<shape_node> shapes_;
+    std::vector<json_value> members_;
+    parse_error failure_;
+
+    void store_number(double value);
+    void store_boolean(bool value);
+    void store_lexeme(std::string& lexeme);
+    bool pack(json_array::packing kind);
+    void flush_pending();
+    json_value& place(json_value&& value);
+    json_value& next_slot();
+    void trim_object(const frame& top);
+    void finish_container();
+    size_t advance(size_t shape);
+    std::shared_ptr<const object_shape> shape_of(size_t shape);
+    void unstage(frame& top);
+};
+
+#endif // TREE_BUILDER_HPP
@@ -0,0 +1,129 @@
+#ifndef JSON_PATH_HPP
+#define JSON_PATH_HPP
+
+#include "../types/json_value.hpp"
+#include "../parser/parse_options.hpp"
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// A JSONPath query (RFC 9535) compiled into a plan of segments and
+// selectors, so it is parsed once and then run against any number of
+// documents.
+//
+// Supports name, wildcard, index, slice and filter selectors, unions and
+// descendant segments. Filters compare singular queries relative to @ or $
+// with literals or each other, test for existence and combine with &&, ||
+// and !. Function extensions such as length() are not supported.
+class json_path {
+public:
+    // Throws std::runtime_error if expression is not a valid query
+    json_path(std::string_view expression);
+
+    // Matches in document order, pointing into root; nothing is copied
+    std::vector<const json_value*> select(const json_value& root) const;
+    // Appends the matches to out, so its storage can be reused
+    void select(const json_value& root, std::vector<const json_value*>& out) const;
+
+    // Runs the query while text is parsed, without building the document
+    // (see path_matcher). Each match is built on its own and passed to
+    // on_match, valid for the duration of the call. Throws
+    // std::runtime_error if text is not valid JSON or the query refers to
+    // the root from a filter, which needs the whole document. An exception
+    // thrown by on_match stops the parse and propagates from stream().
+    void stream(const std::string& text, const std::function<void(const json_value&)>& on_match,
+                const parse_options& options = parse_options()) const;
+    bool streams() const;
+
+private:
+    friend class path_matcher;
+
+    enum class selector_kind : std::uint8_t {
+        name,
+        wildcard,
+        index,
+        slice,
+        filter
+    };
+
+    struct selector {
+        selector_kind kind = selector_kind::wildcard;
+        std::string name;
+        // index doubles as the slice start; has_start and has_end mark the
+        // slice bounds that were given
+        long long index = 0;
+        long long end = 0;
+        long long step = 1;
+        bool has_start = false;
+        bool has_end = false;
+        size_t filter = 0;
+    };
+
+    struct segment {
+        bool descendant = false;
+        std::vector<selector> selectors;
+    };
+
+    struct query {
+        bool absolute = true;
+        std::vector<segment> segments;
+    };
+
+    enum class condition_kind : std::uint8_t {
+        any,
+        all,
+        negation,
+        exists,
+        compare
+    };
+
+    enum class compare_op : std::uint8_t {
+        equal,
+        not_equal,
+        less,
+        less_equal,
+        greater,
+        greater_equal
+    };
+
+    // Either a literal or a singular query
+    struct operand {
+        bool is_query = false;
+        json_value literal;
+        query path;
+    };
+
+    // Filter expressions as a table; left and right are condition indices
+    struct condition {
+        condition_kind kind = condition_kind::exists;
+        compare_op op = compare_op::equal;
+        size_t left = 0;
+        size_t right = 0;
+        query path;
+        operand lhs;
+        operand rhs;
+    };
+
+    class compiler;
+
+    query plan_;
+    std::vector<condition> conditions_;
+    bool uses_root_;
+
+    void run(const query& q, size_t first, const json_value& start, const json_value& root,
+             std::vector<const json_value*>& out) const;
+    void apply(const segment& s, const json_value& node, const json_value& root,
+               std::vector<const json_value*>& out) const;
+    void apply(const selector& s, const json_value& node, const json_value& root,
+               std::vector<const json_value*>& out) const;
+    bool test(size_t index, const json_value& current, const json_value& root) const;
+    const json_value* resolve(const operand& o, const json_value& current, const json_value& root) const;
+
+    // Used by path_matcher to decide selectors from a key or position alone
+    static bool matches(const selector& s, bool is_object, std::string_view key, size_t position);
+    static bool needs_length(const selector& s);
+};
+
+#endif // JSON_PATH_HPP
@@ -0,0 +1,101 @@
+#ifndef PATH_MATCHER_HPP
+#define PATH_MATCHER_HPP
+
+#include "json_path.hpp"
+#include "../parser/json_handler.hpp"
+#include "../parser/tree_builder.hpp"
+#include <exception>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Handler that runs a json_path over parse events. The plan is tracked as
+// a set of states per open container, advanced by each key and position;
+// containers no state applies to are skipped without building anything.
+//
+// A value is built into a tree only when it matches, when a filter has to
+// see it, or when it is an array whose selectors need its length (negative
+// indices and slices); the rest of the plan then runs over that tree.
+// Matches inside a built value are reported right after it, so with
+// descendant segments the order can differ from json_path::select(). A
+// value reached along several routes through the plan is reported once per
+// route, as select() reports it.
+class path_matcher : public json_handler {
+public:
+    // Throws std::runtime_error if the query does not stream
+    path_matcher(const json_path& path, std::function<void(const json_value&)> on_match,
+                 const parse_options& options = parse_options());
+
+    bool null_value() override;
+    bool boolean_value(bool value) override;
+    bool number_value(std::string& lexeme) override;
+    bool string_value(std::string& value) override;
+    bool begin_object() override;
+    bool key(std::string& key) override;
+    bool end_object() override;
+    bool begin_array() override;
+    bool end_array() override;
+
+    parse_error failure() const override;
+
+    // The exception on_match threw, which stopped the parse, if any
+    std::exception_ptr exception() const;
+
+private:
+    // A plan state and the number of routes by which the value reached it
+    struct state_count {
+        size_t state;
+        size_t count;
+    };
+
+    // A filter selector (segment and selector index) the value still has
+    // to pass
+    struct pending_filter {
+        size_t segment;
+        size_t selector;
+        size_t count;
+    };
+
+    // A streamed container; the states active on it are the tail of
+    // states_ from states_begin
+    struct frame {
+        bool is_object;
+        size_t count;
+        size_t states_begin;
+    };
+
+    const json_path& path_;
+    std::function<void(const json_value&)> on_match_;
+    std::vector<frame> stack_;
+    std::vector<state_count> states_;
+    std::string key_;
+    size_t skip_depth_;
+
+    // States for the value about to start, and the filters it still has
+    // to pass
+    std::vector<state_count> next_;
+    std::vector<pending_filter> pending_;
+
+    // The value being built
+    json_value capture_;
+    tree_builder builder_;
+    size_t capture_depth_;
+    std::vector<state_count> capture_states_;
+    std::vector<pending_filter> capture_pending_;
+    std::vector<const json_value*> matches_;
+    parse_error failure_;
+    std::exception_ptr exception_;
+
+    bool start_value();
+    bool start_scalar();
+    bool finish_scalar(bool accepted);
+    bool begin_container(bool is_object);
+    bool end_container(bool is_object);
+    bool accept(bool accepted);
+    bool finish_capture();
+    void report(const json_value& match, size_t count);
+    void finish_value();
+};
+
+#endif // PATH_MATCHER_HPP
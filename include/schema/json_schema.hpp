@@ -0,0 +1,164 @@
+#ifndef JSON_SCHEMA_HPP
+#define JSON_SCHEMA_HPP
+
+#include "../types/json_value.hpp"
+#include "../parser/parse_options.hpp"
+#include "schema_pattern.hpp"
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// First violation found by a json_schema, with the JSON Pointer of the
+// offending value
+class validation_result {
+public:
+    validation_result();
+    validation_result(std::string path, std::string message);
+
+    bool ok() const;
+    explicit operator bool() const;
+
+    const std::string& path() const;
+    const std::string& message() const;
+    std::string describe() const;
+
+private:
+    bool ok_;
+    std::string path_;
+    std::string message_;
+};
+
+// A JSON Schema compiled into a table with one node per subschema, its
+// keywords decoded into plain fields and every $ref resolved to a node.
+//
+// Supports type, enum, const, the numeric, string, array and object
+// assertions, allOf, anyOf, oneOf, not, if/then/else and references within
+// the schema document, in the spellings of drafts 4 to 2020-12. format,
+// annotations and unknown keywords are ignored; keywords that need dynamic
+// scopes or other documents throw.
+class json_schema {
+public:
+    // Throws std::runtime_error if schema is not a valid schema
+    json_schema(const json_value& schema);
+
+    validation_result validate(const json_value& instance) const;
+
+    // Validate while parsing and stop at the first violation (see
+    // schema_validator). parse() also builds the tree and throws
+    // std::runtime_error describing invalid JSON or the violation;
+    // validate_text() builds nothing and reports invalid JSON as a
+    // violation at the root.
+    json_value parse(const std::string& text, const parse_options& options = parse_options()) const;
+    validation_result validate_text(const std::string& text, const parse_options& options = parse_options()) const;
+
+private:
+    friend class schema_validator;
+
+    static constexpr size_t none = std::numeric_limits<size_t>::max();
+
+    enum type_bits : std::uint8_t {
+        null_type = 1,
+        boolean_type = 2,
+        integer_type = 4,
+        number_type = 8,
+        string_type = 16,
+        array_type = 32,
+        object_type = 64,
+        any_type = 127
+    };
+
+    struct scalar {
+        json_type type;
+        bool boolean;
+        double number;
+        std::string_view text;
+    };
+
+    // Subschemas are node indices, none where the keyword is absent
+    struct node {
+        bool never = false;
+        std::uint8_t types = any_type;
+        bool has_enum = false;
+        std::vector<json_value> enum_values;
+
+        double minimum = -std::numeric_limits<double>::infinity();
+        double maximum = std::numeric_limits<double>::infinity();
+        bool exclusive_minimum = false;
+        bool exclusive_maximum = false;
+        double multiple_of = 0.0;
+
+        size_t min_length = 0;
+        size_t max_length = none;
+        size_t pattern = none;
+
+        std::vector<size_t> prefix_items;
+        size_t items = none;
+        size_t min_items = 0;
+        size_t max_items = none;
+        bool unique_items = false;
+        size_t contains = none;
+        size_t min_contains = 1;
+        size_t max_contains = none;
+
+        std::unordered_map<std::string, size_t> properties;
+        std::vector<std::pair<size_t, size_t>> pattern_properties;
+        size_t additional_properties = none;
+        size_t property_names = none;
+        std::vector<std::string> required;
+        std::unordered_map<std::string, size_t> required_index;
+        size_t min_properties = 0;
+        size_t max_properties = none;
+        std::vector<std::pair<std::string, std::vector<std::string>>> dependent_required;
+        std::vector<std::pair<std::string, size_t>> dependent_schemas;
+
+        // $ref targets are applied like allOf members
+        std::vector<size_t> all_of;
+        std::vector<size_t> any_of;
+        std::vector<size_t> one_of;
+        size_t not_schema = none;
+        size_t if_schema = none;
+        size_t then_schema = none;
+        size_t else_schema = none;
+
+        // A container can be checked while its elements stream past unless
+        // a keyword needs the whole value at once
+        bool streams = true;
+    };
+
+    struct compilation;
+
+    std::vector<node> nodes_;
+    std::vector<schema_pattern> patterns_;
+    size_t root_;
+
+    size_t compile(const json_value& schema, const std::string& pointer, compilation& state);
+    size_t resolve(const std::string& ref, compilation& state);
+    void check_cycles() const;
+
+    bool check(size_t index, const json_value& value, std::string& path, validation_result* result) const;
+    bool check_scalar(size_t index, const scalar& value, const std::string& path, validation_result* result) const;
+    bool check_array(size_t index, const json_value& value, std::string& path, validation_result* result) const;
+    bool check_object(size_t index, const json_value& value, std::string& path, validation_result* result) const;
+    template <typename Evaluate>
+    bool check_applicators(const node& n, Evaluate evaluate, const std::string& path,
+                           validation_result* result) const;
+
+    // Used by schema_validator to check containers as they stream past
+    void children(size_t index, bool is_object, const std::string& key, size_t position,
+                  std::vector<size_t>& out) const;
+    void expand(size_t index, std::vector<size_t>& out) const;
+    bool check_open(size_t index, bool is_object, const std::string& path, validation_result* result) const;
+    // seen flags the required properties present, or is null to skip them
+    bool check_close(size_t index, bool is_object, size_t count, const std::uint8_t* seen,
+                     const std::string& path, validation_result* result) const;
+
+    // JSON Pointer reference tokens
+    static void append_key(std::string& path, std::string_view key);
+    static void append_index(std::string& path, size_t index);
+};
+
+#endif // JSON_SCHEMA_HPP
@@ -0,0 +1,56 @@
+#ifndef SCHEMA_PATTERN_HPP
+#define SCHEMA_PATTERN_HPP
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// A regular expression of a JSON Schema pattern keyword (ECMA-262 syntax),
+// compiled to an automaton that is run over all its states at once. Time
+// is linear in the subject and no backtracking or recursion takes place,
+// so untrusted strings cannot exhaust the stack or run away.
+//
+// Supports literals, ., classes, the \d \w \s \b escapes and their
+// negations, character escapes, groups, alternation, anchors and all
+// quantifiers (lazy ones match the same strings). Subjects and patterns
+// are matched by code point. Backreferences, lookaround and property
+// escapes throw std::runtime_error from the constructor, as does
+// malformed syntax.
+class schema_pattern {
+public:
+    schema_pattern(std::string_view source);
+
+    // Whether the pattern matches anywhere in text
+    bool search(std::string_view text) const;
+
+private:
+    using range = std::pair<std::uint32_t, std::uint32_t>;
+
+    enum class op : std::uint8_t {
+        character,
+        split,
+        jump,
+        line_begin,
+        line_end,
+        word_boundary,
+        not_word_boundary,
+        match
+    };
+
+    struct instruction {
+        op kind;
+        // Class index for character, targets for split and jump
+        size_t x;
+        size_t y;
+    };
+
+    class compiler;
+
+    std::vector<instruction> program_;
+    // Sorted, disjoint code point ranges of each class
+    std::vector<std::vector<range>> classes_;
+};
+
+#endif // SCHEMA_PATTERN_HPP
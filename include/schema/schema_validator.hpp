@@ -0,0 +1,79 @@
+#ifndef SCHEMA_VALIDATOR_HPP
+#define SCHEMA_VALIDATOR_HPP
+
+#include "json_schema.hpp"
+#include "../parser/json_handler.hpp"
+#include "../parser/tree_builder.hpp"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Handler that validates parse events against a json_schema and passes
+// them on to next, if given. A violation stops the parse with
+// parse_error::schema_violation at the offending token, and result()
+// describes it.
+//
+// Scalars are checked as they arrive and containers as their members
+// stream past, with counts and required properties checked when they
+// close. A container whose schema needs the whole value (anyOf, oneOf,
+// not, if, enum, const, uniqueItems, contains, dependencies) is collected
+// into a tree and checked when it closes.
+class schema_validator : public json_handler {
+public:
+    schema_validator(const json_schema& schema, json_handler* next = nullptr);
+
+    bool null_value() override;
+    bool boolean_value(bool value) override;
+    bool number_value(std::string& lexeme) override;
+    bool string_value(std::string& value) override;
+    bool begin_object() override;
+    bool key(std::string& key) override;
+    bool end_object() override;
+    bool begin_array() override;
+    bool end_array() override;
+    void container_source(size_t begin, size_t end) override;
+
+    parse_error failure() const override;
+    const validation_result& result() const;
+
+private:
+    // A streamed container; its nodes and required flags are the tails of
+    // active_ and seen_ from the given offsets
+    struct frame {
+        bool is_object;
+        size_t count;
+        size_t active_begin;
+        size_t seen_begin;
+        size_t path_length;
+    };
+
+    const json_schema& schema_;
+    json_handler* next_;
+    std::vector<frame> stack_;
+    std::vector<size_t> active_;
+    std::vector<std::uint8_t> seen_;
+    std::vector<size_t> applying_;
+    std::vector<size_t> expanded_;
+    std::string key_;
+    std::string path_;
+
+    // Collects a container that cannot be streamed
+    json_value buffer_;
+    std::unique_ptr<tree_builder> builder_;
+    size_t buffer_depth_;
+    std::vector<size_t> buffered_;
+
+    validation_result result_;
+    parse_error failure_;
+
+    bool check_scalar(const json_schema::scalar& value);
+    bool begin_container(bool is_object);
+    bool end_container(bool is_object);
+    bool buffered(bool accepted);
+    void start_value();
+    void finish_value();
+    bool violation();
+};
+
+#endif // SCHEMA_VALIDATOR_HPP
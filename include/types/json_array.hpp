@@ -2,16 +2,54 @@
 #define JSON_ARRAY_HPP
 
 #include "json_value.hpp"
+#include "source_text.hpp"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string_view>
 #include <vector>
 
 class json_object;
-
+struct dump_cache;
+
+// Arrays holding only numbers or only booleans can be stored packed, one
+// double or byte per element instead of one json_value each. Packed arrays
+// behave like any other array. Const access that hands out references to
+// elements (operator[], at, iteration, get_values) builds a json_value
+// mirror of the buffer once and keeps it until the array is modified;
+// element(), numbers() and booleans() read the buffer itself, as dumps,
+// hashes, comparisons and the encoders do. Mutation converts the array
+// back to the generic representation.
 class json_array {
 public:
     using array = std::vector<json_value>;
     using iterator = array::iterator;
     using const_iterator = array::const_iterator;
 
+    enum class packing {
+        none,
+        numbers,
+        booleans
+    };
+
+    // Read-only view of a packed buffer
+    template <typename T>
+    class span {
+    public:
+        span(const T* data, size_t size) : data_(data), size_(size) {}
+
+        const T* data() const { return data_; }
+        size_t size() const { return size_; }
+        bool empty() const { return size_ == 0; }
+        const T* begin() const { return data_; }
+        const T* end() const { return data_ + size_; }
+        const T& operator[](size_t index) const { return data_[index]; }
+
+    private:
+        const T* data_;
+        size_t size_;
+    };
+
     class json_array_proxy {
     public:
         json_array_proxy(json_array& arr, size_t index);
@@ -35,6 +73,7 @@ public:
 
         json_value& as_value();
         const json_value& as_value() const;
+        std::string_view get_view() const;
 
     private:
         json_array& arr_;
@@ -50,20 +89,33 @@ public:
     json_array& operator=(json_array&& other) noexcept;
 
     std::string dump(int indent = -1, int current_indent = 0) const;
+    // With memoize set, see json_value::dump_to
+    void dump_to(std::string& out, int indent = -1, int current_indent = 0, bool ascii_only = false,
+                 bool memoize = false) const;
 
     const array& get_values() const;
     void add_value(const json_value& value);
     void add_value(json_value&& value);
     json_array_proxy operator[](size_t index);
     const json_value& operator[](size_t index) const;
+    const json_value& at(size_t index) const;
+    // A copy of the element, made from the buffer of a packed array without
+    // building the mirror; throws std::out_of_range past the end
+    json_value element(size_t index) const;
     void set_element(size_t index, const json_value& value);
     void set_element(size_t index, json_value&& value);
+    // Shifts the following elements; throws std::out_of_range past the end
+    json_value& insert(size_t index, json_value&& value);
+    // Removes the element and returns it without copying it
+    json_value extract(size_t index);
 
     size_t size() const;
     bool empty() const;
     void clear();
+    void resize(size_t count);
     void push_back(const json_value& value);
     void push_back(json_value&& value);
+    json_value& emplace_back(json_value&& value);
 
     iterator begin();
     iterator end();
@@ -72,11 +124,77 @@ public:
     const_iterator cbegin() const;
     const_iterator cend() const;
 
+    packing get_packing() const;
+    // Throw std::runtime_error unless the array is packed with that type
+    span<double> numbers() const;
+    span<std::uint8_t> booleans() const;
+    // Replace the contents with a packed buffer; booleans are 0 or 1
+    void assign_numbers(const double* data, size_t count);
+    void assign_booleans(const std::uint8_t* data, size_t count);
+    // Convert to the generic representation
+    void unpack();
+
+    // Structural hash (see json_value::hash). Non-const access can hand
+    // out references that modify elements later, so the result is cached
+    // only while the array is sealed: parsed and copied arrays start sealed,
+    // non-const access unseals, and seal() promises that no reference from
+    // earlier non-const access is used to modify it any more.
+    size_t hash() const;
+    void seal();
+
+    // Text the array was parsed from with parse_options::preserve_source,
+    // written verbatim by compact dumps. Any non-const access clears it.
+    std::string_view source() const;
+    void set_source(source_text text);
+
+    // Changes with every modification through the array's non-const
+    // members, so structures derived from the elements (see array_index)
+    // can tell they are stale. Elements modified through references handed
+    // out earlier are not noticed. Elements below the size the array had at
+    // version v are unchanged as long as last_rewrite() <= v, that is when
+    // only push_back, add_value and emplace_back were called since.
+    std::uint64_t version() const;
+    std::uint64_t last_rewrite() const;
+
     bool operator==(const json_array& other) const;
     bool operator!=(const json_array& other) const;
 
 private:
-    array values_;
+    mutable array values_;
+    packing packing_;
+    std::vector<double> numbers_;
+    std::vector<std::uint8_t> booleans_;
+    // Set once values_ mirrors the packed buffer
+    mutable std::atomic<bool> materialized_;
+    source_text source_;
+    // 0 until computed while sealed
+    mutable std::atomic<size_t> hash_;
+    bool sealed_;
+    // Text of a memoizing dump, only kept while sealed and accessed
+    // atomically by concurrent dumps
+    mutable std::shared_ptr<const dump_cache> dump_;
+    std::uint64_t version_;
+    std::uint64_t rewritten_;
+
+    // Reads and stores dump_
+    friend class json_dumper;
+
+    // Reads and stores hash_
+    friend class json_hasher;
+
+    // Compares children without recursion
+    friend class json_comparer;
+
+    // Replaces elements by equal shared ones, which needs no touch()
+    friend class json_interner;
+
+    // Called by every non-const accessor before handing out mutable access;
+    // append is set by those that only add elements at the end
+    void touch(bool append = false);
+    void rewrite();
+    const array& values() const;
+    void materialize() const;
+    bool element_equals(size_t index, const json_value& value) const;
 };
 
 #endif // JSON_ARRAY_HPP
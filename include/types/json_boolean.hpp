@@ -12,6 +12,7 @@ public:
     json_boolean& operator=(json_boolean&& other) noexcept;
 
     std::string dump(int indent = -1, int current_indent = 0) const;
+    void dump_to(std::string& out, int indent = -1, int current_indent = 0, bool ascii_only = false) const;
 
     bool get_value() const;
 
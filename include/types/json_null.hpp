@@ -12,6 +12,7 @@ public:
     json_null& operator=(json_null&& other) noexcept = default;
 
     std::string dump(int indent = -1, int current_indent = 0) const;
+    void dump_to(std::string& out, int indent = -1, int current_indent = 0, bool ascii_only = false) const;
 
     bool operator==(const json_null& other) const;
     bool operator!=(const json_null& other) const;
@@ -1,25 +1,40 @@
 #ifndef JSON_NUMBER_HPP
 #define JSON_NUMBER_HPP
 
+#include <atomic>
 #include <string>
 
+// A number is either a double or the text it was written as. Text is kept
+// unchanged by dump() and converted on the first get_value(), so digits
+// beyond double precision survive a round trip.
 class json_number {
 public:
     json_number(double value = 0.0);
+    // Throws std::runtime_error if lexeme is not a JSON number
+    static json_number from_lexeme(std::string lexeme);
     json_number(const json_number& other);
     json_number(json_number&& other) noexcept;
     json_number& operator=(const json_number& other);
     json_number& operator=(json_number&& other) noexcept;
 
     std::string dump(int indent = -1, int current_indent = 0) const;
+    void dump_to(std::string& out, int indent = -1, int current_indent = 0, bool ascii_only = false) const;
 
     double get_value() const;
+    // The original text, or empty for numbers constructed from a double
+    const std::string& get_lexeme() const;
+    // Appends value in dump() format
+    static void write(std::string& out, double value);
 
+    // Compares the converted values
     bool operator==(const json_number& other) const;
     bool operator!=(const json_number& other) const;
 
 private:
-    double value_;
+    std::string lexeme_;
+    // NaN until the lexeme is converted (JSON numbers are never NaN);
+    // atomic so concurrent readers may race to fill it
+    mutable std::atomic<double> value_;
 };
 
 #endif // JSON_NUMBER_HPP
@@ -2,17 +2,135 @@
 #define JSON_OBJECT_HPP
 
 #include "json_value.hpp"
+#include "object_shape.hpp"
+#include "source_text.hpp"
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <string_view>
+#include <type_traits>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
+struct dump_cache;
+
+// Objects are either standalone, owning a map from keys to values, or
+// shaped: parsed objects share an object_shape with the other objects of
+// the document that have the same keys in the same order and store only
+// their values, in that order. Replacing values keeps the shape; adding or
+// removing a key turns the object standalone.
 class json_object {
 public:
-    using object = std::unordered_map<std::string, json_value>;
-    using iterator = object::iterator;
-    using const_iterator = object::const_iterator;
+    // Transparent so lookups can take std::string_view without building a
+    // std::string where the standard library supports it
+    struct key_hash {
+        using is_transparent = void;
+        size_t operator()(std::string_view key) const noexcept {
+            return std::hash<std::string_view>()(key);
+        }
+    };
+
+    using object = std::unordered_map<std::string, json_value, key_hash, std::equal_to<>>;
+
+    // Iterates either layout. Shaped objects keep no pairs to refer to, so
+    // dereferencing yields a pair of references to the key in the shape and
+    // the value; bind it with const auto& or auto&&, or copy it as
+    // value_type.
+    template <bool Const>
+    class basic_iterator {
+    public:
+        using map_iterator = std::conditional_t<Const, object::const_iterator, object::iterator>;
+        using value_pointer = std::conditional_t<Const, const json_value*, json_value*>;
+
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = object::value_type;
+        using reference = std::pair<const std::string&, std::conditional_t<Const, const json_value&, json_value&>>;
+        using difference_type = std::ptrdiff_t;
+
+        struct pointer {
+            reference member;
+            const reference* operator->() const { return &member; }
+        };
+
+        basic_iterator() = default;
+        basic_iterator(map_iterator it) : it_(it) {}
+        basic_iterator(const std::string* key, value_pointer value) : key_(key), value_(value) {}
+
+        template <bool Other, typename = std::enable_if_t<Const && !Other>>
+        basic_iterator(const basic_iterator<Other>& other) : it_(other.it_), key_(other.key_), value_(other.value_) {}
+
+        reference operator*() const {
+            return key_ ? reference(*key_, *value_) : reference(it_->first, it_->second);
+        }
+
+        pointer operator->() const {
+            return pointer{**this};
+        }
+
+        basic_iterator& operator++() {
+            if (key_) {
+                ++key_;
+                ++value_;
+            }
+            else {
+                ++it_;
+            }
+
+            return *this;
+        }
+
+        basic_iterator operator++(int) {
+            basic_iterator previous = *this;
+            ++*this;
+            return previous;
+        }
+
+        bool operator==(const basic_iterator& other) const {
+            return key_ ? value_ == other.value_ : it_ == other.it_;
+        }
+
+        bool operator!=(const basic_iterator& other) const {
+            return !(*this == other);
+        }
+
+    private:
+        template <bool>
+        friend class basic_iterator;
+
+        map_iterator it_{};
+        // Set for shaped objects
+        const std::string* key_ = nullptr;
+        value_pointer value_ = nullptr;
+    };
+
+    using iterator = basic_iterator<false>;
+    using const_iterator = basic_iterator<true>;
+
+    // A key that remembers the shape it was last looked up in and where it
+    // was found there, so finding it in many objects of that shape is a
+    // pointer comparison and an offset load. Not for concurrent use.
+    class member_key {
+    public:
+        explicit member_key(std::string name);
+
+        const std::string& name() const;
+
+    private:
+        friend class json_object;
+
+        std::string name_;
+        mutable std::shared_ptr<const object_shape> shape_;
+        mutable size_t slot_;
+    };
 
     class json_object_proxy {
     public:
-        json_object_proxy(json_object& obj, const std::string& key);
+        // The key is referenced, not copied, so a proxy must not outlive the
+        // expression that created it
+        json_object_proxy(json_object& obj, std::string_view key);
 
         json_object_proxy& operator=(const std::string& value);
         json_object_proxy& operator=(const char* value);
@@ -33,13 +151,23 @@ public:
 
         json_value& as_value();
         const json_value& as_value() const;
+        std::string_view get_view() const;
 
-        json_object_proxy operator[](const std::string& key);
+        json_object_proxy operator[](std::string_view key);
         json_object_proxy operator[](size_t index);
 
+        // Exact match for literals, which would otherwise be ambiguous with
+        // the built-in subscript through the integer conversions
+        template <size_t N>
+        json_object_proxy operator[](const char (&key)[N]) {
+            return (*this)[std::string_view(key)];
+        }
+
     private:
         json_object& obj_;
-        std::string key_;
+        std::string_view key_;
+
+        json_value& resolve();
     };
 
     json_object();
@@ -51,20 +179,31 @@ public:
     json_object& operator=(json_object&& other) noexcept;
 
     std::string dump(int indent = -1, int current_indent = 0) const;
+    // With memoize set, see json_value::dump_to
+    void dump_to(std::string& out, int indent = -1, int current_indent = 0, bool ascii_only = false,
+                 bool memoize = false) const;
 
+    // Shaped objects build the map on first use and keep it until modified
     const object& get_values() const;
     void set_value(const std::string& key, const json_value& value);
     void set_value(const std::string& key, json_value&& value);
-    bool has_key(const std::string& key) const;
-    void remove_key(const std::string& key);
-    json_object_proxy operator[](const std::string& key);
-    const json_value& operator[](const std::string& key) const;
+    json_value& insert_or_assign(std::string&& key, json_value&& value);
+    bool has_key(std::string_view key) const;
+    void remove_key(std::string_view key);
+    json_object_proxy operator[](std::string_view key);
+    const json_value& operator[](std::string_view key) const;
+    const json_value& at(std::string_view key) const;
+    const json_value* find(std::string_view key) const;
+    json_value* find(std::string_view key);
+    const json_value* find(const member_key& key) const;
+    // Removes the entry and returns its value without copying it
+    json_value extract(std::string_view key);
 
     size_t size() const;
     bool empty() const;
     void clear();
-    bool contains(const std::string& key) const;
-    void erase(const std::string& key);
+    bool contains(std::string_view key) const;
+    void erase(std::string_view key);
 
     iterator begin();
     iterator end();
@@ -73,11 +212,66 @@ public:
     const_iterator cbegin() const;
     const_iterator cend() const;
 
+    // Structural hash (see json_value::hash). Non-const access can hand
+    // out references that modify elements later, so the result is cached
+    // only while the object is sealed: parsed and copied objects start sealed,
+    // non-const access unseals, and seal() promises that no reference from
+    // earlier non-const access is used to modify it any more.
+    size_t hash() const;
+    void seal();
+
+    // Text the object was parsed from with parse_options::preserve_source,
+    // written verbatim by compact dumps. Any non-const access clears it.
+    std::string_view source() const;
+    void set_source(source_text text);
+
     bool operator==(const json_object& other) const;
     bool operator!=(const json_object& other) const;
 
+    // Null for standalone objects
+    const object_shape* shape() const;
+
 private:
-    object values_;
+    // Holds the members of standalone objects, and mirrors those of shaped
+    // ones once get_values() builds it
+    mutable object values_;
+    std::shared_ptr<const object_shape> shape_;
+    // Values of a shaped object, in the order of its keys
+    std::vector<json_value> slots_;
+    // Set once values_ mirrors the slots
+    mutable std::atomic<bool> materialized_;
+    source_text source_;
+    // 0 until computed while sealed
+    mutable std::atomic<size_t> hash_;
+    bool sealed_;
+    // Text of a memoizing dump, only kept while sealed and accessed
+    // atomically by concurrent dumps
+    mutable std::shared_ptr<const dump_cache> dump_;
+
+    // Reads and stores dump_
+    friend class json_dumper;
+
+    // Reads and stores hash_
+    friend class json_hasher;
+
+    // Compares children without recursion
+    friend class json_comparer;
+
+    // Replaces elements by equal shared ones, which needs no touch()
+    friend class json_interner;
+
+    // Gives parsed objects their shape
+    friend class tree_builder;
+
+    // Called by every non-const accessor before handing out mutable access
+    void touch();
+    // Turns a shaped object standalone, before adding or removing a key
+    void unshape();
+    void materialize() const;
+    size_t slot(std::string_view key) const;
+    object::iterator lookup(std::string_view key);
+    object::const_iterator lookup(std::string_view key) const;
+    json_value& resolve(std::string_view key);
 };
 
 #endif // JSON_OBJECT_HPP
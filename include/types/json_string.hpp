@@ -2,6 +2,7 @@
 #define JSON_STRING_HPP
 
 #include <string>
+#include <string_view>
 
 class json_string {
 public:
@@ -14,8 +15,13 @@ public:
     json_string& operator=(json_string&& other) noexcept;
 
     std::string dump(int indent = -1, int current_indent = 0) const;
+    void dump_to(std::string& out, int indent = -1, int current_indent = 0, bool ascii_only = false) const;
 
-    std::string get_value() const;
+    const std::string& get_value() const;
+    std::string_view get_view() const;
+    void set_value(const std::string& value);
+    // Moves the contents out, leaving this string empty
+    std::string take_value();
 
     bool operator==(const json_string& other) const;
     bool operator!=(const json_string& other) const;
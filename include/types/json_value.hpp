@@ -1,6 +1,7 @@
 #ifndef JSON_VALUE_HPP
 #define JSON_VALUE_HPP
 
+#include <functional>
 #include <string>
 #include <memory>
 #include <stdexcept>
@@ -41,10 +42,18 @@ public:
 
     json_type type() const;
     std::string dump(int indent = -1, int current_indent = 0) const;
+    // With memoize set, sealed containers keep the text they are dumped to
+    // and later memoizing dumps with the same settings copy it, so dumping
+    // a mostly unchanged tree again only serializes what was modified
+    void dump_to(std::string& out, int indent = -1, int current_indent = 0, bool ascii_only = false,
+                 bool memoize = false) const;
     json_value clone() const;
 
     bool operator==(const json_value& other) const;
     bool operator!=(const json_value& other) const;
+    // Consistent with operator==; containers cache theirs (see
+    // json_array::hash)
+    size_t hash() const;
 
     bool is_null() const;
     bool is_boolean() const;
@@ -66,12 +75,52 @@ public:
     json_object& as_object();
     const json_object& as_object() const;
 
+    // Move the contents out without copying, leaving this value null.
+    // The typed variants throw if the value has a different type.
+    json_value take();
+    std::string take_string();
+    json_array take_array();
+    json_object take_object();
+
     static json_value make_array();
     static json_value make_object();
+    // A number kept as its JSON text (see json_number::from_lexeme)
+    static json_value make_number(std::string lexeme);
 
 private:
     struct impl;
-    std::unique_ptr<impl> pimpl_;
+
+    // Releases one owner of a node; interned nodes can have several
+    struct impl_release {
+        void operator()(impl* node) const noexcept;
+    };
+
+    using impl_ptr = std::unique_ptr<impl, impl_release>;
+
+    impl_ptr pimpl_;
+
+    friend class json_interner;
+
+    template <typename... Args>
+    static impl_ptr make_impl(Args&&... args);
+    // Shares an interned node, copies any other
+    static impl_ptr copy_impl(const impl& node);
+    // Gives this value a node of its own before it is modified
+    void unshare();
+    // For json_interner
+    bool is_shared() const;
+    bool same_node(const json_value& other) const;
+    void mark_shared();
+    void share(const json_value& pooled);
 };
 
+namespace std {
+    template <>
+    struct hash<json_value> {
+        size_t operator()(const json_value& value) const {
+            return value.hash();
+        }
+    };
+}
+
 #endif // JSON_VALUE_HPP
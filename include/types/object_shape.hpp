@@ -0,0 +1,30 @@
+#ifndef OBJECT_SHAPE_HPP
+#define OBJECT_SHAPE_HPP
+
+#include <limits>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// The ordered keys of objects parsed with the same members, shared by all
+// of them so each object stores only its values. Immutable once built.
+class object_shape {
+public:
+    static constexpr size_t npos = std::numeric_limits<size_t>::max();
+
+    object_shape(std::vector<std::string> keys);
+
+    size_t size() const;
+    const std::string& key(size_t slot) const;
+    const std::vector<std::string>& keys() const;
+    // Position of key among the keys, or npos
+    size_t find(std::string_view key) const;
+
+private:
+    std::vector<std::string> keys_;
+    // Only built for shapes too large to scan
+    std::unordered_map<std::string_view, size_t> index_;
+};
+
+#endif // OBJECT_SHAPE_HPP
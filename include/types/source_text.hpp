@@ -0,0 +1,25 @@
+#ifndef SOURCE_TEXT_HPP
+#define SOURCE_TEXT_HPP
+
+#include <memory>
+#include <string>
+#include <string_view>
+
+// A range of the input a value was parsed from. Every range taken from one
+// input shares it, so the input lives as long as the last value holding a
+// range of it.
+class source_text {
+public:
+    source_text();
+    source_text(std::shared_ptr<const std::string> input, size_t begin, size_t end);
+
+    bool empty() const;
+    std::string_view view() const;
+    void reset();
+
+private:
+    std::shared_ptr<const std::string> input_;
+    std::string_view view_;
+};
+
+#endif // SOURCE_TEXT_HPP
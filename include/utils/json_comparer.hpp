@@ -0,0 +1,37 @@
+#ifndef JSON_COMPARER_HPP
+#define JSON_COMPARER_HPP
+
+#include "../types/json_array.hpp"
+#include "../types/json_object.hpp"
+#include <vector>
+
+// Compares containers with an explicit stack instead of recursion, with
+// the semantics of json_value::operator==. Each pair of containers is
+// first told apart by size and, when both are sealed, by hash, and packed
+// arrays are compared from their buffers.
+class json_comparer {
+public:
+    bool equal(const json_array& a, const json_array& b);
+    bool equal(const json_object& a, const json_object& b);
+
+private:
+    struct frame {
+        const json_array* arr;
+        const json_array* other_arr;
+        const json_object* obj;
+        const json_object* other_obj;
+        size_t index;
+        json_object::const_iterator it;
+    };
+
+    std::vector<frame> stack_;
+
+    // Returns false if the pair differs; pushes a frame when their
+    // children are still to be compared
+    bool open(const json_array& a, const json_array& b);
+    bool open(const json_object& a, const json_object& b);
+    bool compare(const json_value& a, const json_value& b);
+    bool run();
+};
+
+#endif // JSON_COMPARER_HPP
@@ -0,0 +1,59 @@
+#ifndef JSON_DUMPER_HPP
+#define JSON_DUMPER_HPP
+
+#include "../types/json_array.hpp"
+#include "../types/json_object.hpp"
+#include <memory>
+#include <string>
+#include <vector>
+
+// Text a container was serialized to, with the settings that produced it
+struct dump_cache {
+    int indent;
+    int current_indent;
+    bool ascii_only;
+    std::string text;
+};
+
+// Serializes containers with an explicit stack instead of recursion, using
+// the indent conventions of json_value::dump.
+//
+// Memoizing dumps copy the cached text of sealed containers. The text of a
+// sealed container includes that of its children, so only containers that
+// are the root of the dump or have an unsealed parent store their text:
+// the cached text adds up to about one copy of the document, and after a
+// change only the modified containers and, once, their direct children are
+// serialized again.
+class json_dumper {
+public:
+    json_dumper(std::string& out, int indent, bool ascii_only, bool memoize = false);
+
+    void dump(const json_array& arr, int current_indent);
+    void dump(const json_object& obj, int current_indent);
+
+private:
+    struct frame {
+        const json_array* arr;
+        const json_object* obj;
+        size_t index;
+        json_object::const_iterator it;
+        int current_indent;
+        // Where the container's text starts, if it is to be stored
+        size_t start;
+        bool store;
+    };
+
+    std::string& out_;
+    int indent_;
+    bool ascii_only_;
+    bool memoize_;
+    std::vector<frame> stack_;
+
+    void open(const json_array* arr, const json_object* obj, int current_indent, bool parent_sealed);
+    bool copy_cached(const json_array* arr, const json_object* obj, int current_indent);
+    void write_packed(const json_array& arr, int current_indent);
+    void close(const frame& f);
+    void run();
+};
+
+#endif // JSON_DUMPER_HPP
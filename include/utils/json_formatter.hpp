@@ -0,0 +1,64 @@
+#ifndef JSON_FORMATTER_HPP
+#define JSON_FORMATTER_HPP
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Re-indents or minifies JSON text without parsing it into a tree. The
+// whitespace between tokens is replaced by the layout json_value::dump
+// produces with the same indent, while strings, numbers and literals are
+// copied byte for byte, so values come out exactly as they went in.
+//
+// Only the structure is checked: brackets must match, keys, colons, commas
+// and values must come in a valid order and strings must be terminated,
+// without control characters. The contents of numbers, literals and escapes
+// are not validated, and a malformed document throws std::runtime_error.
+//
+// Text may be written in chunks of any size, split anywhere; the output is
+// appended to out as it is produced, so a caller can drain it in between.
+class json_formatter {
+public:
+    json_formatter(std::string& out, int indent = -1);
+
+    void write(std::string_view text);
+    // Throws std::runtime_error unless the text written was one complete
+    // value
+    void finish();
+
+    static std::string minify(std::string_view text);
+    static std::string prettify(std::string_view text, int indent);
+
+private:
+    // What may come next
+    enum class expect : std::uint8_t {
+        value,
+        value_or_close,
+        key,
+        key_or_close,
+        colon,
+        comma_or_close,
+        end
+    };
+
+    std::string& out_;
+    int indent_;
+    expect expect_;
+    // Closing bracket of each open container
+    std::vector<char> closers_;
+    bool in_string_;
+    bool escaped_;
+    bool in_token_;
+    // Bytes written before the current chunk, for error offsets
+    size_t offset_;
+
+    size_t write_string(const char* data, size_t size, size_t pos);
+    void start_value(size_t pos);
+    void finish_value();
+    void close(char closer, size_t pos);
+    void line_break(size_t depth);
+    [[noreturn]] void fail(size_t pos, const char* message) const;
+};
+
+#endif // JSON_FORMATTER_HPP
@@ -0,0 +1,39 @@
+#ifndef JSON_HASHER_HPP
+#define JSON_HASHER_HPP
+
+#include "../types/json_array.hpp"
+#include "../types/json_object.hpp"
+#include <string>
+#include <vector>
+
+// Computes structural hashes (see json_value::hash) with an explicit stack
+// instead of recursion. Sealed containers with a cached hash are not
+// descended into, and every sealed container finished on the way stores
+// its hash.
+class json_hasher {
+public:
+    size_t hash(const json_array& arr);
+    size_t hash(const json_object& obj);
+
+private:
+    struct frame {
+        const json_array* arr;
+        const json_object* obj;
+        size_t index;
+        json_object::const_iterator it;
+        // Array seed, or the sum of member hashes
+        size_t seed;
+        // Key of the member whose value is being hashed
+        const std::string* key;
+    };
+
+    std::vector<frame> stack_;
+
+    static bool cached(const json_array* arr, const json_object* obj, size_t& result);
+    // Returns true if the container's hash is already known, in result
+    bool open(const json_array* arr, const json_object* obj, size_t& result);
+    size_t close(const frame& f);
+    size_t run();
+};
+
+#endif // JSON_HASHER_HPP
@@ -0,0 +1,33 @@
+#ifndef JSON_INTERNER_HPP
+#define JSON_INTERNER_HPP
+
+#include "../types/json_value.hpp"
+#include <unordered_map>
+#include <vector>
+
+// Hash-consing: replaces structurally equal values, containers and scalars
+// alike, by one shared node. Shared nodes are immutable; a non-const
+// accessor first gives its value a private copy of that one node, whose
+// children stay shared. The pool keeps every node it has handed out alive,
+// so documents interned through the same interner share nodes with each
+// other. Object keys are not shared.
+class json_interner {
+public:
+    // References into value obtained before the call must not be used to
+    // modify it afterwards
+    void intern(json_value& value);
+
+    // Distinct nodes in the pool
+    size_t size() const;
+    void clear();
+
+private:
+    // Nodes by structural hash
+    std::unordered_map<size_t, std::vector<json_value>> pool_;
+    size_t size_ = 0;
+
+    void intern_node(json_value& value);
+    static bool interchangeable(const json_value& pooled, const json_value& value);
+};
+
+#endif // JSON_INTERNER_HPP
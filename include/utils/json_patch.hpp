@@ -0,0 +1,35 @@
+#ifndef JSON_PATCH_HPP
+#define JSON_PATCH_HPP
+
+#include "../types/json_value.hpp"
+#include <string_view>
+
+// JSON Patch (RFC 6902) and JSON Merge Patch (RFC 7396).
+//
+// diff() skips equal subtrees through the cached structural hashes of
+// parsed or sealed containers and matches array elements by their longest
+// common subsequence, so inserting into or removing from an array does not
+// rewrite everything after that position. apply() and merge() modify the
+// target in place and only touch the containers on the patched paths.
+//
+// A malformed patch throws std::runtime_error, a path that does not exist
+// std::out_of_range and a failed test operation std::runtime_error.
+// Operations applied before the failing one stay applied; to get all or
+// nothing, apply the patch to a copy.
+class json_patch {
+public:
+    // Patch operations turning from into to, as a JSON array
+    static json_value diff(const json_value& from, const json_value& to);
+    static void apply(json_value& target, const json_value& patch);
+
+    // Merge patches cannot set a member to null or keep null members of an
+    // object that replaces a non-object: null means removal
+    static json_value merge_diff(const json_value& from, const json_value& to);
+    static void merge(json_value& target, const json_value& patch);
+
+    // Resolves a JSON Pointer, or returns nullptr if nothing is there.
+    // Throws std::runtime_error if the pointer is malformed.
+    static const json_value* find(const json_value& root, std::string_view pointer);
+};
+
+#endif // JSON_PATCH_HPP
@@ -0,0 +1,95 @@
+#ifndef JSON_WRITER_HPP
+#define JSON_WRITER_HPP
+
+#include "../types/json_value.hpp"
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+// Writes JSON incrementally without building a tree. Calls are checked
+// against the structure written so far (keys only inside objects, one
+// value per key, balanced containers, a single top-level value) and a
+// misuse throws std::runtime_error. Output is formatted exactly like
+// json_value::dump with the same indent and ascii_only arguments.
+//
+// Writing to a string appends to it directly; stream and file descriptor
+// targets are buffered and written out by flush(), when the buffer fills
+// up, and on destruction.
+class json_writer {
+public:
+    json_writer(std::string& out, int indent = -1, bool ascii_only = false);
+    json_writer(std::ostream& stream, int indent = -1, bool ascii_only = false);
+    json_writer(int fd, int indent = -1, bool ascii_only = false);
+    json_writer(const json_writer&) = delete;
+    json_writer& operator=(const json_writer&) = delete;
+    ~json_writer();
+
+    json_writer& begin_object();
+    json_writer& end_object();
+    json_writer& begin_array();
+    json_writer& end_array();
+    json_writer& key(std::string_view key);
+
+    json_writer& value(std::nullptr_t);
+    json_writer& value(bool value);
+    // Throws for NaN and infinities, which JSON cannot represent
+    json_writer& value(double value);
+    json_writer& value(std::string_view value);
+    json_writer& value(const char* value);
+    json_writer& value(const std::string& value);
+    // Embeds an existing tree at the current position
+    json_writer& value(const json_value& value);
+
+    template <typename T, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value, int>::type = 0>
+    json_writer& value(T value) {
+        if (std::is_signed<T>::value) {
+            write_integer(static_cast<long long>(value));
+        }
+        else {
+            write_unsigned(static_cast<unsigned long long>(value));
+        }
+
+        return *this;
+    }
+
+    // True once a complete top-level value has been written
+    bool complete() const;
+    void flush();
+
+private:
+    enum class sink_kind {
+        string,
+        stream,
+        fd
+    };
+
+    struct frame {
+        bool is_object;
+        size_t count;
+    };
+
+    sink_kind sink_;
+    std::string buffer_;
+    std::string& out_;
+    std::ostream* stream_;
+    int fd_;
+    int indent_;
+    bool ascii_only_;
+    bool has_key_;
+    bool complete_;
+    std::vector<frame> stack_;
+
+    void before_value();
+    void after_value();
+    void open(bool is_object);
+    void close(bool is_object);
+    void newline(size_t depth);
+    void write_integer(long long value);
+    void write_unsigned(unsigned long long value);
+    void maybe_flush();
+};
+
+#endif // JSON_WRITER_HPP
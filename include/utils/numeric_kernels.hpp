@@ -0,0 +1,35 @@
+#ifndef NUMERIC_KERNELS_HPP
+#define NUMERIC_KERNELS_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+// Bulk operations over packed number buffers. Two doubles are processed at
+// a time where SSE2 is available. Masks are bitmaps with one bit per
+// element (bit i % 64 of word i / 64); a null mask selects every element.
+class numeric_kernels {
+public:
+    enum class comparison {
+        less,
+        less_equal,
+        equal,
+        not_equal,
+        greater_equal,
+        greater
+    };
+
+    // Element-wise ==, so 0.0 equals -0.0 as it does for json_number
+    static bool equal(const double* a, const double* b, size_t count);
+
+    static double sum(const double* data, const std::uint64_t* mask, size_t count);
+    // Return false when the mask selects no element
+    static bool min(const double* data, const std::uint64_t* mask, size_t count, double& result);
+    static bool max(const double* data, const std::uint64_t* mask, size_t count, double& result);
+    // Number of set bits among the first count
+    static size_t count(const std::uint64_t* mask, size_t count);
+    // Sets bit i of out (which holds (count + 63) / 64 words) when
+    // data[i] <op> value holds
+    static void compare(const double* data, size_t count, comparison op, double value, std::uint64_t* out);
+};
+
+#endif // NUMERIC_KERNELS_HPP
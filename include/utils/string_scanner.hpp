@@ -0,0 +1,17 @@
+#ifndef STRING_SCANNER_HPP
+#define STRING_SCANNER_HPP
+
+#include <cstddef>
+
+class string_scanner {
+public:
+    // Length of the leading run of string content that contains no quote,
+    // backslash or control character (and, with stop_at_non_ascii, no byte
+    // >= 0x80). Scans 16 bytes at a time where SSE2 is available.
+    static size_t plain_prefix(const char* data, size_t size, bool stop_at_non_ascii);
+    // Length of the leading run of JSON whitespace (space, tab, line feed,
+    // carriage return), 16 bytes at a time where SSE2 is available
+    static size_t whitespace_prefix(const char* data, size_t size);
+};
+
+#endif // STRING_SCANNER_HPP
@@ -0,0 +1,20 @@
+#ifndef STRING_WRITER_HPP
+#define STRING_WRITER_HPP
+
+#include <string>
+#include <string_view>
+
+class string_writer {
+public:
+    // Appends value as a quoted JSON string. Runs of characters that need
+    // no escaping are found 16 bytes at a time and copied in bulk. All
+    // control characters are escaped; with ascii_only, non-ASCII UTF-8 is
+    // written as \uXXXX (surrogate pairs above U+FFFF) and malformed
+    // sequences as the replacement character U+FFFD.
+    static void write(std::string& out, std::string_view value, bool ascii_only = false);
+
+private:
+    static void write_unicode_escape(std::string& out, unsigned code_unit);
+};
+
+#endif // STRING_WRITER_HPP
@@ -0,0 +1,27 @@
+#ifndef STRUCTURAL_HASH_HPP
+#define STRUCTURAL_HASH_HPP
+
+#include <cstddef>
+#include <string_view>
+
+// Hash building blocks for json_value::hash, chosen so that values which
+// compare equal hash equally: numbers hash their value with -0.0 folded
+// into 0.0, arrays fold element hashes in order and objects sum member
+// hashes so that member order does not matter.
+class structural_hash {
+public:
+    static size_t of_null();
+    static size_t of_boolean(bool value);
+    static size_t of_number(double value);
+    static size_t of_string(std::string_view value);
+
+    static size_t array_seed(size_t size);
+    static size_t add_element(size_t seed, size_t element);
+    static size_t member(std::string_view key, size_t value);
+    static size_t object_seed(size_t member_sum, size_t size);
+
+    // Never 0, which containers use to mark a hash not yet computed
+    static size_t finish(size_t seed);
+};
+
+#endif // STRUCTURAL_HASH_HPP
@@ -0,0 +1,16 @@
+#ifndef UTF8_HPP
+#define UTF8_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+class utf8 {
+public:
+    // Decodes the sequence starting at data and returns its length, or 0
+    // if it is malformed, overlong, a surrogate or above U+10FFFF.
+    static size_t decode(const char* data, size_t size, std::uint32_t& code_point);
+    static void encode(std::string& out, std::uint32_t code_point);
+};
+
+#endif // UTF8_HPP
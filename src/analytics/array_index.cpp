@@ -0,0 +1,335 @@
+#include "../../include/analytics/array_index.hpp"
+#include "../../include/types/json_boolean.hpp"
+#include "../../include/types/json_number.hpp"
+#include "../../include/types/json_string.hpp"
+#include "../../include/utils/structural_hash.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+// key implementations
+array_index::key::key(std::nullptr_t) : type_(json_type::null), boolean_(false), number_(0.0) {}
+
+array_index::key::key(bool value) : type_(json_type::boolean), boolean_(value), number_(0.0) {}
+
+array_index::key::key(double value) : type_(json_type::number), boolean_(false), number_(value) {}
+
+array_index::key::key(const char* value)
+    : type_(json_type::string), boolean_(false), number_(0.0), string_(value) {}
+
+array_index::key::key(std::string_view value)
+    : type_(json_type::string), boolean_(false), number_(0.0), string_(value) {}
+
+array_index::key::key(const std::string& value)
+    : type_(json_type::string), boolean_(false), number_(0.0), string_(value) {}
+
+array_index::key::key(const json_value& value) : type_(value.type()), boolean_(false), number_(0.0) {
+    switch (type_) {
+        case json_type::boolean:
+            boolean_ = value.as_boolean().get_value();
+            break;
+        case json_type::number:
+            number_ = value.as_number().get_value();
+            break;
+        case json_type::string:
+            string_ = value.as_string().get_view();
+            break;
+        default:
+            break;
+    }
+}
+
+// array_index implementations
+array_index::array_index(const json_array& array, std::string_view path, kind type)
+    : array_(array), path_(path), type_(type), version_(0), scanned_(0), count_(0), distinct_(0) {
+    while (true) {
+        size_t dot = path.find('.');
+        segments_.emplace_back(path.substr(0, dot));
+        member_keys_.emplace_back(segments_.back());
+        if (dot == std::string_view::npos) {
+            break;
+        }
+
+        path.remove_prefix(dot + 1);
+    }
+
+    refresh(true);
+}
+
+const json_value* array_index::find(const key& k) const {
+    size_t found = position(k);
+    return found == npos ? nullptr : &array_[found];
+}
+
+const json_value& array_index::at(const key& k) const {
+    const json_value* found = find(k);
+    if (!found) {
+        throw std::out_of_range("Key not found in index on " + path_);
+    }
+
+    return *found;
+}
+
+size_t array_index::position(const key& k) const {
+    update();
+    return lookup(k);
+}
+
+std::vector<const json_value*> array_index::find_all(const key& k) const {
+    update();
+    std::vector<const json_value*> out;
+    if (type_ == kind::sorted) {
+        for (size_t i = bound(k, true); i < order_.size() && compare(key_of(order_[i]), k) == 0; ++i) {
+            out.push_back(&array_[order_[i]]);
+        }
+
+        return out;
+    }
+
+    for (size_t i = lookup(k); i != npos; i = next_[i]) {
+        out.push_back(&array_[i]);
+    }
+
+    return out;
+}
+
+std::vector<const json_value*> array_index::range(const key& low, const key& high) const {
+    if (type_ != kind::sorted) {
+        throw std::runtime_error("Range lookups need a sorted index on " + path_);
+    }
+
+    update();
+    std::vector<const json_value*> out;
+    size_t end = bound(high, false);
+    for (size_t i = bound(low, true); i < end; ++i) {
+        out.push_back(&array_[order_[i]]);
+    }
+
+    return out;
+}
+
+const std::string& array_index::path() const {
+    return path_;
+}
+
+array_index::kind array_index::type() const {
+    return type_;
+}
+
+size_t array_index::size() const {
+    update();
+    return count_;
+}
+
+void array_index::rebuild() {
+    refresh(true);
+}
+
+void array_index::update() const {
+    if (version_.load(std::memory_order_acquire) != array_.version()) {
+        refresh(false);
+    }
+}
+
+void array_index::refresh(bool full) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::uint64_t current = array_.version();
+    if (!full && version_.load(std::memory_order_relaxed) == current) {
+        return;
+    }
+
+    const json_array::array& elements = array_.get_values();
+    if (full || array_.last_rewrite() > version_.load(std::memory_order_relaxed) || elements.size() < scanned_) {
+        scanned_ = 0;
+        count_ = 0;
+        distinct_ = 0;
+        slots_.clear();
+        next_.clear();
+        order_.clear();
+    }
+
+    size_t sorted = order_.size();
+    next_.resize(elements.size(), npos);
+    for (size_t i = scanned_; i < elements.size(); ++i) {
+        add(i, elements[i]);
+    }
+
+    scanned_ = elements.size();
+    if (type_ == kind::sorted && order_.size() > sorted) {
+        // Sort the new entries with their keys resolved once, then merge
+        // them after the equal keys already indexed
+        using entry = std::pair<key, size_t>;
+        std::vector<entry> added;
+        added.reserve(order_.size() - sorted);
+        for (size_t i = sorted; i < order_.size(); ++i) {
+            added.emplace_back(key_of(order_[i]), order_[i]);
+        }
+
+        std::stable_sort(added.begin(), added.end(), [](const entry& a, const entry& b) {
+            return compare(a.first, b.first) < 0;
+        });
+
+        for (size_t i = 0; i < added.size(); ++i) {
+            order_[sorted + i] = added[i].second;
+        }
+
+        std::inplace_merge(order_.begin(), order_.begin() + static_cast<std::ptrdiff_t>(sorted), order_.end(),
+                           [this](size_t a, size_t b) {
+                               return compare(key_of(a), key_of(b)) < 0;
+                           });
+    }
+
+    version_.store(current, std::memory_order_release);
+}
+
+void array_index::add(size_t position, const json_value& element) const {
+    const json_value* value = resolve(element);
+    if (!indexable(value)) {
+        return;
+    }
+
+    ++count_;
+    if (type_ == kind::sorted) {
+        order_.push_back(position);
+        return;
+    }
+
+    if ((distinct_ + 1) * 2 > slots_.size()) {
+        grow();
+    }
+
+    key k(*value);
+    size_t h = hash(k);
+    size_t mask = slots_.size() - 1;
+    for (size_t i = h & mask;; i = (i + 1) & mask) {
+        slot& s = slots_[i];
+        if (s.first == npos) {
+            s = {h, position, position};
+            ++distinct_;
+            return;
+        }
+
+        if (s.hash == h && compare(key_of(s.first), k) == 0) {
+            next_[s.last] = position;
+            s.last = position;
+            return;
+        }
+    }
+}
+
+void array_index::grow() const {
+    std::vector<slot> old(std::max<size_t>(16, slots_.size() * 2), {0, npos, npos});
+    old.swap(slots_);
+    size_t mask = slots_.size() - 1;
+    for (const slot& s : old) {
+        if (s.first == npos) {
+            continue;
+        }
+
+        size_t i = s.hash & mask;
+        while (slots_[i].first != npos) {
+            i = (i + 1) & mask;
+        }
+
+        slots_[i] = s;
+    }
+}
+
+// Rows parsed together share their shapes, so after the first one each
+// segment is found at a remembered offset
+const json_value* array_index::resolve(const json_value& element) const {
+    const json_value* value = &element;
+    for (const json_object::member_key& part : member_keys_) {
+        value = value->is_object() ? value->as_object().find(part) : nullptr;
+        if (!value) {
+            break;
+        }
+    }
+
+    return value;
+}
+
+// Plain key lookups, since lookups may run concurrently and member_key
+// updates its cache
+array_index::key array_index::key_of(size_t position) const {
+    const json_value* value = &array_[position];
+    for (const std::string& part : segments_) {
+        value = value->as_object().find(part);
+    }
+
+    return key(*value);
+}
+
+size_t array_index::lookup(const key& k) const {
+    if (type_ == kind::sorted) {
+        size_t i = bound(k, true);
+        return i < order_.size() && compare(key_of(order_[i]), k) == 0 ? order_[i] : npos;
+    }
+
+    if (slots_.empty() || k.type_ == json_type::array || k.type_ == json_type::object) {
+        return npos;
+    }
+
+    size_t h = hash(k);
+    size_t mask = slots_.size() - 1;
+    for (size_t i = h & mask; slots_[i].first != npos; i = (i + 1) & mask) {
+        if (slots_[i].hash == h && compare(key_of(slots_[i].first), k) == 0) {
+            return slots_[i].first;
+        }
+    }
+
+    return npos;
+}
+
+size_t array_index::bound(const key& k, bool inclusive) const {
+    size_t low = 0;
+    size_t high = order_.size();
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        int order = compare(key_of(order_[mid]), k);
+        if (order < 0 || (!inclusive && order == 0)) {
+            low = mid + 1;
+        }
+        else {
+            high = mid;
+        }
+    }
+
+    return low;
+}
+
+bool array_index::indexable(const json_value* value) {
+    return value && value->type() != json_type::array && value->type() != json_type::object;
+}
+
+size_t array_index::hash(const key& k) {
+    switch (k.type_) {
+        case json_type::null:
+            return structural_hash::of_null();
+        case json_type::boolean:
+            return structural_hash::of_boolean(k.boolean_);
+        case json_type::number:
+            return structural_hash::of_number(k.number_);
+        case json_type::string:
+            return structural_hash::of_string(k.string_);
+        default:
+            return 0;
+    }
+}
+
+int array_index::compare(const key& a, const key& b) {
+    if (a.type_ != b.type_) {
+        return a.type_ < b.type_ ? -1 : 1;
+    }
+
+    switch (a.type_) {
+        case json_type::boolean:
+            return static_cast<int>(a.boolean_) - static_cast<int>(b.boolean_);
+        case json_type::number:
+            return a.number_ < b.number_ ? -1 : (b.number_ < a.number_ ? 1 : 0);
+        case json_type::string:
+            return a.string_.compare(b.string_);
+        default:
+            return 0;
+    }
+}
@@ -0,0 +1,154 @@
+#include "../../include/analytics/column_builder.hpp"
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+
+column_builder::column_builder(column_table& table) : table_(table), failure_(parse_error::none) {
+    for (column& col : table_.columns_) {
+        targets_.emplace(col.path(), &col);
+        for (size_t dot = col.path().find('.'); dot != std::string::npos; dot = col.path().find('.', dot + 1)) {
+            prefixes_.insert(col.path().substr(0, dot));
+        }
+    }
+}
+
+bool column_builder::null_value() {
+    column* target;
+    return begin_value(target);
+}
+
+bool column_builder::boolean_value(bool value) {
+    column* target;
+    if (!begin_value(target)) {
+        return false;
+    }
+
+    if (target) {
+        target->set_boolean(value);
+    }
+
+    return true;
+}
+
+bool column_builder::number_value(std::string& lexeme) {
+    column* target;
+    if (!begin_value(target)) {
+        return false;
+    }
+
+    if (target) {
+        errno = 0;
+        double value = std::strtod(lexeme.c_str(), nullptr);
+        if (errno == ERANGE && std::isinf(value)) {
+            failure_ = parse_error::invalid_number;
+            return false;
+        }
+
+        target->set_number(value);
+    }
+
+    return true;
+}
+
+bool column_builder::string_value(std::string& value) {
+    column* target;
+    if (!begin_value(target)) {
+        return false;
+    }
+
+    if (target) {
+        target->set_string(value);
+    }
+
+    return true;
+}
+
+bool column_builder::begin_object() {
+    return begin_container(true);
+}
+
+bool column_builder::key(std::string& key) {
+    const frame& top = stack_.back();
+    if (top.kind == frame_kind::record) {
+        path_.resize(top.base);
+        if (top.base > 0) {
+            path_ += '.';
+        }
+
+        path_ += key;
+    }
+
+    return true;
+}
+
+bool column_builder::end_object() {
+    stack_.pop_back();
+    return true;
+}
+
+bool column_builder::begin_array() {
+    return begin_container(false);
+}
+
+bool column_builder::end_array() {
+    stack_.pop_back();
+    return true;
+}
+
+parse_error column_builder::failure() const {
+    return failure_;
+}
+
+// Called for every value. Starts a row for elements of the top-level
+// array and sets target to the column the value belongs to, if any.
+// Returns false for a document that is not an array.
+bool column_builder::begin_value(column*& target) {
+    target = nullptr;
+    if (stack_.empty()) {
+        return false;
+    }
+
+    const frame& top = stack_.back();
+    if (top.kind == frame_kind::rows) {
+        table_.append_row();
+    }
+    else if (top.kind == frame_kind::record) {
+        auto it = targets_.find(path_);
+        if (it != targets_.end()) {
+            target = it->second;
+        }
+    }
+
+    return true;
+}
+
+bool column_builder::begin_container(bool is_object) {
+    if (stack_.empty()) {
+        if (is_object) {
+            return false;
+        }
+
+        stack_.push_back({frame_kind::rows, 0});
+        return true;
+    }
+
+    frame_kind parent = stack_.back().kind;
+    column* target;
+    begin_value(target);
+    if (target) {
+        // A requested field holding a container is not representable
+        ++target->mismatches_;
+    }
+
+    if (is_object && parent == frame_kind::rows) {
+        stack_.push_back({frame_kind::record, 0});
+    }
+    else if (is_object && parent == frame_kind::record && prefixes_.count(path_) != 0) {
+        stack_.push_back({frame_kind::record, path_.size()});
+    }
+    else {
+        stack_.push_back({frame_kind::skipped, 0});
+    }
+
+    return true;
+}
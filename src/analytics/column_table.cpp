@@ -0,0 +1,395 @@
+#include "../../include/analytics/column_table.hpp"
+#include "../../include/analytics/column_builder.hpp"
+#include "../../include/parser/parser.hpp"
+#include "../../include/types/json_boolean.hpp"
+#include "../../include/types/json_number.hpp"
+#include "../../include/types/json_string.hpp"
+#include "../../include/types/json_object.hpp"
+#include <stdexcept>
+
+// column implementations
+column::column(std::string path) : path_(std::move(path)), type_(kind::null), size_(0), mismatches_(0) {}
+
+const std::string& column::path() const {
+    return path_;
+}
+
+column::kind column::type() const {
+    return type_;
+}
+
+size_t column::size() const {
+    return size_;
+}
+
+size_t column::null_count() const {
+    return size_ - count();
+}
+
+size_t column::mismatch_count() const {
+    return mismatches_;
+}
+
+bool column::is_null(size_t row) const {
+    check_row(row);
+    return (validity_[row / 64] >> (row % 64) & 1) == 0;
+}
+
+double column::number(size_t row) const {
+    require(kind::number);
+    check_row(row);
+    return numbers_[row];
+}
+
+bool column::boolean(size_t row) const {
+    require(kind::boolean);
+    check_row(row);
+    return booleans_[row] != 0;
+}
+
+std::string_view column::string(size_t row) const {
+    require(kind::string);
+    check_row(row);
+    return std::string_view(chars_).substr(offsets_[row], offsets_[row + 1] - offsets_[row]);
+}
+
+const column::bitmap& column::validity() const {
+    return validity_;
+}
+
+const std::vector<double>& column::numbers() const {
+    return numbers_;
+}
+
+const std::vector<std::uint8_t>& column::booleans() const {
+    return booleans_;
+}
+
+const std::string& column::string_data() const {
+    return chars_;
+}
+
+const std::vector<size_t>& column::string_offsets() const {
+    return offsets_;
+}
+
+size_t column::count() const {
+    return numeric_kernels::count(validity_.data(), size_);
+}
+
+size_t column::count(const bitmap& rows) const {
+    bitmap mask = selected(rows);
+    return numeric_kernels::count(mask.data(), size_);
+}
+
+// Null rows hold 0, so sums need no validity mask
+double column::sum() const {
+    return has_numbers() ? numeric_kernels::sum(numbers_.data(), nullptr, size_) : 0.0;
+}
+
+double column::sum(const bitmap& rows) const {
+    if (!has_numbers()) {
+        return 0.0;
+    }
+
+    bitmap mask = selected(rows);
+    return numeric_kernels::sum(numbers_.data(), mask.data(), size_);
+}
+
+double column::min() const {
+    double result;
+    if (!has_numbers() || !numeric_kernels::min(numbers_.data(), validity_.data(), size_, result)) {
+        throw std::runtime_error("No values to aggregate");
+    }
+
+    return result;
+}
+
+double column::min(const bitmap& rows) const {
+    double result;
+    if (!has_numbers() || !numeric_kernels::min(numbers_.data(), selected(rows).data(), size_, result)) {
+        throw std::runtime_error("No values to aggregate");
+    }
+
+    return result;
+}
+
+double column::max() const {
+    double result;
+    if (!has_numbers() || !numeric_kernels::max(numbers_.data(), validity_.data(), size_, result)) {
+        throw std::runtime_error("No values to aggregate");
+    }
+
+    return result;
+}
+
+double column::max(const bitmap& rows) const {
+    double result;
+    if (!has_numbers() || !numeric_kernels::max(numbers_.data(), selected(rows).data(), size_, result)) {
+        throw std::runtime_error("No values to aggregate");
+    }
+
+    return result;
+}
+
+column::bitmap column::filter(comparison op, double value) const {
+    bitmap result(validity_.size());
+    if (!has_numbers()) {
+        return result;
+    }
+
+    numeric_kernels::compare(numbers_.data(), size_, op, value, result.data());
+    for (size_t w = 0; w < result.size(); ++w) {
+        result[w] &= validity_[w];
+    }
+
+    return result;
+}
+
+void column::append_null() {
+    if (size_ % 64 == 0) {
+        validity_.push_back(0);
+    }
+
+    ++size_;
+    switch (type_) {
+        case kind::number:
+            numbers_.push_back(0.0);
+            break;
+        case kind::boolean:
+            booleans_.push_back(0);
+            break;
+        case kind::string:
+            offsets_.push_back(chars_.size());
+            break;
+        case kind::null:
+            break;
+    }
+}
+
+void column::set_number(double value) {
+    if (!adopt(kind::number)) {
+        return;
+    }
+
+    numbers_.back() = value;
+}
+
+void column::set_boolean(bool value) {
+    if (!adopt(kind::boolean)) {
+        return;
+    }
+
+    booleans_.back() = value ? 1 : 0;
+}
+
+void column::set_string(std::string_view value) {
+    if (!adopt(kind::string)) {
+        return;
+    }
+
+    // A duplicate key replaces the row's earlier value
+    chars_.resize(offsets_[size_ - 1]);
+    chars_.append(value.data(), value.size());
+    offsets_.back() = chars_.size();
+}
+
+// Marks the last row valid if type matches the column's, fixing the type
+// (and backfilling earlier null rows) on the first non-null value
+bool column::adopt(kind type) {
+    if (type_ == kind::null) {
+        type_ = type;
+        switch (type) {
+            case kind::number:
+                numbers_.assign(size_, 0.0);
+                break;
+            case kind::boolean:
+                booleans_.assign(size_, 0);
+                break;
+            default:
+                offsets_.assign(size_ + 1, 0);
+                break;
+        }
+    }
+    else if (type_ != type) {
+        ++mismatches_;
+        return false;
+    }
+
+    size_t row = size_ - 1;
+    validity_[row / 64] |= std::uint64_t(1) << (row % 64);
+    return true;
+}
+
+void column::require(kind type) const {
+    if (type_ == type) {
+        return;
+    }
+
+    switch (type) {
+        case kind::number:
+            throw std::runtime_error("Column is not number");
+        case kind::boolean:
+            throw std::runtime_error("Column is not boolean");
+        default:
+            throw std::runtime_error("Column is not string");
+    }
+}
+
+// An all-null column aggregates like a numeric column with no values
+bool column::has_numbers() const {
+    if (type_ == kind::null) {
+        return false;
+    }
+
+    require(kind::number);
+    return true;
+}
+
+void column::check_row(size_t row) const {
+    if (row >= size_) {
+        throw std::out_of_range("Index out of range: " + std::to_string(row));
+    }
+}
+
+column::bitmap column::selected(const bitmap& rows) const {
+    bitmap mask(validity_);
+    for (size_t w = 0; w < mask.size(); ++w) {
+        mask[w] &= w < rows.size() ? rows[w] : 0;
+    }
+
+    return mask;
+}
+
+// column_table implementations
+column_table::column_table(const std::vector<std::string>& paths) : rows_(0) {
+    columns_.reserve(paths.size());
+    for (const std::string& path : paths) {
+        if (!find(path)) {
+            columns_.emplace_back(path);
+        }
+    }
+}
+
+column_table column_table::from_array(const json_array& rows, const std::vector<std::string>& paths) {
+    column_table table(paths);
+    // Rows parsed together share their shapes, so each key is found at a
+    // remembered offset after the first row
+    std::vector<std::vector<json_object::member_key>> segments;
+    for (const column& col : table.columns_) {
+        std::vector<json_object::member_key> parts;
+        std::string_view rest = col.path();
+        while (true) {
+            size_t dot = rest.find('.');
+            parts.emplace_back(std::string(rest.substr(0, dot)));
+            if (dot == std::string_view::npos) {
+                break;
+            }
+
+            rest.remove_prefix(dot + 1);
+        }
+
+        segments.push_back(std::move(parts));
+    }
+
+    for (const json_value& row : rows) {
+        table.append_row();
+        if (!row.is_object()) {
+            continue;
+        }
+
+        for (size_t c = 0; c < table.columns_.size(); ++c) {
+            const json_value* value = &row;
+            for (const json_object::member_key& part : segments[c]) {
+                value = value->is_object() ? value->as_object().find(part) : nullptr;
+                if (!value) {
+                    break;
+                }
+            }
+
+            if (!value) {
+                continue;
+            }
+
+            column& col = table.columns_[c];
+            switch (value->type()) {
+                case json_type::number:
+                    col.set_number(value->as_number().get_value());
+                    break;
+                case json_type::boolean:
+                    col.set_boolean(value->as_boolean().get_value());
+                    break;
+                case json_type::string:
+                    col.set_string(value->as_string().get_view());
+                    break;
+                case json_type::null:
+                    break;
+                default:
+                    ++col.mismatches_;
+                    break;
+            }
+        }
+    }
+
+    return table;
+}
+
+column_table column_table::parse(const std::string& text, const std::vector<std::string>& paths,
+                                 const parse_options& options) {
+    column_table table(paths);
+    column_builder builder(table);
+    parser p(text, options);
+    parse_result result = p.try_parse(builder);
+    if (result.error() == parse_error::rejected_by_handler) {
+        throw std::runtime_error("Expected an array of records");
+    }
+
+    if (!result) {
+        throw std::runtime_error(result.describe());
+    }
+
+    return table;
+}
+
+size_t column_table::rows() const {
+    return rows_;
+}
+
+size_t column_table::column_count() const {
+    return columns_.size();
+}
+
+const column& column_table::operator[](size_t index) const {
+    if (index >= columns_.size()) {
+        throw std::out_of_range("Index out of range: " + std::to_string(index));
+    }
+
+    return columns_[index];
+}
+
+const column& column_table::operator[](std::string_view path) const {
+    const column* col = find(path);
+    if (!col) {
+        throw std::out_of_range("Column not found: " + std::string(path));
+    }
+
+    return *col;
+}
+
+const column* column_table::find(std::string_view path) const {
+    for (const column& col : columns_) {
+        if (col.path_ == path) {
+            return &col;
+        }
+    }
+
+    return nullptr;
+}
+
+void column_table::append_row() {
+    for (column& col : columns_) {
+        col.append_null();
+    }
+
+    ++rows_;
+}
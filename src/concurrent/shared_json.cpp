@@ -0,0 +1,31 @@
+#include "../../include/concurrent/shared_json.hpp"
+#include <atomic>
+
+shared_json::shared_json() : current_(std::make_shared<const json_value>()) {}
+
+shared_json::shared_json(const json_value& value) : current_(std::make_shared<const json_value>(value)) {}
+
+shared_json::shared_json(json_value&& value) : current_(std::make_shared<const json_value>(std::move(value))) {}
+
+shared_json::snapshot shared_json::load() const {
+    return std::atomic_load(&current_);
+}
+
+void shared_json::store(const json_value& value) {
+    store(json_value(value));
+}
+
+void shared_json::store(json_value&& value) {
+    snapshot next = std::make_shared<const json_value>(std::move(value));
+    std::lock_guard<std::mutex> lock(writer_mutex_);
+    std::atomic_store(&current_, std::move(next));
+}
+
+// Writers are serialized so that concurrent updates never lose each other's
+// changes; readers are never blocked by them
+void shared_json::update(const std::function<void(json_value&)>& mutator) {
+    std::lock_guard<std::mutex> lock(writer_mutex_);
+    json_value next = *std::atomic_load(&current_);
+    mutator(next);
+    std::atomic_store(&current_, std::make_shared<const json_value>(std::move(next)));
+}
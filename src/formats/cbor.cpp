@@ -0,0 +1,358 @@
+#include "../../include/formats/cbor.hpp"
+#include "../../include/types/json_null.hpp"
+#include "../../include/types/json_boolean.hpp"
+#include "../../include/types/json_number.hpp"
+#include "../../include/types/json_string.hpp"
+#include "../../include/types/json_array.hpp"
+#include "../../include/types/json_object.hpp"
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+    constexpr std::uint8_t major_unsigned = 0;
+    constexpr std::uint8_t major_negative = 1;
+    constexpr std::uint8_t major_bytes = 2;
+    constexpr std::uint8_t major_text = 3;
+    constexpr std::uint8_t major_array = 4;
+    constexpr std::uint8_t major_map = 5;
+    constexpr std::uint8_t major_tag = 6;
+
+    constexpr std::uint8_t info_indefinite = 31;
+    constexpr std::uint8_t simple_false = 0xf4;
+    constexpr std::uint8_t simple_true = 0xf5;
+    constexpr std::uint8_t simple_null = 0xf6;
+    constexpr std::uint8_t float32_head = 0xfa;
+    constexpr std::uint8_t float64_head = 0xfb;
+    constexpr std::uint8_t break_code = 0xff;
+
+    // 2^64 as a double; every integral double strictly below it fits in uint64_t.
+    constexpr double two_pow_64 = 18446744073709551616.0;
+
+    double decode_half(std::uint16_t half) {
+        int exponent = (half >> 10) & 0x1f;
+        int mantissa = half & 0x3ff;
+        double value;
+        if (exponent == 0) {
+            value = std::ldexp(mantissa, -24);
+        }
+        else if (exponent != 31) {
+            value = std::ldexp(mantissa + 1024, exponent - 25);
+        }
+        else {
+            value = mantissa == 0 ? INFINITY : NAN;
+        }
+
+        return (half & 0x8000) ? -value : value;
+    }
+}
+
+// cbor_encoder implementations
+cbor_encoder::cbor_encoder(std::vector<std::uint8_t>& out) : out_(out) {}
+
+void cbor_encoder::encode(const json_value& value) {
+    switch (value.type()) {
+        case json_type::null:
+            out_.push_back(simple_null);
+            break;
+        case json_type::boolean:
+            out_.push_back(value.as_boolean().get_value() ? simple_true : simple_false);
+            break;
+        case json_type::number:
+            write_number(value.as_number().get_value());
+            break;
+        case json_type::string:
+            write_string(value.as_string().get_value());
+            break;
+        case json_type::array: {
+            const json_array& arr = value.as_array();
+            write_head(major_array, arr.size());
+            if (arr.get_packing() == json_array::packing::numbers) {
+                for (double number : arr.numbers()) {
+                    write_number(number);
+                }
+            }
+            else if (arr.get_packing() == json_array::packing::booleans) {
+                for (std::uint8_t boolean : arr.booleans()) {
+                    out_.push_back(boolean ? simple_true : simple_false);
+                }
+            }
+            else {
+                for (const auto& elem : arr) {
+                    encode(elem);
+                }
+            }
+
+            break;
+        }
+        case json_type::object: {
+            const json_object& obj = value.as_object();
+            write_head(major_map, obj.size());
+            for (const auto& [key, val] : obj) {
+                write_string(key);
+                encode(val);
+            }
+
+            break;
+        }
+    }
+}
+
+void cbor_encoder::write_head(std::uint8_t major, std::uint64_t argument) {
+    std::uint8_t type_bits = static_cast<std::uint8_t>(major << 5);
+    if (argument < 24) {
+        out_.push_back(type_bits | static_cast<std::uint8_t>(argument));
+        return;
+    }
+
+    int bytes;
+    if (argument <= 0xff) {
+        out_.push_back(type_bits | 24);
+        bytes = 1;
+    }
+    else if (argument <= 0xffff) {
+        out_.push_back(type_bits | 25);
+        bytes = 2;
+    }
+    else if (argument <= 0xffffffffULL) {
+        out_.push_back(type_bits | 26);
+        bytes = 4;
+    }
+    else {
+        out_.push_back(type_bits | 27);
+        bytes = 8;
+    }
+
+    for (int shift = (bytes - 1) * 8; shift >= 0; shift -= 8) {
+        out_.push_back(static_cast<std::uint8_t>(argument >> shift));
+    }
+}
+
+void cbor_encoder::write_number(double value) {
+    // -0.0 must stay a float, otherwise the sign would be lost
+    if (std::floor(value) == value && !(value == 0.0 && std::signbit(value))) {
+        if (value >= 0.0 && value < two_pow_64) {
+            write_head(major_unsigned, static_cast<std::uint64_t>(value));
+            return;
+        }
+
+        if (value < 0.0 && value > -two_pow_64) {
+            write_head(major_negative, static_cast<std::uint64_t>(-value) - 1);
+            return;
+        }
+    }
+
+    bool fits_float = std::isnan(value) || std::isinf(value) || std::fabs(value) <= FLT_MAX;
+    if (fits_float && static_cast<double>(static_cast<float>(value)) == value) {
+        float narrow = static_cast<float>(value);
+        std::uint32_t bits;
+        std::memcpy(&bits, &narrow, sizeof(bits));
+        out_.push_back(float32_head);
+        for (int shift = 24; shift >= 0; shift -= 8) {
+            out_.push_back(static_cast<std::uint8_t>(bits >> shift));
+        }
+
+        return;
+    }
+
+    std::uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    out_.push_back(float64_head);
+    for (int shift = 56; shift >= 0; shift -= 8) {
+        out_.push_back(static_cast<std::uint8_t>(bits >> shift));
+    }
+}
+
+void cbor_encoder::write_string(const std::string& value) {
+    write_head(major_text, value.size());
+    out_.insert(out_.end(), value.begin(), value.end());
+}
+
+// cbor_decoder implementations
+cbor_decoder::cbor_decoder(const std::uint8_t* data, size_t size, const parse_options& options)
+    : data_(data), size_(size), pos_(0), depth_(0), max_depth_(options.max_depth) {}
+
+cbor_decoder::cbor_decoder(const std::vector<std::uint8_t>& data, const parse_options& options)
+    : cbor_decoder(data.data(), data.size(), options) {}
+
+json_value cbor_decoder::decode() {
+    json_value result = decode_item();
+    if (pos_ != size_) {
+        throw std::runtime_error("Unexpected data after CBOR item at offset " + std::to_string(pos_));
+    }
+
+    return result;
+}
+
+std::uint8_t cbor_decoder::consume() {
+    if (pos_ >= size_) {
+        throw std::runtime_error("Unexpected end of CBOR input at offset " + std::to_string(pos_));
+    }
+
+    return data_[pos_++];
+}
+
+std::uint64_t cbor_decoder::read_uint(size_t bytes) {
+    if (size_ - pos_ < bytes) {
+        throw std::runtime_error("Unexpected end of CBOR input at offset " + std::to_string(pos_));
+    }
+
+    std::uint64_t result = 0;
+    for (size_t i = 0; i < bytes; ++i) {
+        result = (result << 8) | data_[pos_++];
+    }
+
+    return result;
+}
+
+std::uint64_t cbor_decoder::read_argument(std::uint8_t info) {
+    if (info < 24) {
+        return info;
+    }
+
+    if (info <= 27) {
+        return read_uint(size_t(1) << (info - 24));
+    }
+
+    throw std::runtime_error("Invalid CBOR additional information at offset " + std::to_string(pos_ - 1));
+}
+
+bool cbor_decoder::at_break() const {
+    return pos_ < size_ && data_[pos_] == break_code;
+}
+
+// Arrays and maps recurse, bounded by max_depth_; tags are skipped in a
+// loop, since any number of them may precede an item
+json_value cbor_decoder::decode_item() {
+    std::uint8_t initial = consume();
+    while ((initial >> 5) == major_tag) {
+        read_argument(initial & 0x1f);
+        initial = consume();
+    }
+
+    std::uint8_t major = initial >> 5;
+    std::uint8_t info = initial & 0x1f;
+    if ((major == major_array || major == major_map) && depth_ >= max_depth_) {
+        throw std::runtime_error("CBOR nesting exceeds maximum depth at offset " + std::to_string(pos_ - 1));
+    }
+
+    switch (major) {
+        case major_unsigned:
+            return json_value(static_cast<double>(read_argument(info)));
+        case major_negative:
+            return json_value(-1.0 - static_cast<double>(read_argument(info)));
+        case major_bytes:
+            throw std::runtime_error("CBOR byte strings are not supported at offset " + std::to_string(pos_ - 1));
+        case major_text:
+            return json_value(decode_text(info));
+        case major_array:
+        case major_map: {
+            ++depth_;
+            json_value result = major == major_array ? decode_array(info) : decode_object(info);
+            --depth_;
+            return result;
+        }
+        default:
+            return decode_simple(info);
+    }
+}
+
+std::string cbor_decoder::decode_text(std::uint8_t info) {
+    if (info == info_indefinite) {
+        std::string s;
+        while (!at_break()) {
+            std::uint8_t initial = consume();
+            if ((initial >> 5) != major_text || (initial & 0x1f) == info_indefinite) {
+                throw std::runtime_error("Invalid chunk in indefinite CBOR string at offset " + std::to_string(pos_ - 1));
+            }
+
+            s += decode_text(initial & 0x1f);
+        }
+
+        consume(); // Consume break
+        return s;
+    }
+
+    std::uint64_t length = read_argument(info);
+    if (length > size_ - pos_) {
+        throw std::runtime_error("CBOR string exceeds input at offset " + std::to_string(pos_));
+    }
+
+    // Built straight from the input buffer; the result is moved into the tree
+    std::string s(reinterpret_cast<const char*>(data_ + pos_), static_cast<size_t>(length));
+    pos_ += static_cast<size_t>(length);
+    return s;
+}
+
+json_value cbor_decoder::decode_array(std::uint8_t info) {
+    json_value result = json_value::make_array();
+    json_array& arr = result.as_array();
+    if (info == info_indefinite) {
+        while (!at_break()) {
+            arr.add_value(decode_item());
+        }
+
+        consume(); // Consume break
+        return result;
+    }
+
+    std::uint64_t count = read_argument(info);
+    for (std::uint64_t i = 0; i < count; ++i) {
+        arr.add_value(decode_item());
+    }
+
+    return result;
+}
+
+json_value cbor_decoder::decode_object(std::uint8_t info) {
+    json_value result = json_value::make_object();
+    json_object& obj = result.as_object();
+    bool indefinite = info == info_indefinite;
+    std::uint64_t count = indefinite ? 0 : read_argument(info);
+    for (std::uint64_t i = 0; indefinite ? !at_break() : i < count; ++i) {
+        std::uint8_t initial = consume();
+        if ((initial >> 5) != major_text) {
+            throw std::runtime_error("CBOR map key is not a text string at offset " + std::to_string(pos_ - 1));
+        }
+
+        std::string key = decode_text(initial & 0x1f);
+        obj.set_value(key, decode_item());
+    }
+
+    if (indefinite) {
+        consume(); // Consume break
+    }
+
+    return result;
+}
+
+json_value cbor_decoder::decode_simple(std::uint8_t info) {
+    switch (info) {
+        case 20:
+            return json_value(false);
+        case 21:
+            return json_value(true);
+        case 22:
+        case 23:
+            return json_value(nullptr);
+        case 25:
+            return json_value(decode_half(static_cast<std::uint16_t>(read_uint(2))));
+        case 26: {
+            std::uint32_t bits = static_cast<std::uint32_t>(read_uint(4));
+            float value;
+            std::memcpy(&value, &bits, sizeof(value));
+            return json_value(static_cast<double>(value));
+        }
+        case 27: {
+            std::uint64_t bits = read_uint(8);
+            double value;
+            std::memcpy(&value, &bits, sizeof(value));
+            return json_value(value);
+        }
+        case info_indefinite:
+            throw std::runtime_error("Unexpected CBOR break at offset " + std::to_string(pos_ - 1));
+        default:
+            throw std::runtime_error("Unsupported CBOR simple value at offset " + std::to_string(pos_ - 1));
+    }
+}
@@ -0,0 +1,78 @@
+#include "../../include/formats/const_json.hpp"
+#include "../../include/parser/tree_builder.hpp"
+#include <cstdlib>
+#include <vector>
+
+// const_json_view implementations
+double const_json_view::parse_number() const {
+    std::string lexeme(chars_ + node().begin, node().size);
+    return std::strtod(lexeme.c_str(), nullptr);
+}
+
+// Replays the nodes as parse events, so the result is laid out exactly as
+// json::parse would build it (including packed arrays)
+json_value const_json_view::to_value() const {
+    struct frame {
+        size_t remaining;
+        bool is_object;
+        bool expecting_key;
+    };
+
+    json_value result;
+    tree_builder builder(result);
+    std::vector<frame> stack;
+    std::string text;
+    size_t end = node().next;
+    for (size_t index = index_; index < end; ++index) {
+        const const_json_node& current = nodes_[index];
+        if (!stack.empty() && stack.back().expecting_key) {
+            text.assign(chars_ + current.begin, current.size);
+            builder.key(text);
+            stack.back().expecting_key = false;
+            continue;
+        }
+
+        switch (current.type) {
+            case json_type::null:
+                builder.null_value();
+                break;
+            case json_type::boolean:
+                builder.boolean_value(current.boolean);
+                break;
+            case json_type::number:
+                text.assign(chars_ + current.begin, current.size);
+                builder.number_value(text);
+                break;
+            case json_type::string:
+                text.assign(chars_ + current.begin, current.size);
+                builder.string_value(text);
+                break;
+            case json_type::array:
+            case json_type::object: {
+                bool is_object = current.type == json_type::object;
+                is_object ? builder.begin_object() : builder.begin_array();
+                if (current.size != 0) {
+                    stack.push_back({current.size, is_object, is_object});
+                    continue;
+                }
+
+                is_object ? builder.end_object() : builder.end_array();
+                break;
+            }
+        }
+
+        // A value is complete; close every container it completes
+        while (!stack.empty()) {
+            frame& top = stack.back();
+            top.expecting_key = top.is_object;
+            if (--top.remaining != 0) {
+                break;
+            }
+
+            top.is_object ? builder.end_object() : builder.end_array();
+            stack.pop_back();
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,550 @@
+#include "../../include/formats/tape.hpp"
+#include "../../include/types/json_null.hpp"
+#include "../../include/types/json_boolean.hpp"
+#include "../../include/types/json_number.hpp"
+#include "../../include/types/json_string.hpp"
+#include "../../include/types/json_array.hpp"
+#include "../../include/types/json_object.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+    constexpr char tape_magic[8] = {'J', 'S', 'O', 'N', 'T', 'A', 'P', 'E'};
+    constexpr std::uint32_t tape_version = 1;
+    constexpr std::uint32_t byte_order_mark = 0x01020304;
+
+    constexpr std::uint64_t tag_null = 0;
+    constexpr std::uint64_t tag_false = 1;
+    constexpr std::uint64_t tag_true = 2;
+    constexpr std::uint64_t tag_number = 3;
+    constexpr std::uint64_t tag_string = 4;
+    constexpr std::uint64_t tag_array = 5;
+    constexpr std::uint64_t tag_object = 6;
+
+    // Same limit as parse_options::max_depth by default
+    constexpr size_t max_depth = 1000;
+
+    constexpr int payload_bits = 56;
+    constexpr std::uint64_t payload_mask = (std::uint64_t(1) << payload_bits) - 1;
+
+    struct file_header {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t byte_order;
+        std::uint64_t root;
+        std::uint64_t tape_offset;
+        std::uint64_t tape_count;
+        std::uint64_t numbers_offset;
+        std::uint64_t numbers_count;
+        std::uint64_t strings_offset;
+        std::uint64_t strings_size;
+    };
+
+    std::uint64_t make_word(std::uint64_t tag, std::uint64_t payload) {
+        if (payload > payload_mask) {
+            throw std::runtime_error("Document too large for tape format");
+        }
+
+        return (tag << payload_bits) | payload;
+    }
+
+    std::uint64_t word_tag(std::uint64_t word) {
+        return word >> payload_bits;
+    }
+
+    file_header make_header(std::uint64_t root, size_t tape_count, size_t numbers_count, size_t strings_size) {
+        file_header header{};
+        std::memcpy(header.magic, tape_magic, sizeof(tape_magic));
+        header.version = tape_version;
+        header.byte_order = byte_order_mark;
+        header.root = root;
+        header.tape_offset = sizeof(file_header);
+        header.tape_count = tape_count;
+        header.numbers_offset = header.tape_offset + tape_count * sizeof(std::uint64_t);
+        header.numbers_count = numbers_count;
+        header.strings_offset = header.numbers_offset + numbers_count * sizeof(double);
+        header.strings_size = strings_size;
+        return header;
+    }
+
+    bool section_fits(std::uint64_t offset, std::uint64_t count, std::uint64_t width, size_t size) {
+        return offset <= size && count <= (size - offset) / width;
+    }
+}
+
+// tape_writer implementations
+tape_writer::tape_writer(const json_value& root) : root_(0) {
+    root_ = emit(root);
+}
+
+void tape_writer::write(std::vector<std::uint8_t>& out) const {
+    file_header header = make_header(root_, tape_.size(), numbers_.size(), strings_.size());
+    size_t start = out.size();
+    out.resize(start + header.strings_offset + strings_.size());
+    std::uint8_t* base = out.data() + start;
+    std::memcpy(base, &header, sizeof(header));
+    std::memcpy(base + header.tape_offset, tape_.data(), tape_.size() * sizeof(std::uint64_t));
+    std::memcpy(base + header.numbers_offset, numbers_.data(), numbers_.size() * sizeof(double));
+    std::memcpy(base + header.strings_offset, strings_.data(), strings_.size());
+}
+
+void tape_writer::write_file(const std::string& file_path) const {
+    std::ofstream file(file_path, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Cannot open file for writing: " + file_path);
+    }
+
+    file_header header = make_header(root_, tape_.size(), numbers_.size(), strings_.size());
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(tape_.data()), tape_.size() * sizeof(std::uint64_t));
+    file.write(reinterpret_cast<const char*>(numbers_.data()), numbers_.size() * sizeof(double));
+    file.write(strings_.data(), strings_.size());
+    if (!file) {
+        throw std::runtime_error("Failed to write tape file: " + file_path);
+    }
+}
+
+std::uint64_t tape_writer::emit(const json_value& value) {
+    switch (value.type()) {
+        case json_type::null:
+            return make_word(tag_null, 0);
+        case json_type::boolean:
+            return make_word(value.as_boolean().get_value() ? tag_true : tag_false, 0);
+        case json_type::number:
+            numbers_.push_back(value.as_number().get_value());
+            return make_word(tag_number, numbers_.size() - 1);
+        case json_type::string:
+            return make_word(tag_string, emit_string(value.as_string().get_value()));
+        case json_type::array: {
+            const json_array& arr = value.as_array();
+            size_t record = tape_.size();
+            tape_.resize(record + 1 + arr.size());
+            tape_[record] = arr.size();
+            size_t slot = record + 1;
+            if (arr.get_packing() == json_array::packing::numbers) {
+                for (double number : arr.numbers()) {
+                    numbers_.push_back(number);
+                    tape_[slot++] = make_word(tag_number, numbers_.size() - 1);
+                }
+            }
+            else if (arr.get_packing() == json_array::packing::booleans) {
+                for (std::uint8_t boolean : arr.booleans()) {
+                    tape_[slot++] = make_word(boolean ? tag_true : tag_false, 0);
+                }
+            }
+            else {
+                for (const auto& elem : arr) {
+                    std::uint64_t word = emit(elem);
+                    tape_[slot++] = word;
+                }
+            }
+
+            return make_word(tag_array, record);
+        }
+        case json_type::object: {
+            const json_object& obj = value.as_object();
+            std::vector<std::pair<const std::string*, const json_value*>> entries;
+            entries.reserve(obj.size());
+            for (const auto& entry : obj) {
+                entries.push_back({&entry.first, &entry.second});
+            }
+
+            std::sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) {
+                return *a.first < *b.first;
+            });
+
+            size_t record = tape_.size();
+            tape_.resize(record + 1 + 2 * entries.size());
+            tape_[record] = entries.size();
+            size_t slot = record + 1;
+            for (const auto& entry : entries) {
+                tape_[slot++] = make_word(tag_string, emit_string(*entry.first));
+                std::uint64_t word = emit(*entry.second);
+                tape_[slot++] = word;
+            }
+
+            return make_word(tag_object, record);
+        }
+    }
+
+    return make_word(tag_null, 0);
+}
+
+std::uint64_t tape_writer::emit_string(const std::string& value) {
+    auto it = string_offsets_.find(value);
+    if (it != string_offsets_.end()) {
+        return it->second;
+    }
+
+    if (value.size() > UINT32_MAX) {
+        throw std::runtime_error("String too large for tape format");
+    }
+
+    std::uint64_t offset = strings_.size();
+    std::uint32_t length = static_cast<std::uint32_t>(value.size());
+    strings_.append(reinterpret_cast<const char*>(&length), sizeof(length));
+    strings_.append(value);
+    string_offsets_.emplace(value, offset);
+    return offset;
+}
+
+// tape_view implementations
+tape_view::tape_view(const tape_document& doc, std::uint64_t word) : doc_(&doc), word_(word) {}
+
+json_type tape_view::type() const {
+    switch (word_tag(word_)) {
+        case tag_null:
+            return json_type::null;
+        case tag_false:
+        case tag_true:
+            return json_type::boolean;
+        case tag_number:
+            return json_type::number;
+        case tag_string:
+            return json_type::string;
+        case tag_array:
+            return json_type::array;
+        case tag_object:
+            return json_type::object;
+        default:
+            throw std::runtime_error("Corrupt tape: unknown tag");
+    }
+}
+
+bool tape_view::is_null() const { return type() == json_type::null; }
+bool tape_view::is_boolean() const { return type() == json_type::boolean; }
+bool tape_view::is_number() const { return type() == json_type::number; }
+bool tape_view::is_string() const { return type() == json_type::string; }
+bool tape_view::is_array() const { return type() == json_type::array; }
+bool tape_view::is_object() const { return type() == json_type::object; }
+
+bool tape_view::as_boolean() const {
+    if (!is_boolean()) {
+        throw std::runtime_error("Value is not boolean");
+    }
+
+    return word_tag(word_) == tag_true;
+}
+
+double tape_view::as_number() const {
+    if (!is_number()) {
+        throw std::runtime_error("Value is not number");
+    }
+
+    if (payload() >= doc_->numbers_count_) {
+        throw std::runtime_error("Corrupt tape: number index out of range");
+    }
+
+    return doc_->numbers_[payload()];
+}
+
+std::string_view tape_view::as_string() const {
+    if (!is_string()) {
+        throw std::runtime_error("Value is not string");
+    }
+
+    return doc_->string_at(payload());
+}
+
+size_t tape_view::size() const {
+    if (!is_array() && !is_object()) {
+        throw std::runtime_error("Value is not a container");
+    }
+
+    return static_cast<size_t>(record()[0]);
+}
+
+tape_view tape_view::operator[](size_t index) const {
+    if (!is_array()) {
+        throw std::runtime_error("Value is not array");
+    }
+
+    const std::uint64_t* rec = record();
+    if (index >= rec[0]) {
+        throw std::out_of_range("Index out of range: " + std::to_string(index));
+    }
+
+    return child(rec, rec[1 + index]);
+}
+
+tape_view tape_view::operator[](std::string_view key) const {
+    std::uint64_t word;
+    if (!find(key, word)) {
+        throw std::out_of_range("Key not found: " + std::string(key));
+    }
+
+    return child(record(), word);
+}
+
+bool tape_view::contains(std::string_view key) const {
+    std::uint64_t word;
+    return find(key, word);
+}
+
+std::string_view tape_view::key_at(size_t index) const {
+    if (!is_object()) {
+        throw std::runtime_error("Value is not object");
+    }
+
+    const std::uint64_t* rec = record();
+    if (index >= rec[0]) {
+        throw std::out_of_range("Index out of range: " + std::to_string(index));
+    }
+
+    return doc_->string_at(rec[1 + 2 * index] & payload_mask);
+}
+
+tape_view tape_view::value_at(size_t index) const {
+    if (!is_object()) {
+        throw std::runtime_error("Value is not object");
+    }
+
+    const std::uint64_t* rec = record();
+    if (index >= rec[0]) {
+        throw std::out_of_range("Index out of range: " + std::to_string(index));
+    }
+
+    return child(rec, rec[2 + 2 * index]);
+}
+
+json_value tape_view::to_value() const {
+    return to_value(0);
+}
+
+json_value tape_view::to_value(size_t depth) const {
+    switch (type()) {
+        case json_type::null:
+            return json_value(nullptr);
+        case json_type::boolean:
+            return json_value(as_boolean());
+        case json_type::number:
+            return json_value(as_number());
+        case json_type::string:
+            return json_value(std::string(as_string()));
+        case json_type::array: {
+            if (depth == max_depth) {
+                throw std::runtime_error("Corrupt tape: nesting too deep");
+            }
+
+            json_value result = json_value::make_array();
+            json_array& arr = result.as_array();
+            size_t count = size();
+            for (size_t i = 0; i < count; ++i) {
+                arr.add_value((*this)[i].to_value(depth + 1));
+            }
+
+            return result;
+        }
+        case json_type::object: {
+            if (depth == max_depth) {
+                throw std::runtime_error("Corrupt tape: nesting too deep");
+            }
+
+            json_value result = json_value::make_object();
+            json_object& obj = result.as_object();
+            size_t count = size();
+            for (size_t i = 0; i < count; ++i) {
+                obj.set_value(std::string(key_at(i)), value_at(i).to_value(depth + 1));
+            }
+
+            return result;
+        }
+    }
+
+    return json_value(nullptr);
+}
+
+std::uint64_t tape_view::payload() const {
+    return word_ & payload_mask;
+}
+
+const std::uint64_t* tape_view::record() const {
+    std::uint64_t index = payload();
+    if (index >= doc_->tape_count_) {
+        throw std::runtime_error("Corrupt tape: record out of range");
+    }
+
+    const std::uint64_t* rec = doc_->tape_ + index;
+    std::uint64_t width = word_tag(word_) == tag_object ? 2 : 1;
+    std::uint64_t available = doc_->tape_count_ - index - 1;
+    if (rec[0] > available / width) {
+        throw std::runtime_error("Corrupt tape: record exceeds tape");
+    }
+
+    return rec;
+}
+
+tape_view tape_view::child(const std::uint64_t* rec, std::uint64_t word) const {
+    std::uint64_t tag = word_tag(word);
+    if (tag == tag_array || tag == tag_object) {
+        // The writer appends a container's record after its parent's
+        std::uint64_t width = word_tag(word_) == tag_object ? 2 : 1;
+        std::uint64_t end = static_cast<std::uint64_t>(rec - doc_->tape_) + 1 + rec[0] * width;
+        if ((word & payload_mask) < end) {
+            throw std::runtime_error("Corrupt tape: record does not follow its parent");
+        }
+    }
+
+    return tape_view(*doc_, word);
+}
+
+bool tape_view::find(std::string_view key, std::uint64_t& word) const {
+    if (!is_object()) {
+        throw std::runtime_error("Value is not object");
+    }
+
+    const std::uint64_t* rec = record();
+    size_t low = 0;
+    size_t high = static_cast<size_t>(rec[0]);
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        std::string_view candidate = doc_->string_at(rec[1 + 2 * mid] & payload_mask);
+        int cmp = candidate.compare(key);
+        if (cmp == 0) {
+            word = rec[2 + 2 * mid];
+            return true;
+        }
+
+        if (cmp < 0) {
+            low = mid + 1;
+        }
+        else {
+            high = mid;
+        }
+    }
+
+    return false;
+}
+
+// tape_document implementations
+tape_document::tape_document()
+    : mapping_(nullptr), mapping_size_(0), tape_(nullptr), tape_count_(0),
+      numbers_(nullptr), numbers_count_(0), strings_(nullptr), strings_size_(0), root_(0) {}
+
+tape_document::tape_document(const std::uint8_t* data, size_t size) : tape_document() {
+    load(data, size);
+}
+
+tape_document::tape_document(tape_document&& other) noexcept
+    : mapping_(other.mapping_), mapping_size_(other.mapping_size_), tape_(other.tape_),
+      tape_count_(other.tape_count_), numbers_(other.numbers_), numbers_count_(other.numbers_count_),
+      strings_(other.strings_), strings_size_(other.strings_size_), root_(other.root_) {
+    other.mapping_ = nullptr;
+    other.mapping_size_ = 0;
+}
+
+tape_document& tape_document::operator=(tape_document&& other) noexcept {
+    if (this != &other) {
+        unmap();
+        mapping_ = other.mapping_;
+        mapping_size_ = other.mapping_size_;
+        tape_ = other.tape_;
+        tape_count_ = other.tape_count_;
+        numbers_ = other.numbers_;
+        numbers_count_ = other.numbers_count_;
+        strings_ = other.strings_;
+        strings_size_ = other.strings_size_;
+        root_ = other.root_;
+        other.mapping_ = nullptr;
+        other.mapping_size_ = 0;
+    }
+
+    return *this;
+}
+
+tape_document::~tape_document() {
+    unmap();
+}
+
+tape_document tape_document::open(const std::string& file_path) {
+    int fd = ::open(file_path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open file: " + file_path);
+    }
+
+    struct stat info;
+    if (::fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(file_header))) {
+        ::close(fd);
+        throw std::runtime_error("Invalid tape file: " + file_path);
+    }
+
+    size_t size = static_cast<size_t>(info.st_size);
+    void* mapping = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        throw std::runtime_error("Cannot map file: " + file_path);
+    }
+
+    tape_document doc;
+    doc.mapping_ = mapping;
+    doc.mapping_size_ = size;
+    doc.load(static_cast<const std::uint8_t*>(mapping), size);
+    return doc;
+}
+
+tape_view tape_document::root() const {
+    return tape_view(*this, root_);
+}
+
+void tape_document::load(const std::uint8_t* data, size_t size) {
+    if (reinterpret_cast<std::uintptr_t>(data) % alignof(std::uint64_t) != 0) {
+        throw std::runtime_error("Tape buffer must be 8-byte aligned");
+    }
+
+    file_header header;
+    if (size < sizeof(header)) {
+        throw std::runtime_error("Invalid tape: truncated header");
+    }
+
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, tape_magic, sizeof(tape_magic)) != 0) {
+        throw std::runtime_error("Invalid tape: bad magic");
+    }
+
+    if (header.version != tape_version || header.byte_order != byte_order_mark) {
+        throw std::runtime_error("Invalid tape: unsupported version or byte order");
+    }
+
+    if (header.tape_offset % sizeof(std::uint64_t) != 0 || header.numbers_offset % sizeof(double) != 0
+        || !section_fits(header.tape_offset, header.tape_count, sizeof(std::uint64_t), size)
+        || !section_fits(header.numbers_offset, header.numbers_count, sizeof(double), size)
+        || !section_fits(header.strings_offset, header.strings_size, 1, size)) {
+        throw std::runtime_error("Invalid tape: section out of range");
+    }
+
+    tape_ = reinterpret_cast<const std::uint64_t*>(data + header.tape_offset);
+    tape_count_ = header.tape_count;
+    numbers_ = reinterpret_cast<const double*>(data + header.numbers_offset);
+    numbers_count_ = header.numbers_count;
+    strings_ = reinterpret_cast<const char*>(data + header.strings_offset);
+    strings_size_ = header.strings_size;
+    root_ = header.root;
+}
+
+void tape_document::unmap() {
+    if (mapping_) {
+        ::munmap(mapping_, mapping_size_);
+        mapping_ = nullptr;
+        mapping_size_ = 0;
+    }
+}
+
+std::string_view tape_document::string_at(std::uint64_t offset) const {
+    std::uint32_t length;
+    if (offset > strings_size_ || strings_size_ - offset < sizeof(length)) {
+        throw std::runtime_error("Corrupt tape: string offset out of range");
+    }
+
+    std::memcpy(&length, strings_ + offset, sizeof(length));
+    if (strings_size_ - offset - sizeof(length) < length) {
+        throw std::runtime_error("Corrupt tape: string exceeds pool");
+    }
+
+    return std::string_view(strings_ + offset + sizeof(length), length);
+}
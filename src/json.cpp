@@ -1,5 +1,8 @@
 #include "../include/json.hpp"
 #include "../include/parser/parser.hpp"
+#include "../include/parser/json_validator.hpp"
+#include "../include/formats/cbor.hpp"
+#include "../include/formats/tape.hpp"
 #include "../include/types/json_array.hpp"
 #include "../include/types/json_object.hpp"
 
@@ -29,14 +32,34 @@ json& json::operator=(json&& other) noexcept {
     return *this;
 }
 
-json json::parse(const std::string& json_string) {
+json json::parse(const std::string& json_string, const parse_options& options) {
     json result;
-    parser p(json_string);
+    parser p(json_string, options);
     result.json_data_ = p.parse();
     
     return result;
 }
 
+parse_result json::try_parse(const std::string& json_string, const parse_options& options) noexcept {
+    parser p(json_string, options);
+    return p.try_parse();
+}
+
+void json::parse_into(json& target, const std::string& json_string, const parse_options& options) {
+    parser p(json_string, options);
+    p.parse_into(target.json_data_);
+}
+
+parse_result json::try_parse_into(json& target, const std::string& json_string, const parse_options& options) noexcept {
+    parser p(json_string, options);
+    return p.try_parse_into(target.json_data_);
+}
+
+parse_status json::validate(const char* data, size_t size, const parse_options& options) noexcept {
+    json_validator validator(data, size, options);
+    return validator.run();
+}
+
 json json::object() {
     json result;
     result.json_data_ = json_value::make_object();
@@ -51,7 +74,15 @@ json json::array() {
     return result;
 }
 
-json::json(const std::string& file_path) {
+json json::from_cbor(const std::vector<std::uint8_t>& data, const parse_options& options) {
+    json result;
+    cbor_decoder decoder(data, options);
+    result.json_data_ = decoder.decode();
+
+    return result;
+}
+
+json::json(const std::string& file_path, const parse_options& options) {
     std::ifstream file(file_path);
     if (!file.is_open()) {
         throw std::runtime_error("Cannot open file: " + file_path);
@@ -62,12 +93,13 @@ json::json(const std::string& file_path) {
     std::string content = buffer.str();
     file.close();
 
-    try {
-        parser p(content);
-        json_data_ = p.parse();
-    } catch (const std::exception& e) {
-        throw std::runtime_error("Failed to parse JSON file: " + std::string(e.what()));
+    parser p(content, options);
+    parse_result result = p.try_parse();
+    if (!result) {
+        throw std::runtime_error("Failed to parse JSON file: " + file_path + ": " + result.describe());
     }
+
+    json_data_ = std::move(result.value());
 }
 
 json_value& json::get_json() {
@@ -78,8 +110,10 @@ const json_value& json::get_json() const {
     return json_data_;
 }
 
-std::string json::get_context(int indent) const {
-    return json_data_.dump(indent);
+std::string json::get_context(int indent, bool ascii_only, bool memoize) const {
+    std::string out;
+    json_data_.dump_to(out, indent, 0, ascii_only, memoize);
+    return out;
 }
 
 void json::write_file(const std::string& file_path, int indent) const {
@@ -88,6 +122,21 @@ void json::write_file(const std::string& file_path, int indent) const {
         throw std::runtime_error("Cannot open file for writing: " + file_path);
     }
 
-    file << json_data_.dump(indent);
+    std::string out;
+    json_data_.dump_to(out, indent);
+    file << out;
     file.close();
 }
+
+std::vector<std::uint8_t> json::to_cbor() const {
+    std::vector<std::uint8_t> out;
+    cbor_encoder encoder(out);
+    encoder.encode(json_data_);
+
+    return out;
+}
+
+void json::write_tape(const std::string& file_path) const {
+    tape_writer writer(json_data_);
+    writer.write_file(file_path);
+}
@@ -0,0 +1,11 @@
+#include "../../include/parser/json_handler.hpp"
+#include <tuple>
+
+void json_handler::container_source(size_t begin, size_t end) {
+    std::ignore = begin;
+    std::ignore = end;
+}
+
+parse_error json_handler::failure() const {
+    return parse_error::rejected_by_handler;
+}
@@ -0,0 +1,473 @@
+#include "../../include/parser/json_validator.hpp"
+#include "../../include/utils/string_scanner.hpp"
+#include "../../include/utils/utf8.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+    bool is_digit(char c) {
+        return c >= '0' && c <= '9';
+    }
+
+    bool is_alpha(char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+    }
+
+    size_t encoded_length(std::uint32_t code_point) {
+        return code_point < 0x80 ? 1 : code_point < 0x800 ? 2 : code_point < 0x10000 ? 3 : 4;
+    }
+}
+
+json_validator::json_validator(const char* data, size_t size, const parse_options& options)
+    : data_(data), size_(size), pos_(0), options_(options), type_(token_type::end), offset_(0) {}
+
+// The state machine of parser::run over tokens that keep only their type
+// and offset
+parse_status json_validator::run() {
+    if (size_ > options_.max_document_size) {
+        return {parse_error::document_too_large, options_.max_document_size};
+    }
+
+    enum class state { value, key, after_value };
+
+    size_t max_depth = std::min(options_.max_depth, max_nesting);
+    size_t depth = 0;
+    if (!next_token()) {
+        return status_;
+    }
+
+    state current = state::value;
+    while (true) {
+        if (current == state::value) {
+            if (type_ == token_type::l_brace || type_ == token_type::l_bracket) {
+                bool is_object = type_ == token_type::l_brace;
+                if (depth >= max_depth) {
+                    return fail(parse_error::depth_limit_exceeded);
+                }
+
+                if (!next_token()) {
+                    return status_;
+                }
+
+                if (type_ == (is_object ? token_type::r_brace : token_type::r_bracket)) {
+                    if (!next_token()) {
+                        return status_;
+                    }
+
+                    current = state::after_value;
+                    continue;
+                }
+
+                std::uint64_t bit = std::uint64_t(1) << (depth % 64);
+                objects_[depth / 64] = is_object ? objects_[depth / 64] | bit : objects_[depth / 64] & ~bit;
+                counts_[depth] = 0;
+                ++depth;
+                current = is_object ? state::key : state::value;
+                continue;
+            }
+
+            if (type_ == token_type::number && !finite_number(offset_)) {
+                return {parse_error::invalid_number, offset_};
+            }
+
+            if (type_ != token_type::string && type_ != token_type::number && type_ != token_type::literal) {
+                return fail(parse_error::expected_value);
+            }
+
+            if (!next_token()) {
+                return status_;
+            }
+
+            current = state::after_value;
+        }
+        else if (current == state::key) {
+            if (type_ != token_type::string) {
+                return fail(parse_error::expected_key);
+            }
+
+            if (!next_token()) {
+                return status_;
+            }
+
+            if (type_ != token_type::colon) {
+                return fail(parse_error::expected_colon);
+            }
+
+            if (!next_token()) {
+                return status_;
+            }
+
+            current = state::value;
+        }
+        else {
+            if (depth == 0) {
+                if (type_ != token_type::end) {
+                    return fail(parse_error::trailing_content);
+                }
+
+                return status_;
+            }
+
+            bool is_object = (objects_[(depth - 1) / 64] >> ((depth - 1) % 64)) & 1;
+            if (++counts_[depth - 1] > options_.max_container_elements) {
+                return fail(parse_error::too_many_elements);
+            }
+
+            if (type_ == token_type::comma) {
+                if (!next_token()) {
+                    return status_;
+                }
+
+                current = is_object ? state::key : state::value;
+                continue;
+            }
+
+            if (type_ != (is_object ? token_type::r_brace : token_type::r_bracket)) {
+                return fail(is_object ? parse_error::expected_comma_or_brace : parse_error::expected_comma_or_bracket);
+            }
+
+            --depth;
+            if (!next_token()) {
+                return status_;
+            }
+        }
+    }
+}
+
+bool json_validator::next_token() {
+    pos_ += string_scanner::whitespace_prefix(data_ + pos_, size_ - pos_);
+    offset_ = pos_;
+    if (pos_ >= size_) {
+        type_ = token_type::end;
+        return true;
+    }
+
+    char c = data_[pos_++];
+    switch (c) {
+        case '{':
+            type_ = token_type::l_brace;
+            break;
+        case '}':
+            type_ = token_type::r_brace;
+            break;
+        case '[':
+            type_ = token_type::l_bracket;
+            break;
+        case ']':
+            type_ = token_type::r_bracket;
+            break;
+        case ':':
+            type_ = token_type::colon;
+            break;
+        case ',':
+            type_ = token_type::comma;
+            break;
+        case '"':
+            scan_string();
+            break;
+        case '-': case '0': case '1': case '2': case '3': case '4':
+        case '5': case '6': case '7': case '8': case '9':
+            --pos_;
+            scan_number();
+            break;
+        default:
+            if (is_alpha(c)) {
+                --pos_;
+                scan_keyword();
+                break;
+            }
+
+            fail_token(parse_error::invalid_character, pos_ - 1);
+            break;
+    }
+
+    return type_ != token_type::error;
+}
+
+// Follows lexer::lex_string, counting the decoded length instead of
+// building the string
+void json_validator::scan_string() {
+    size_t length = 0;
+    while (true) {
+        size_t plain = string_scanner::plain_prefix(data_ + pos_, size_ - pos_, options_.validate_utf8);
+        if (length > options_.max_string_length || plain > options_.max_string_length - length) {
+            fail_token(parse_error::string_too_long, offset_);
+            return;
+        }
+
+        length += plain;
+        pos_ += plain;
+        if (pos_ >= size_) {
+            fail_token(parse_error::unterminated_string, offset_);
+            return;
+        }
+
+        unsigned char c = static_cast<unsigned char>(data_[pos_]);
+        if (c == '"') {
+            if (length > options_.max_string_length) {
+                fail_token(parse_error::string_too_long, offset_);
+                return;
+            }
+
+            break;
+        }
+
+        if (c >= 0x80) {
+            std::uint32_t code_point;
+            size_t sequence = utf8::decode(data_ + pos_, size_ - pos_, code_point);
+            if (sequence == 0) {
+                fail_token(parse_error::invalid_utf8, pos_);
+                return;
+            }
+
+            length += sequence;
+            pos_ += sequence;
+            continue;
+        }
+
+        if (c != '\\') {
+            fail_token(parse_error::control_character, pos_);
+            return;
+        }
+
+        ++pos_;
+        if (pos_ >= size_) {
+            fail_token(parse_error::unterminated_string, offset_);
+            return;
+        }
+
+        switch (data_[pos_++]) {
+            case '"':
+            case '\\':
+            case '/':
+            case 'b':
+            case 'f':
+            case 'n':
+            case 'r':
+            case 't':
+                ++length;
+                break;
+            case 'u': {
+                size_t encoded;
+                if (!scan_unicode_escape(encoded)) {
+                    fail_token(parse_error::invalid_unicode_escape, pos_);
+                    return;
+                }
+
+                length += encoded;
+                break;
+            }
+            default:
+                fail_token(parse_error::invalid_escape, pos_ - 2);
+                return;
+        }
+    }
+
+    ++pos_;
+    type_ = token_type::string;
+}
+
+bool json_validator::scan_unicode_escape(size_t& length) {
+    std::uint32_t unit;
+    if (!scan_hex4(unit) || (unit >= 0xdc00 && unit <= 0xdfff)) {
+        return false;
+    }
+
+    if (unit < 0xd800 || unit > 0xdbff) {
+        length = encoded_length(unit);
+        return true;
+    }
+
+    if (pos_ + 1 >= size_ || data_[pos_] != '\\' || data_[pos_ + 1] != 'u') {
+        return false;
+    }
+
+    pos_ += 2;
+    std::uint32_t low;
+    if (!scan_hex4(low) || low < 0xdc00 || low > 0xdfff) {
+        return false;
+    }
+
+    length = 4;
+    return true;
+}
+
+bool json_validator::scan_hex4(std::uint32_t& value) {
+    value = 0;
+    for (int i = 0; i < 4; ++i) {
+        char c = pos_ < size_ ? data_[pos_] : '\0';
+        std::uint32_t digit;
+        if (c >= '0' && c <= '9') {
+            digit = static_cast<std::uint32_t>(c - '0');
+        }
+        else if (c >= 'a' && c <= 'f') {
+            digit = static_cast<std::uint32_t>(c - 'a' + 10);
+        }
+        else if (c >= 'A' && c <= 'F') {
+            digit = static_cast<std::uint32_t>(c - 'A' + 10);
+        }
+        else {
+            return false;
+        }
+
+        value = (value << 4) | digit;
+        ++pos_;
+    }
+
+    return true;
+}
+
+void json_validator::scan_number() {
+    size_t start = pos_;
+    auto digits = [this]() {
+        while (pos_ < size_ && is_digit(data_[pos_])) {
+            ++pos_;
+        }
+    };
+
+    if (pos_ < size_ && data_[pos_] == '-') {
+        ++pos_;
+    }
+
+    if (pos_ < size_ && data_[pos_] == '0') {
+        ++pos_;
+    }
+    else if (pos_ < size_ && is_digit(data_[pos_])) {
+        digits();
+    }
+    else {
+        fail_token(parse_error::invalid_number, start);
+        return;
+    }
+
+    if (pos_ < size_ && data_[pos_] == '.') {
+        ++pos_;
+        if (pos_ >= size_ || !is_digit(data_[pos_])) {
+            fail_token(parse_error::invalid_number, start);
+            return;
+        }
+
+        digits();
+    }
+
+    if (pos_ < size_ && (data_[pos_] == 'e' || data_[pos_] == 'E')) {
+        ++pos_;
+        if (pos_ < size_ && (data_[pos_] == '+' || data_[pos_] == '-')) {
+            ++pos_;
+        }
+
+        if (pos_ >= size_ || !is_digit(data_[pos_])) {
+            fail_token(parse_error::invalid_number, start);
+            return;
+        }
+
+        digits();
+    }
+
+    type_ = token_type::number;
+}
+
+void json_validator::scan_keyword() {
+    size_t start = pos_;
+    while (pos_ < size_ && is_alpha(data_[pos_])) {
+        ++pos_;
+    }
+
+    size_t length = pos_ - start;
+    if ((length == 4 && (std::memcmp(data_ + start, "true", 4) == 0 || std::memcmp(data_ + start, "null", 4) == 0)) ||
+        (length == 5 && std::memcmp(data_ + start, "false", 5) == 0)) {
+        type_ = token_type::literal;
+        return;
+    }
+
+    fail_token(parse_error::invalid_keyword, start);
+}
+
+// Whether the number ending at pos_ fits in a double, which the parser
+// requires. The decimal exponent of its leading digit decides, except on
+// the boundary of 10^308 where the leading digits are converted.
+bool json_validator::finite_number(size_t start) const {
+    size_t i = start;
+    if (data_[i] == '-') {
+        ++i;
+    }
+
+    size_t integer_begin = i;
+    while (i < pos_ && is_digit(data_[i])) {
+        ++i;
+    }
+
+    size_t integer_end = i;
+    size_t fraction_begin = i;
+    size_t fraction_end = i;
+    if (i < pos_ && data_[i] == '.') {
+        fraction_begin = ++i;
+        while (i < pos_ && is_digit(data_[i])) {
+            ++i;
+        }
+
+        fraction_end = i;
+    }
+
+    long long exponent = 0;
+    if (i < pos_) {
+        bool negative = data_[++i] == '-';
+        if (data_[i] == '+' || data_[i] == '-') {
+            ++i;
+        }
+
+        for (; i < pos_; ++i) {
+            if (exponent < 100000000000000000LL) {
+                exponent = exponent * 10 + (data_[i] - '0');
+            }
+        }
+
+        exponent = negative ? -exponent : exponent;
+    }
+
+    // Position of the first significant digit
+    size_t first = integer_begin;
+    long long magnitude = static_cast<long long>(integer_end - integer_begin) - 1 + exponent;
+    if (data_[integer_begin] == '0') {
+        first = fraction_begin;
+        while (first < fraction_end && data_[first] == '0') {
+            ++first;
+        }
+
+        if (first == fraction_end) {
+            return true;
+        }
+
+        magnitude = exponent - static_cast<long long>(first - fraction_begin) - 1;
+    }
+
+    if (magnitude != 308) {
+        return magnitude < 308;
+    }
+
+    char buffer[64];
+    size_t length = 0;
+    for (size_t j = first; j < fraction_end && length < 40; ++j) {
+        if (is_digit(data_[j])) {
+            buffer[length++] = data_[j];
+            if (length == 1) {
+                buffer[length++] = '.';
+            }
+        }
+    }
+
+    std::memcpy(buffer + length, "e308", 5);
+    return !std::isinf(std::strtod(buffer, nullptr));
+}
+
+void json_validator::fail_token(parse_error error, size_t offset) {
+    type_ = token_type::error;
+    status_ = {error, offset};
+}
+
+// As parser::fail: the end of input is reported as such
+parse_status json_validator::fail(parse_error error) {
+    return {type_ == token_type::end ? parse_error::unexpected_end : error, offset_};
+}
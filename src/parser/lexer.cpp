@@ -1,42 +1,84 @@
 #include "../../include/parser/lexer.hpp"
+#include "../../include/utils/string_scanner.hpp"
+#include "../../include/utils/utf8.hpp"
 
-lexer::lexer(const std::string& input) : input_(input), pos_(0) {}
+namespace {
+    bool is_digit(char c) {
+        return c >= '0' && c <= '9';
+    }
+
+    bool is_alpha(char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+    }
+}
+
+lexer::lexer(const std::string& input, const parse_options& options)
+    : input_(input), pos_(0), validate_utf8_(options.validate_utf8),
+      max_string_length_(options.max_string_length), error_(parse_error::none), error_offset_(0) {}
 
 lexer::token lexer::next_token() {
+    token tok;
+    next_token(tok);
+    return tok;
+}
+
+// Fills tok in place so that a caller reusing one token keeps its string capacity
+void lexer::next_token(token& tok) {
     skip_whitespace();
+    tok.value.clear();
+    tok.offset = pos_;
     if (pos_ >= input_.size()) {
-        return {token_type::end, ""};
+        tok.type = token_type::end;
+        return;
     }
 
     char c = consume();
     switch (c) {
-        case '{': 
-            return {token_type::l_brace, "{"};
-        case '}': 
-            return {token_type::r_brace, "}"};
-        case '[': 
-            return {token_type::l_bracket, "["};
-        case ']': 
-            return {token_type::r_bracket, "]"};
-        case ':': 
-            return {token_type::colon, ":"};
-        case ',': 
-            return {token_type::comma, ","};
-        case '"': 
-            return lex_string();
+        case '{':
+            tok.type = token_type::l_brace;
+            return;
+        case '}':
+            tok.type = token_type::r_brace;
+            return;
+        case '[':
+            tok.type = token_type::l_bracket;
+            return;
+        case ']':
+            tok.type = token_type::r_bracket;
+            return;
+        case ':':
+            tok.type = token_type::colon;
+            return;
+        case ',':
+            tok.type = token_type::comma;
+            return;
+        case '"':
+            lex_string(tok);
+            return;
         case '-': case '0': case '1': case '2': case '3': case '4':
         case '5': case '6': case '7': case '8': case '9':
-            --pos_; return lex_number();
+            --pos_;
+            lex_number(tok);
+            return;
         default:
-            if (std::isalpha(c)) {
-                --pos_; 
-                return lex_keyword();
+            if (is_alpha(c)) {
+                --pos_;
+                lex_keyword(tok);
+                return;
             }
-            
-            throw std::runtime_error("Invalid character '" + std::string(1, c) + "' at position " + std::to_string(pos_));
+
+            fail(tok, parse_error::invalid_character, pos_ - 1);
     }
 }
 
+parse_error lexer::error() const {
+    return error_;
+}
+
+size_t lexer::error_offset() const {
+    return error_offset_;
+}
+
 char lexer::peek() const {
     return pos_ < input_.size() ? input_[pos_] : '\0';
 }
@@ -46,108 +88,245 @@ char lexer::consume() {
 }
 
 void lexer::skip_whitespace() {
-    while (pos_ < input_.size() && std::isspace(input_[pos_])) {
+    while (pos_ < input_.size()) {
+        char c = input_[pos_];
+        if (c != ' ' && c != '\n' && c != '\r' && c != '\t') {
+            break;
+        }
+
         ++pos_;
     }
 }
 
-lexer::token lexer::lex_string() {
-    std::string s;
-    while (pos_ < input_.size() && input_[pos_] != '"') {
-        char c = consume();
-        if (c == '\\') {
-            if (pos_ >= input_.size()) throw std::runtime_error("Incomplete escape sequence at position " + std::to_string(pos_));
-            c = consume();
-            switch (c) {
-                case '"': 
-                    s += '"'; 
-                    break;
-                case '\\': 
-                    s += '\\'; 
-                    break;
-                case '/': 
-                    s += '/'; 
-                    break;
-                case 'b': 
-                    s += '\b'; 
-                    break;
-                case 'f': 
-                    s += '\f';
-                    break;
-                case 'n': 
-                    s += '\n';
-                    break;
-                case 'r': 
-                    s += '\r'; 
-                    break;
-                case 't': 
-                    s += '\t'; 
-                    break;
-                default: 
-                    throw std::runtime_error("Invalid escape sequence '\\" + std::string(1, c) + "' at position " + std::to_string(pos_ - 1));
+void lexer::lex_string(token& tok) {
+    std::string& s = tok.value;
+    while (true) {
+        // Plain runs are copied in bulk; the scan stops on anything that
+        // needs attention, including non-ASCII bytes when validating
+        size_t plain = string_scanner::plain_prefix(input_.data() + pos_, input_.size() - pos_, validate_utf8_);
+        if (s.size() > max_string_length_ || plain > max_string_length_ - s.size()) {
+            fail(tok, parse_error::string_too_long, tok.offset);
+            return;
+        }
+
+        s.append(input_, pos_, plain);
+        pos_ += plain;
+        if (pos_ >= input_.size()) {
+            fail(tok, parse_error::unterminated_string, tok.offset);
+            return;
+        }
+
+        unsigned char c = static_cast<unsigned char>(input_[pos_]);
+        if (c == '"') {
+            if (s.size() > max_string_length_) {
+                fail(tok, parse_error::string_too_long, tok.offset);
+                return;
             }
-        } 
-        else {
-            s += c;
+
+            break;
+        }
+
+        if (c >= 0x80) {
+            std::uint32_t code_point;
+            size_t length = utf8::decode(input_.data() + pos_, input_.size() - pos_, code_point);
+            if (length == 0) {
+                fail(tok, parse_error::invalid_utf8, pos_);
+                return;
+            }
+
+            s.append(input_, pos_, length);
+            pos_ += length;
+            continue;
+        }
+
+        if (c != '\\') {
+            fail(tok, parse_error::control_character, pos_);
+            return;
+        }
+
+        consume();
+        if (pos_ >= input_.size()) {
+            fail(tok, parse_error::unterminated_string, tok.offset);
+            return;
+        }
+
+        char escape = consume();
+        switch (escape) {
+            case '"':
+                s += '"';
+                break;
+            case '\\':
+                s += '\\';
+                break;
+            case '/':
+                s += '/';
+                break;
+            case 'b':
+                s += '\b';
+                break;
+            case 'f':
+                s += '\f';
+                break;
+            case 'n':
+                s += '\n';
+                break;
+            case 'r':
+                s += '\r';
+                break;
+            case 't':
+                s += '\t';
+                break;
+            case 'u': {
+                std::uint32_t code_point;
+                if (!lex_unicode_escape(code_point)) {
+                    fail(tok, parse_error::invalid_unicode_escape, pos_);
+                    return;
+                }
+
+                utf8::encode(s, code_point);
+                break;
+            }
+            default:
+                fail(tok, parse_error::invalid_escape, pos_ - 2);
+                return;
         }
     }
-    
-    if (pos_ >= input_.size() || input_[pos_] != '"') {
-        throw std::runtime_error("Unterminated string at position " + std::to_string(pos_));
-    }
-    
+
     consume(); // Consume closing quote
-    return {token_type::string, s};
+    tok.type = token_type::string;
 }
 
-lexer::token lexer::lex_number() {
-    std::string num_str;
-    if (peek() == '-'){ 
-        num_str += consume();
+// Decodes the digits after "\u", combining a surrogate pair into one code point
+bool lexer::lex_unicode_escape(std::uint32_t& code_point) {
+    std::uint32_t unit;
+    if (!lex_hex4(unit) || (unit >= 0xdc00 && unit <= 0xdfff)) {
+        return false;
+    }
+
+    if (unit < 0xd800 || unit > 0xdbff) {
+        code_point = unit;
+        return true;
     }
-    
-    while (pos_ < input_.size() && std::isdigit(input_[pos_])) {
-        num_str += consume();
+
+    if (pos_ + 1 >= input_.size() || input_[pos_] != '\\' || input_[pos_ + 1] != 'u') {
+        return false;
     }
-    
-    if (pos_ < input_.size() && input_[pos_] == '.') {
-        num_str += consume();
-        while (pos_ < input_.size() && std::isdigit(input_[pos_])) {
-            num_str += consume();
+
+    pos_ += 2;
+    std::uint32_t low;
+    if (!lex_hex4(low) || low < 0xdc00 || low > 0xdfff) {
+        return false;
+    }
+
+    code_point = 0x10000 + ((unit - 0xd800) << 10) + (low - 0xdc00);
+    return true;
+}
+
+bool lexer::lex_hex4(std::uint32_t& value) {
+    value = 0;
+    for (int i = 0; i < 4; ++i) {
+        char c = peek();
+        std::uint32_t digit;
+        if (c >= '0' && c <= '9') {
+            digit = static_cast<std::uint32_t>(c - '0');
+        }
+        else if (c >= 'a' && c <= 'f') {
+            digit = static_cast<std::uint32_t>(c - 'a' + 10);
+        }
+        else if (c >= 'A' && c <= 'F') {
+            digit = static_cast<std::uint32_t>(c - 'A' + 10);
+        }
+        else {
+            return false;
         }
+
+        value = (value << 4) | digit;
+        ++pos_;
+    }
+
+    return true;
+}
+
+// Enforces the JSON number grammar: -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+void lexer::lex_number(token& tok) {
+    size_t start = pos_;
+    if (peek() == '-') {
+        ++pos_;
+    }
+
+    if (peek() == '0') {
+        ++pos_;
     }
-    
-    if (pos_ < input_.size() && (input_[pos_] == 'e' || input_[pos_] == 'E')) {
-        num_str += consume();
-        if (pos_ < input_.size() && (input_[pos_] == '+' || input_[pos_] == '-')) {
-            num_str += consume();
+    else if (is_digit(peek())) {
+        while (is_digit(peek())) {
+            ++pos_;
         }
-    
-        while (pos_ < input_.size() && std::isdigit(input_[pos_])) {
-            num_str += consume();
+    }
+    else {
+        fail(tok, parse_error::invalid_number, start);
+        return;
+    }
+
+    if (peek() == '.') {
+        ++pos_;
+        if (!is_digit(peek())) {
+            fail(tok, parse_error::invalid_number, start);
+            return;
+        }
+
+        while (is_digit(peek())) {
+            ++pos_;
+        }
+    }
+
+    if (peek() == 'e' || peek() == 'E') {
+        ++pos_;
+        if (peek() == '+' || peek() == '-') {
+            ++pos_;
+        }
+
+        if (!is_digit(peek())) {
+            fail(tok, parse_error::invalid_number, start);
+            return;
+        }
+
+        while (is_digit(peek())) {
+            ++pos_;
         }
     }
-    
-    return {token_type::number, num_str};
+
+    tok.value.assign(input_, start, pos_ - start);
+    tok.type = token_type::number;
 }
 
-lexer::token lexer::lex_keyword() {
-    std::string keyword;
-    while (pos_ < input_.size() && std::isalpha(input_[pos_])) {
-        keyword += consume();
+void lexer::lex_keyword(token& tok) {
+    size_t start = pos_;
+    while (pos_ < input_.size() && is_alpha(input_[pos_])) {
+        ++pos_;
     }
-    
-    if (keyword == "true"){ 
-        return {token_type::true_val, keyword};
+
+    size_t length = pos_ - start;
+    if (length == 4 && input_.compare(start, 4, "true") == 0) {
+        tok.type = token_type::true_val;
+        return;
     }
-    
-    if (keyword == "false"){ 
-        return {token_type::false_val, keyword};
+
+    if (length == 5 && input_.compare(start, 5, "false") == 0) {
+        tok.type = token_type::false_val;
+        return;
     }
-    
-    if (keyword == "null"){
-        return {token_type::null, keyword};
+
+    if (length == 4 && input_.compare(start, 4, "null") == 0) {
+        tok.type = token_type::null;
+        return;
     }
-    
-    throw std::runtime_error("Invalid keyword: " + keyword + " at position " + std::to_string(pos_ - keyword.size()));
-}
\ No newline at end of file
+
+    fail(tok, parse_error::invalid_keyword, start);
+}
+
+void lexer::fail(token& tok, parse_error error, size_t offset) {
+    tok.type = token_type::error;
+    tok.offset = offset;
+    error_ = error;
+    error_offset_ = offset;
+}
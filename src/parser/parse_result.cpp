@@ -0,0 +1,87 @@
+#include "../../include/parser/parse_result.hpp"
+#include <algorithm>
+
+const char* parse_error_message(parse_error error) {
+    switch (error) {
+        case parse_error::none: return "No error";
+        case parse_error::unexpected_end: return "Unexpected end of input";
+        case parse_error::invalid_character: return "Invalid character";
+        case parse_error::invalid_keyword: return "Invalid keyword";
+        case parse_error::invalid_number: return "Invalid number format";
+        case parse_error::invalid_escape: return "Invalid escape sequence";
+        case parse_error::invalid_unicode_escape: return "Invalid unicode escape";
+        case parse_error::invalid_utf8: return "Invalid UTF-8 in string";
+        case parse_error::control_character: return "Unescaped control character in string";
+        case parse_error::unterminated_string: return "Unterminated string";
+        case parse_error::expected_value: return "Invalid JSON value";
+        case parse_error::expected_key: return "Expected string key";
+        case parse_error::expected_colon: return "Expected ':'";
+        case parse_error::expected_comma_or_brace: return "Expected ',' or '}'";
+        case parse_error::expected_comma_or_bracket: return "Expected ',' or ']'";
+        case parse_error::trailing_content: return "Unexpected token after JSON value";
+        case parse_error::depth_limit_exceeded: return "Maximum nesting depth exceeded";
+        case parse_error::document_too_large: return "Document exceeds maximum size";
+        case parse_error::string_too_long: return "String exceeds maximum length";
+        case parse_error::too_many_elements: return "Container exceeds maximum number of elements";
+        case parse_error::rejected_by_handler: return "Rejected by handler";
+        case parse_error::schema_violation: return "Document violates schema";
+        case parse_error::out_of_memory: return "Out of memory";
+    }
+
+    return "Unknown error";
+}
+
+parse_result::parse_result() : error_(parse_error::none), offset_(0) {}
+
+parse_result::parse_result(json_value&& value)
+    : value_(std::move(value)), error_(parse_error::none), offset_(0) {}
+
+parse_result::parse_result(parse_error error, size_t offset, std::string_view input)
+    : error_(error), offset_(offset), input_(input) {}
+
+bool parse_result::ok() const {
+    return error_ == parse_error::none;
+}
+
+parse_result::operator bool() const {
+    return ok();
+}
+
+parse_error parse_result::error() const {
+    return error_;
+}
+
+const char* parse_result::message() const {
+    return parse_error_message(error_);
+}
+
+size_t parse_result::offset() const {
+    return offset_;
+}
+
+size_t parse_result::line() const {
+    size_t end = std::min(offset_, input_.size());
+    return 1 + static_cast<size_t>(std::count(input_.begin(), input_.begin() + end, '\n'));
+}
+
+size_t parse_result::column() const {
+    size_t end = std::min(offset_, input_.size());
+    size_t line_start = input_.rfind('\n', end == 0 ? 0 : end - 1);
+    if (line_start == std::string_view::npos || line_start >= end) {
+        return end + 1;
+    }
+
+    return end - line_start;
+}
+
+std::string parse_result::describe() const {
+    return std::string(message()) + " at line " + std::to_string(line()) + ", column " + std::to_string(column());
+}
+
+json_value& parse_result::value() {
+    return value_;
+}
+
+const json_value& parse_result::value() const {
+    return value_;
+}
@@ -1,165 +1,265 @@
 #include "../../include/parser/parser.hpp"
-#include "../../include/types/json_null.hpp"
-#include "../../include/types/json_boolean.hpp"
-#include "../../include/types/json_number.hpp"
-#include "../../include/types/json_string.hpp"
-#include "../../include/types/json_array.hpp"
-#include "../../include/types/json_object.hpp"
+#include "../../include/parser/tree_builder.hpp"
+#include <new>
 #include <stdexcept>
 
-parser::parser(const std::string& input) : lexer_(input) {
-    next_token();
-}
+parser::parser(const std::string& input, const parse_options& options)
+    : input_(input), options_(options), lexer_(input, options), current_token_{lexer::token_type::end, "", 0},
+      error_(parse_error::none), error_offset_(0) {}
 
 json_value parser::parse() {
-    auto result = parse_value();
-    if (current_token_.type != lexer::token_type::end) {
-        throw std::runtime_error("Unexpected token after JSON value");
+    json_value result;
+    tree_builder builder(result, false, options_, retained_input());
+    if (!run(builder)) {
+        throw std::runtime_error(parse_result(error_, error_offset_, input_).describe());
     }
-    
+
     return result;
 }
 
-void parser::next_token() {
-    current_token_ = lexer_.next_token();
+parse_result parser::try_parse() noexcept {
+    try {
+        json_value result;
+        tree_builder builder(result, false, options_, retained_input());
+        if (!run(builder)) {
+            return parse_result(error_, error_offset_, input_);
+        }
+
+        return parse_result(std::move(result));
+    } catch (const std::bad_alloc&) {
+        return parse_result(parse_error::out_of_memory, current_token_.offset, input_);
+    } catch (const std::length_error&) {
+        return parse_result(parse_error::out_of_memory, current_token_.offset, input_);
+    }
 }
 
-json_value parser::parse_value() {
-    switch (current_token_.type) {
-        case lexer::token_type::l_brace:
-            return parse_object();
-        case lexer::token_type::l_bracket:
-            return parse_array();
-        case lexer::token_type::string:
-            return parse_string();
-        case lexer::token_type::number:
-            return parse_number();
-        case lexer::token_type::true_val:
-        case lexer::token_type::false_val:
-            return parse_boolean();
-        case lexer::token_type::null:
-            return parse_null();
-        default:
-            throw std::runtime_error("Invalid JSON value");
+parse_result parser::try_parse(json_handler& handler) noexcept {
+    try {
+        if (!run(handler)) {
+            return parse_result(error_, error_offset_, input_);
+        }
+
+        return parse_result();
+    } catch (const std::bad_alloc&) {
+        return parse_result(parse_error::out_of_memory, current_token_.offset, input_);
+    } catch (const std::length_error&) {
+        return parse_result(parse_error::out_of_memory, current_token_.offset, input_);
+    } catch (...) {
+        // Anything else comes from the handler, which may run user code
+        return parse_result(parse_error::rejected_by_handler, current_token_.offset, input_);
     }
 }
 
-json_value parser::parse_object() {
-    if (current_token_.type != lexer::token_type::l_brace) {
-        throw std::runtime_error("Expected '{'");
+void parser::parse_into(json_value& target) {
+    tree_builder builder(target, true, options_, retained_input());
+    if (!run(builder)) {
+        throw std::runtime_error(parse_result(error_, error_offset_, input_).describe());
     }
+}
 
-    next_token();
-    json_value result = json_value::make_object();
-    json_object& obj = result.as_object();
-    if (current_token_.type != lexer::token_type::r_brace) {
-        while (true) {
-            if (current_token_.type != lexer::token_type::string) {
-                throw std::runtime_error("Expected string key");
-            }
+parse_result parser::try_parse_into(json_value& target) noexcept {
+    try {
+        tree_builder builder(target, true, options_, retained_input());
+        return try_parse(builder);
+    } catch (const std::bad_alloc&) {
+        return parse_result(parse_error::out_of_memory, 0, input_);
+    } catch (const std::length_error&) {
+        return parse_result(parse_error::out_of_memory, 0, input_);
+    }
+}
 
-            std::string key = current_token_.value;
-            next_token();
-            if (current_token_.type != lexer::token_type::colon) {
-                throw std::runtime_error("Expected ':'");
-            }
+bool parser::next_token() {
+    lexer_.next_token(current_token_);
+    if (current_token_.type == lexer::token_type::error) {
+        error_ = lexer_.error();
+        error_offset_ = lexer_.error_offset();
+        return false;
+    }
 
-            next_token();
-            obj[key] = parse_value();
-            if (current_token_.type == lexer::token_type::r_brace) {
-                break;
-            }
+    return true;
+}
 
-            if (current_token_.type != lexer::token_type::comma) {
-                throw std::runtime_error("Expected ',' or '}'");
-            }
+bool parser::fail(parse_error error) {
+    if (current_token_.type == lexer::token_type::error) {
+        // The lexer already recorded a more precise reason
+        return false;
+    }
 
-            next_token();
-        }
+    error_ = current_token_.type == lexer::token_type::end ? parse_error::unexpected_end : error;
+    error_offset_ = current_token_.offset;
+    return false;
+}
+
+bool parser::reject(const json_handler& handler) {
+    error_ = handler.failure();
+    if (error_ == parse_error::none) {
+        error_ = parse_error::rejected_by_handler;
     }
 
-    if (current_token_.type != lexer::token_type::r_brace) {
-        throw std::runtime_error("Expected '}'");
+    error_offset_ = current_token_.offset;
+    return false;
+}
+
+// The tree shares one copy of the input between the source ranges of all
+// its containers
+std::shared_ptr<const std::string> parser::retained_input() const {
+    if (!options_.preserve_source) {
+        return nullptr;
     }
 
-    next_token();
-    return result;
+    return std::make_shared<const std::string>(input_);
 }
 
-json_value parser::parse_array() {
-    if (current_token_.type != lexer::token_type::l_bracket) {
-        throw std::runtime_error("Expected '['");
+// A state machine over the token stream. value expects any JSON value,
+// key expects an object key and its colon, and after_value expects the
+// separator or closing bracket of the innermost open container.
+bool parser::run(json_handler& handler) {
+    if (input_.size() > options_.max_document_size) {
+        error_ = parse_error::document_too_large;
+        error_offset_ = options_.max_document_size;
+        return false;
     }
 
-    next_token();
-    json_value result = json_value::make_array();
-    json_array& arr = result.as_array();
-    if (current_token_.type != lexer::token_type::r_bracket) {
-        while (true) {
-            arr.add_value(parse_value());
-            if (current_token_.type == lexer::token_type::r_bracket) {
-                break;
+    enum class state { value, key, after_value };
+
+    stack_.clear();
+    if (!next_token()) {
+        return false;
+    }
+
+    state current = state::value;
+    while (true) {
+        if (current == state::value) {
+            lexer::token_type type = current_token_.type;
+            if (type == lexer::token_type::l_brace || type == lexer::token_type::l_bracket) {
+                bool is_object = type == lexer::token_type::l_brace;
+                size_t begin = current_token_.offset;
+                if (stack_.size() >= options_.max_depth) {
+                    return fail(parse_error::depth_limit_exceeded);
+                }
+
+                if (!(is_object ? handler.begin_object() : handler.begin_array())) {
+                    return reject(handler);
+                }
+
+                if (!next_token()) {
+                    return false;
+                }
+
+                if (current_token_.type == (is_object ? lexer::token_type::r_brace : lexer::token_type::r_bracket)) {
+                    if (!(is_object ? handler.end_object() : handler.end_array())) {
+                        return reject(handler);
+                    }
+
+                    if (options_.preserve_source) {
+                        handler.container_source(begin, current_token_.offset + 1);
+                    }
+
+                    if (!next_token()) {
+                        return false;
+                    }
+
+                    current = state::after_value;
+                    continue;
+                }
+
+                stack_.push_back({is_object, 0, begin});
+                current = is_object ? state::key : state::value;
+                continue;
             }
 
-            if (current_token_.type != lexer::token_type::comma) {
-                throw std::runtime_error("Expected ',' or ']'");
+            bool accepted;
+            switch (type) {
+                case lexer::token_type::string:
+                    accepted = handler.string_value(current_token_.value);
+                    break;
+                case lexer::token_type::number:
+                    accepted = handler.number_value(current_token_.value);
+                    break;
+                case lexer::token_type::true_val:
+                case lexer::token_type::false_val:
+                    accepted = handler.boolean_value(type == lexer::token_type::true_val);
+                    break;
+                case lexer::token_type::null:
+                    accepted = handler.null_value();
+                    break;
+                default:
+                    return fail(parse_error::expected_value);
             }
 
-            next_token();
+            if (!accepted) {
+                return reject(handler);
+            }
+
+            if (!next_token()) {
+                return false;
+            }
+
+            current = state::after_value;
         }
-    }
+        else if (current == state::key) {
+            if (current_token_.type != lexer::token_type::string) {
+                return fail(parse_error::expected_key);
+            }
 
-    if (current_token_.type != lexer::token_type::r_bracket) {
-        throw std::runtime_error("Expected ']'");
-    }
+            if (!handler.key(current_token_.value)) {
+                return reject(handler);
+            }
 
-    next_token();
-    return result;
-}
+            if (!next_token()) {
+                return false;
+            }
 
-json_value parser::parse_string() {
-    if (current_token_.type != lexer::token_type::string) {
-        throw std::runtime_error("Expected string");
-    }
+            if (current_token_.type != lexer::token_type::colon) {
+                return fail(parse_error::expected_colon);
+            }
 
-    json_value result(current_token_.value);
-    next_token();
+            if (!next_token()) {
+                return false;
+            }
 
-    return result;
-}
+            current = state::value;
+        }
+        else {
+            if (stack_.empty()) {
+                if (current_token_.type != lexer::token_type::end) {
+                    return fail(parse_error::trailing_content);
+                }
 
-json_value parser::parse_number() {
-    if (current_token_.type != lexer::token_type::number) {
-        throw std::runtime_error("Expected number");
-    }
-    try {
-        json_value result(std::stod(current_token_.value));
-        next_token();
-        return result;
-    } catch (...) {
-        throw std::runtime_error("Invalid number format: " + current_token_.value);
-    }
-}
+                return true;
+            }
 
-json_value parser::parse_boolean() {
-    if (current_token_.type == lexer::token_type::true_val) {
-        next_token();
-        return json_value(true);
-    }
+            frame& top = stack_.back();
+            if (++top.count > options_.max_container_elements) {
+                return fail(parse_error::too_many_elements);
+            }
 
-    if (current_token_.type == lexer::token_type::false_val) {
-        next_token();
-        return json_value(false);
-    }
+            if (current_token_.type == lexer::token_type::comma) {
+                if (!next_token()) {
+                    return false;
+                }
 
-    throw std::runtime_error("Expected boolean");
-}
+                current = top.is_object ? state::key : state::value;
+                continue;
+            }
 
-json_value parser::parse_null() {
-    if (current_token_.type != lexer::token_type::null) {
-        throw std::runtime_error("Expected null");
-    }
+            lexer::token_type closing = top.is_object ? lexer::token_type::r_brace : lexer::token_type::r_bracket;
+            if (current_token_.type != closing) {
+                return fail(top.is_object ? parse_error::expected_comma_or_brace : parse_error::expected_comma_or_bracket);
+            }
 
-    next_token();
-    return json_value(nullptr);
+            if (!(top.is_object ? handler.end_object() : handler.end_array())) {
+                return reject(handler);
+            }
+
+            if (options_.preserve_source) {
+                handler.container_source(top.begin, current_token_.offset + 1);
+            }
+
+            stack_.pop_back();
+            if (!next_token()) {
+                return false;
+            }
+        }
+    }
 }
@@ -0,0 +1,444 @@
+#include "../../include/parser/tree_builder.hpp"
+#include "../../include/types/json_boolean.hpp"
+#include "../../include/types/json_number.hpp"
+#include "../../include/types/json_string.hpp"
+#include "../../include/types/json_array.hpp"
+#include "../../include/types/json_object.hpp"
+#include "../../include/utils/json_interner.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+
+namespace {
+    // Bounds the shape nodes a document with varied keys can create; their
+    // objects are built standalone instead
+    constexpr size_t max_shape_size = 64;
+    constexpr size_t max_shapes = 4096;
+
+    // Fails on magnitudes a double cannot hold
+    bool convert(const std::string& lexeme, double& value) {
+        errno = 0;
+        value = std::strtod(lexeme.c_str(), nullptr);
+        return !(errno == ERANGE && std::isinf(value));
+    }
+}
+
+tree_builder::tree_builder(json_value& root, bool reuse, const parse_options& options,
+                           std::shared_ptr<const std::string> input)
+    : root_(root), reuse_(reuse), pack_arrays_(options.pack_arrays), lazy_numbers_(options.lazy_numbers),
+      deduplicate_(options.deduplicate),
+      input_(std::move(input)), closed_array_(nullptr), closed_object_(nullptr), failure_(parse_error::none) {
+    shapes_.push_back({std::string(), 0, 0, false, {}, nullptr});
+}
+
+bool tree_builder::null_value() {
+    flush_pending();
+    if (reuse_) {
+        json_value& slot = next_slot();
+        if (!slot.is_null()) {
+            slot = json_value(nullptr);
+        }
+
+        return true;
+    }
+
+    place(json_value(nullptr));
+    return true;
+}
+
+bool tree_builder::boolean_value(bool value) {
+    if (pack(json_array::packing::booleans)) {
+        pending_booleans_.push_back(value ? 1 : 0);
+        return true;
+    }
+
+    store_boolean(value);
+    return true;
+}
+
+bool tree_builder::number_value(std::string& lexeme) {
+    double value = 0.0;
+    if (lazy_numbers_) {
+        // Without an exponent, fewer than 309 digits cannot overflow, so
+        // most lexemes are stored without converting them
+        bool may_overflow = lexeme.size() > 308 || lexeme.find_first_of("eE") != std::string::npos;
+        if (may_overflow && !convert(lexeme, value)) {
+            failure_ = parse_error::invalid_number;
+            return false;
+        }
+
+        flush_pending();
+        store_lexeme(lexeme);
+        return true;
+    }
+
+    if (!convert(lexeme, value)) {
+        failure_ = parse_error::invalid_number;
+        return false;
+    }
+
+    if (pack(json_array::packing::numbers)) {
+        pending_numbers_.push_back(value);
+        return true;
+    }
+
+    store_number(value);
+    return true;
+}
+
+bool tree_builder::string_value(std::string& value) {
+    flush_pending();
+    if (reuse_) {
+        // Copying keeps both the node's buffer and the lexer's token buffer
+        json_value& slot = next_slot();
+        if (slot.is_string()) {
+            slot.as_string().set_value(value);
+        }
+        else {
+            slot = json_value(value);
+        }
+
+        return true;
+    }
+
+    place(json_value(std::move(value)));
+    return true;
+}
+
+bool tree_builder::begin_object() {
+    flush_pending();
+    json_value& slot = reuse_ ? next_slot() : place(json_value::make_object());
+    if (!slot.is_object()) {
+        slot = json_value::make_object();
+    }
+    else if (reuse_) {
+        // touched_ keeps member addresses, which a shaped object would
+        // free when the first new key turns it standalone
+        slot.as_object().touch();
+        slot.as_object().unshape();
+    }
+
+    size_t shape = reuse_ ? object_shape::npos : 0;
+    stack_.push_back({nullptr, &slot.as_object(), 0, touched_.size(), false, json_array::packing::none, shape,
+                      members_.size()});
+    return true;
+}
+
+bool tree_builder::key(std::string& key) {
+    if (reuse_) {
+        key_.assign(key);
+        return true;
+    }
+
+    key_ = std::move(key);
+    return true;
+}
+
+bool tree_builder::end_object() {
+    frame& top = stack_.back();
+    json_object* obj = top.obj;
+    if (top.shape != object_shape::npos && top.shape != 0) {
+        auto begin = members_.begin() + static_cast<std::ptrdiff_t>(top.members_begin);
+        obj->shape_ = shape_of(top.shape);
+        obj->slots_.assign(std::make_move_iterator(begin), std::make_move_iterator(members_.end()));
+        members_.erase(begin, members_.end());
+    }
+
+    if (reuse_) {
+        trim_object(stack_.back());
+        // An object whose members all kept their nodes may not have been
+        // touched, so drop the previous document's text explicitly
+        obj->set_source(source_text());
+    }
+
+    obj->seal();
+    closed_array_ = nullptr;
+    closed_object_ = obj;
+    finish_container();
+    return true;
+}
+
+bool tree_builder::begin_array() {
+    flush_pending();
+    json_value& slot = reuse_ ? next_slot() : place(json_value::make_array());
+    if (!slot.is_array()) {
+        slot = json_value::make_array();
+    }
+
+    stack_.push_back({&slot.as_array(), nullptr, 0, 0, pack_arrays_, json_array::packing::none, object_shape::npos, 0});
+    return true;
+}
+
+bool tree_builder::end_array() {
+    frame& top = stack_.back();
+    if (top.packable) {
+        // Nothing was placed: the array is empty or entirely buffered
+        if (top.packed == json_array::packing::numbers) {
+            top.arr->assign_numbers(pending_numbers_.data(), pending_numbers_.size());
+            pending_numbers_.clear();
+        }
+        else if (top.packed == json_array::packing::booleans) {
+            top.arr->assign_booleans(pending_booleans_.data(), pending_booleans_.size());
+            pending_booleans_.clear();
+        }
+        else {
+            top.arr->clear();
+        }
+    }
+    else if (reuse_ && top.index < top.arr->size()) {
+        top.arr->resize(top.index);
+    }
+
+    if (reuse_) {
+        top.arr->set_source(source_text());
+    }
+
+    top.arr->seal();
+    closed_array_ = top.arr;
+    closed_object_ = nullptr;
+    finish_container();
+    return true;
+}
+
+void tree_builder::container_source(size_t begin, size_t end) {
+    if (!input_) {
+        return;
+    }
+
+    source_text text(input_, begin, end);
+    if (closed_array_) {
+        closed_array_->set_source(std::move(text));
+    }
+    else if (closed_object_) {
+        closed_object_->set_source(std::move(text));
+    }
+}
+
+parse_error tree_builder::failure() const {
+    return failure_;
+}
+
+void tree_builder::store_number(double value) {
+    if (reuse_) {
+        json_value& slot = next_slot();
+        if (slot.is_number()) {
+            slot.as_number() = json_number(value);
+        }
+        else {
+            slot = json_value(value);
+        }
+
+        return;
+    }
+
+    place(json_value(value));
+}
+
+void tree_builder::store_boolean(bool value) {
+    if (reuse_) {
+        json_value& slot = next_slot();
+        if (slot.is_boolean()) {
+            slot.as_boolean() = json_boolean(value);
+        }
+        else {
+            slot = json_value(value);
+        }
+
+        return;
+    }
+
+    place(json_value(value));
+}
+
+void tree_builder::store_lexeme(std::string& lexeme) {
+    if (reuse_) {
+        json_value& slot = next_slot();
+        if (slot.is_number()) {
+            slot.as_number() = json_number::from_lexeme(lexeme);
+        }
+        else {
+            slot = json_value::make_number(lexeme);
+        }
+
+        return;
+    }
+
+    place(json_value::make_number(std::move(lexeme)));
+}
+
+// Returns true if a scalar of the given kind should be buffered for the
+// innermost array; a scalar of another kind ends packing for that array
+bool tree_builder::pack(json_array::packing kind) {
+    if (stack_.empty() || !stack_.back().packable) {
+        return false;
+    }
+
+    frame& top = stack_.back();
+    if (top.packed == json_array::packing::none) {
+        top.packed = kind;
+    }
+
+    if (top.packed == kind) {
+        return true;
+    }
+
+    flush_pending();
+    return false;
+}
+
+// Gives up packing the innermost array and places what was buffered
+void tree_builder::flush_pending() {
+    if (stack_.empty() || !stack_.back().packable) {
+        return;
+    }
+
+    frame& top = stack_.back();
+    top.packable = false;
+    if (top.arr->get_packing() != json_array::packing::none) {
+        // A packed array from a previous parse has no nodes to reuse
+        top.arr->clear();
+    }
+
+    for (double number : pending_numbers_) {
+        store_number(number);
+    }
+
+    for (std::uint8_t boolean : pending_booleans_) {
+        store_boolean(boolean != 0);
+    }
+
+    pending_numbers_.clear();
+    pending_booleans_.clear();
+}
+
+// Each container is owned through a unique_ptr inside its json_value, so the
+// pointers on the stack stay valid even if the vector holding that
+// json_value reallocates
+json_value& tree_builder::place(json_value&& value) {
+    if (stack_.empty()) {
+        root_ = std::move(value);
+        return root_;
+    }
+
+    frame& top = stack_.back();
+    if (top.arr) {
+        return top.arr->emplace_back(std::move(value));
+    }
+
+    if (top.shape != object_shape::npos) {
+        size_t next = advance(top.shape);
+        if (next != object_shape::npos) {
+            top.shape = next;
+            members_.push_back(std::move(value));
+            return members_.back();
+        }
+
+        unstage(top);
+    }
+
+    return top.obj->insert_or_assign(std::move(key_), std::move(value));
+}
+
+// Returns the existing node at the current position, creating a null one
+// only when the previous document had nothing there
+json_value& tree_builder::next_slot() {
+    if (stack_.empty()) {
+        return root_;
+    }
+
+    frame& top = stack_.back();
+    if (top.arr) {
+        if (top.index < top.arr->size()) {
+            return *(top.arr->begin() + static_cast<std::ptrdiff_t>(top.index++));
+        }
+
+        ++top.index;
+        return top.arr->emplace_back(json_value());
+    }
+
+    json_value* slot = top.obj->find(key_);
+    if (!slot) {
+        slot = &top.obj->insert_or_assign(std::string(key_), json_value());
+    }
+
+    touched_.push_back(slot);
+    return *slot;
+}
+
+void tree_builder::finish_container() {
+    stack_.pop_back();
+    if (stack_.empty() && deduplicate_) {
+        json_interner().intern(root_);
+    }
+}
+
+// Removes the keys of the previous document that this one did not mention.
+// Duplicate keys touch the same node twice, so the touched list is made
+// unique before comparing it with the object's size.
+void tree_builder::trim_object(const frame& top) {
+    auto begin = touched_.begin() + static_cast<std::ptrdiff_t>(top.touched_begin);
+    std::sort(begin, touched_.end());
+    auto end = std::unique(begin, touched_.end());
+    if (top.obj->size() != static_cast<size_t>(end - begin)) {
+        std::vector<std::string> stale;
+        for (const auto& entry : *top.obj) {
+            if (!std::binary_search(begin, end, &entry.second)) {
+                stale.push_back(entry.first);
+            }
+        }
+
+        for (const std::string& key : stale) {
+            top.obj->remove_key(key);
+        }
+    }
+
+    touched_.erase(begin, touched_.end());
+}
+
+// Follows or creates the transition for key_, or returns npos if the object
+// has to be built standalone
+size_t tree_builder::advance(size_t shape) {
+    auto it = shapes_[shape].transitions.find(key_);
+    if (it != shapes_[shape].transitions.end()) {
+        return shapes_[it->second].repeated ? object_shape::npos : it->second;
+    }
+
+    if (shapes_[shape].size == max_shape_size || shapes_.size() == max_shapes) {
+        return object_shape::npos;
+    }
+
+    bool repeated = false;
+    for (size_t node = shape; node != 0 && !repeated; node = shapes_[node].parent) {
+        repeated = shapes_[node].key == key_;
+    }
+
+    shapes_.push_back({key_, shape, shapes_[shape].size + 1, repeated, {}, nullptr});
+    shapes_[shape].transitions.emplace(key_, shapes_.size() - 1);
+    return repeated ? object_shape::npos : shapes_.size() - 1;
+}
+
+std::shared_ptr<const object_shape> tree_builder::shape_of(size_t shape) {
+    if (!shapes_[shape].shape) {
+        std::vector<std::string> keys(shapes_[shape].size);
+        for (size_t node = shape; node != 0; node = shapes_[node].parent) {
+            keys[shapes_[node].size - 1] = shapes_[node].key;
+        }
+
+        shapes_[shape].shape = std::make_shared<const object_shape>(std::move(keys));
+    }
+
+    return shapes_[shape].shape;
+}
+
+// Moves the staged members into the object, which is built standalone from
+// here on
+void tree_builder::unstage(frame& top) {
+    for (size_t node = top.shape; node != 0; node = shapes_[node].parent) {
+        json_value& member = members_[top.members_begin + shapes_[node].size - 1];
+        top.obj->insert_or_assign(std::string(shapes_[node].key), std::move(member));
+    }
+
+    members_.resize(top.members_begin);
+    top.shape = object_shape::npos;
+}
@@ -0,0 +1,709 @@
+#include "../../include/query/json_path.hpp"
+#include "../../include/query/path_matcher.hpp"
+#include "../../include/parser/parser.hpp"
+#include "../../include/types/json_array.hpp"
+#include "../../include/types/json_number.hpp"
+#include "../../include/types/json_object.hpp"
+#include "../../include/types/json_string.hpp"
+#include "../../include/utils/utf8.hpp"
+#include <algorithm>
+#include <exception>
+#include <cstdlib>
+#include <stdexcept>
+
+namespace {
+    bool is_name_first(char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || static_cast<unsigned char>(c) >= 0x80;
+    }
+
+    bool is_digit(char c) {
+        return c >= '0' && c <= '9';
+    }
+
+    int hex_value(char c) {
+        if (is_digit(c)) {
+            return c - '0';
+        }
+
+        if (c >= 'a' && c <= 'f') {
+            return c - 'a' + 10;
+        }
+
+        if (c >= 'A' && c <= 'F') {
+            return c - 'A' + 10;
+        }
+
+        return -1;
+    }
+
+    // Comparisons other than equality only order numbers and strings
+    bool less(const json_value* a, const json_value* b) {
+        if (!a || !b) {
+            return false;
+        }
+
+        if (a->is_number() && b->is_number()) {
+            return a->as_number().get_value() < b->as_number().get_value();
+        }
+
+        if (a->is_string() && b->is_string()) {
+            return a->as_string().get_view() < b->as_string().get_view();
+        }
+
+        return false;
+    }
+}
+
+// Recursive descent over the expression text
+class json_path::compiler {
+public:
+    compiler(json_path& path, std::string_view text) : path_(path), text_(text), pos_(0) {}
+
+    query compile() {
+        query q;
+        if (!consume('$')) {
+            error("expected $");
+        }
+
+        parse_segments(q);
+        if (pos_ != text_.size()) {
+            error("unexpected character");
+        }
+
+        return q;
+    }
+
+private:
+    json_path& path_;
+    std::string_view text_;
+    size_t pos_;
+
+    [[noreturn]] void error(const std::string& message) const {
+        throw std::runtime_error("Invalid JSONPath at offset " + std::to_string(pos_) + ": " + message);
+    }
+
+    char peek(size_t ahead = 0) const {
+        return pos_ + ahead < text_.size() ? text_[pos_ + ahead] : '\0';
+    }
+
+    bool consume(char c) {
+        if (peek() != c) {
+            return false;
+        }
+
+        ++pos_;
+        return true;
+    }
+
+    bool consume(std::string_view token) {
+        if (text_.substr(pos_, token.size()) != token) {
+            return false;
+        }
+
+        pos_ += token.size();
+        return true;
+    }
+
+    void skip_space() {
+        while (peek() == ' ' || peek() == '\t' || peek() == '\n' || peek() == '\r') {
+            ++pos_;
+        }
+    }
+
+    void parse_segments(query& q) {
+        while (true) {
+            size_t start = pos_;
+            skip_space();
+            segment s;
+            if (consume("..")) {
+                s.descendant = true;
+                if (consume('[')) {
+                    parse_brackets(s);
+                }
+                else {
+                    parse_dotted(s);
+                }
+            }
+            else if (consume('.')) {
+                parse_dotted(s);
+            }
+            else if (consume('[')) {
+                parse_brackets(s);
+            }
+            else {
+                pos_ = start;
+                return;
+            }
+
+            q.segments.push_back(std::move(s));
+        }
+    }
+
+    void parse_dotted(segment& s) {
+        selector sel;
+        if (consume('*')) {
+            sel.kind = selector_kind::wildcard;
+        }
+        else if (is_name_first(peek())) {
+            sel.kind = selector_kind::name;
+            size_t start = pos_;
+            while (is_name_first(peek()) || is_digit(peek())) {
+                ++pos_;
+            }
+
+            sel.name = std::string(text_.substr(start, pos_ - start));
+        }
+        else {
+            error("expected a member name or *");
+        }
+
+        s.selectors.push_back(std::move(sel));
+    }
+
+    void parse_brackets(segment& s) {
+        do {
+            skip_space();
+            s.selectors.push_back(parse_selector());
+            skip_space();
+        } while (consume(','));
+
+        if (!consume(']')) {
+            error("expected ] or ,");
+        }
+    }
+
+    selector parse_selector() {
+        selector sel;
+        if (peek() == '\'' || peek() == '"') {
+            sel.kind = selector_kind::name;
+            sel.name = parse_string();
+        }
+        else if (consume('*')) {
+            sel.kind = selector_kind::wildcard;
+        }
+        else if (consume('?')) {
+            sel.kind = selector_kind::filter;
+            sel.filter = parse_or();
+        }
+        else {
+            sel.kind = selector_kind::index;
+            sel.has_start = parse_integer(sel.index);
+            skip_space();
+            if (consume(':')) {
+                sel.kind = selector_kind::slice;
+                skip_space();
+                sel.has_end = parse_integer(sel.end);
+                skip_space();
+                if (consume(':')) {
+                    skip_space();
+                    parse_integer(sel.step);
+                }
+            }
+            else if (!sel.has_start) {
+                error("expected a selector");
+            }
+        }
+
+        return sel;
+    }
+
+    // Indices and slice bounds are limited to the exactly representable
+    // integers, as RFC 9535 requires, which also keeps index arithmetic
+    // from overflowing
+    bool parse_integer(long long& out) {
+        constexpr long long max_integer = (1LL << 53) - 1;
+        size_t start = pos_;
+        bool negative = consume('-');
+        if (!is_digit(peek())) {
+            pos_ = start;
+            return false;
+        }
+
+        long long value = 0;
+        while (is_digit(peek())) {
+            value = value * 10 + (peek() - '0');
+            if (value > max_integer) {
+                pos_ = start;
+                error("integer out of range");
+            }
+
+            ++pos_;
+        }
+
+        out = negative ? -value : value;
+        return true;
+    }
+
+    std::string parse_string() {
+        char quote = text_[pos_++];
+        std::string out;
+        while (true) {
+            if (pos_ >= text_.size()) {
+                error("unterminated string");
+            }
+
+            char c = text_[pos_++];
+            if (c == quote) {
+                return out;
+            }
+
+            if (c != '\\') {
+                out += c;
+                continue;
+            }
+
+            char escape = peek();
+            ++pos_;
+            switch (escape) {
+                case '\'':
+                case '"':
+                case '\\':
+                case '/':
+                    out += escape;
+                    break;
+                case 'b':
+                    out += '\b';
+                    break;
+                case 'f':
+                    out += '\f';
+                    break;
+                case 'n':
+                    out += '\n';
+                    break;
+                case 'r':
+                    out += '\r';
+                    break;
+                case 't':
+                    out += '\t';
+                    break;
+                case 'u': {
+                    std::uint32_t code_point = parse_hex();
+                    if (code_point >= 0xD800 && code_point <= 0xDBFF && consume("\\u")) {
+                        std::uint32_t low = parse_hex();
+                        if (low < 0xDC00 || low > 0xDFFF) {
+                            error("invalid surrogate pair");
+                        }
+
+                        code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low - 0xDC00);
+                    }
+
+                    if (code_point >= 0xD800 && code_point <= 0xDFFF) {
+                        error("invalid surrogate pair");
+                    }
+
+                    utf8::encode(out, code_point);
+                    break;
+                }
+                default:
+                    error("invalid escape");
+            }
+        }
+    }
+
+    std::uint32_t parse_hex() {
+        std::uint32_t value = 0;
+        for (int i = 0; i < 4; ++i) {
+            int digit = hex_value(peek());
+            if (digit < 0) {
+                error("invalid \\u escape");
+            }
+
+            value = value * 16 + static_cast<std::uint32_t>(digit);
+            ++pos_;
+        }
+
+        return value;
+    }
+
+    static condition make(condition_kind kind) {
+        condition c;
+        c.kind = kind;
+        return c;
+    }
+
+    size_t add(condition c) {
+        path_.conditions_.push_back(std::move(c));
+        return path_.conditions_.size() - 1;
+    }
+
+    size_t parse_or() {
+        size_t left = parse_and();
+        skip_space();
+        while (consume("||")) {
+            condition c = make(condition_kind::any);
+            c.left = left;
+            c.right = parse_and();
+            left = add(std::move(c));
+            skip_space();
+        }
+
+        return left;
+    }
+
+    size_t parse_and() {
+        size_t left = parse_unary();
+        skip_space();
+        while (consume("&&")) {
+            condition c = make(condition_kind::all);
+            c.left = left;
+            c.right = parse_unary();
+            left = add(std::move(c));
+            skip_space();
+        }
+
+        return left;
+    }
+
+    size_t parse_unary() {
+        skip_space();
+        if (peek() == '!' && peek(1) != '=') {
+            ++pos_;
+            condition c = make(condition_kind::negation);
+            c.left = parse_unary();
+            return add(std::move(c));
+        }
+
+        if (consume('(')) {
+            size_t inner = parse_or();
+            skip_space();
+            if (!consume(')')) {
+                error("expected )");
+            }
+
+            return inner;
+        }
+
+        condition c = make(condition_kind::compare);
+        c.lhs = parse_operand();
+        skip_space();
+        static const std::pair<std::string_view, compare_op> operators[] = {
+            {"==", compare_op::equal}, {"!=", compare_op::not_equal}, {"<=", compare_op::less_equal},
+            {">=", compare_op::greater_equal}, {"<", compare_op::less}, {">", compare_op::greater}};
+        auto op = std::find_if(std::begin(operators), std::end(operators), [this](const auto& entry) {
+            return consume(entry.first);
+        });
+
+        if (op == std::end(operators)) {
+            if (!c.lhs.is_query) {
+                error("expected a comparison operator");
+            }
+
+            condition exists = make(condition_kind::exists);
+            exists.path = std::move(c.lhs.path);
+            return add(std::move(exists));
+        }
+
+        c.op = op->second;
+        c.rhs = parse_operand();
+        for (const operand* o : {&c.lhs, &c.rhs}) {
+            if (o->is_query && !singular(o->path)) {
+                error("comparisons need queries that select at most one value");
+            }
+        }
+
+        return add(std::move(c));
+    }
+
+    operand parse_operand() {
+        skip_space();
+        operand o;
+        char c = peek();
+        if (c == '@' || c == '$') {
+            ++pos_;
+            o.is_query = true;
+            o.path.absolute = c == '$';
+            path_.uses_root_ = path_.uses_root_ || c == '$';
+            parse_segments(o.path);
+        }
+        else if (c == '\'' || c == '"') {
+            o.literal = json_value(parse_string());
+        }
+        else if (consume("true")) {
+            o.literal = json_value(true);
+        }
+        else if (consume("false")) {
+            o.literal = json_value(false);
+        }
+        else if (consume("null")) {
+            o.literal = json_value(nullptr);
+        }
+        else if (c == '-' || is_digit(c)) {
+            const char* begin = text_.data() + pos_;
+            std::string number(begin, std::find_if(begin + 1, text_.data() + text_.size(), [](char d) {
+                return !is_digit(d) && d != '.' && d != 'e' && d != 'E' && d != '+' && d != '-';
+            }));
+
+            char* end = nullptr;
+            double value = std::strtod(number.c_str(), &end);
+            if (end != number.c_str() + number.size()) {
+                error("invalid number");
+            }
+
+            pos_ += number.size();
+            o.literal = json_value(value);
+        }
+        else if (is_name_first(c)) {
+            error("function extensions are not supported");
+        }
+        else {
+            error("expected a query or a literal");
+        }
+
+        return o;
+    }
+
+    static bool singular(const query& q) {
+        return std::all_of(q.segments.begin(), q.segments.end(), [](const segment& s) {
+            return !s.descendant && s.selectors.size() == 1 &&
+                   (s.selectors[0].kind == selector_kind::name || s.selectors[0].kind == selector_kind::index);
+        });
+    }
+};
+
+// json_path implementations
+json_path::json_path(std::string_view expression) : uses_root_(false) {
+    compiler c(*this, expression);
+    plan_ = c.compile();
+}
+
+std::vector<const json_value*> json_path::select(const json_value& root) const {
+    std::vector<const json_value*> out;
+    select(root, out);
+    return out;
+}
+
+void json_path::select(const json_value& root, std::vector<const json_value*>& out) const {
+    run(plan_, 0, root, root, out);
+}
+
+void json_path::stream(const std::string& text, const std::function<void(const json_value&)>& on_match,
+                       const parse_options& options) const {
+    path_matcher matcher(*this, on_match, options);
+    parser p(text, options);
+    parse_result result = p.try_parse(matcher);
+    if (matcher.exception()) {
+        std::rethrow_exception(matcher.exception());
+    }
+
+    if (!result) {
+        throw std::runtime_error(result.describe());
+    }
+}
+
+bool json_path::streams() const {
+    return !uses_root_;
+}
+
+// Applies the segments from first on to start
+void json_path::run(const query& q, size_t first, const json_value& start, const json_value& root,
+                    std::vector<const json_value*>& out) const {
+    std::vector<const json_value*> current{&start};
+    std::vector<const json_value*> next;
+    for (size_t k = first; k < q.segments.size() && !current.empty(); ++k) {
+        next.clear();
+        for (const json_value* node : current) {
+            apply(q.segments[k], *node, root, next);
+        }
+
+        current.swap(next);
+    }
+
+    out.insert(out.end(), current.begin(), current.end());
+}
+
+// Descendant segments visit the node and everything below it in document
+// order, without recursion
+void json_path::apply(const segment& s, const json_value& node, const json_value& root,
+                      std::vector<const json_value*>& out) const {
+    if (!s.descendant) {
+        for (const selector& sel : s.selectors) {
+            apply(sel, node, root, out);
+        }
+
+        return;
+    }
+
+    std::vector<const json_value*> pending{&node};
+    while (!pending.empty()) {
+        const json_value* current = pending.back();
+        pending.pop_back();
+        for (const selector& sel : s.selectors) {
+            apply(sel, *current, root, out);
+        }
+
+        size_t before = pending.size();
+        if (current->is_array()) {
+            for (const json_value& element : current->as_array()) {
+                pending.push_back(&element);
+            }
+        }
+        else if (current->is_object()) {
+            for (const auto& member : current->as_object()) {
+                pending.push_back(&member.second);
+            }
+        }
+
+        std::reverse(pending.begin() + before, pending.end());
+    }
+}
+
+void json_path::apply(const selector& s, const json_value& node, const json_value& root,
+                      std::vector<const json_value*>& out) const {
+    if (node.is_object()) {
+        const json_object& obj = node.as_object();
+        if (s.kind == selector_kind::name) {
+            if (const json_value* member = obj.find(s.name)) {
+                out.push_back(member);
+            }
+        }
+        else if (s.kind == selector_kind::wildcard || s.kind == selector_kind::filter) {
+            for (const auto& member : obj) {
+                if (s.kind == selector_kind::wildcard || test(s.filter, member.second, root)) {
+                    out.push_back(&member.second);
+                }
+            }
+        }
+
+        return;
+    }
+
+    if (!node.is_array()) {
+        return;
+    }
+
+    const json_array& arr = node.as_array();
+    long long size = static_cast<long long>(arr.size());
+    auto normalize = [size](long long index) {
+        return index < 0 ? size + index : index;
+    };
+
+    switch (s.kind) {
+        case selector_kind::name:
+            break;
+        case selector_kind::wildcard:
+        case selector_kind::filter:
+            for (const json_value& element : arr) {
+                if (s.kind == selector_kind::wildcard || test(s.filter, element, root)) {
+                    out.push_back(&element);
+                }
+            }
+
+            break;
+        case selector_kind::index: {
+            long long index = normalize(s.index);
+            if (index >= 0 && index < size) {
+                out.push_back(&arr[static_cast<size_t>(index)]);
+            }
+
+            break;
+        }
+        case selector_kind::slice:
+            if (s.step > 0) {
+                long long lower = std::clamp(s.has_start ? normalize(s.index) : 0, 0LL, size);
+                long long upper = std::clamp(s.has_end ? normalize(s.end) : size, 0LL, size);
+                for (long long i = lower; i < upper; i = upper - i > s.step ? i + s.step : upper) {
+                    out.push_back(&arr[static_cast<size_t>(i)]);
+                }
+            }
+            else if (s.step < 0) {
+                long long upper = std::clamp(s.has_start ? normalize(s.index) : size - 1, -1LL, size - 1);
+                long long lower = std::clamp(s.has_end ? normalize(s.end) : -size - 1, -1LL, size - 1);
+                for (long long i = upper; i > lower; i = i - lower > -s.step ? i + s.step : lower) {
+                    out.push_back(&arr[static_cast<size_t>(i)]);
+                }
+            }
+
+            break;
+    }
+}
+
+bool json_path::test(size_t index, const json_value& current, const json_value& root) const {
+    const condition& c = conditions_[index];
+    switch (c.kind) {
+        case condition_kind::any:
+            return test(c.left, current, root) || test(c.right, current, root);
+        case condition_kind::all:
+            return test(c.left, current, root) && test(c.right, current, root);
+        case condition_kind::negation:
+            return !test(c.left, current, root);
+        case condition_kind::exists: {
+            std::vector<const json_value*> found;
+            run(c.path, 0, c.path.absolute ? root : current, root, found);
+            return !found.empty();
+        }
+        default:
+            break;
+    }
+
+    // A missing value only equals another missing value
+    const json_value* a = resolve(c.lhs, current, root);
+    const json_value* b = resolve(c.rhs, current, root);
+    bool equal = a && b ? *a == *b : a == b;
+    switch (c.op) {
+        case compare_op::equal:
+            return equal;
+        case compare_op::not_equal:
+            return !equal;
+        case compare_op::less:
+            return less(a, b);
+        case compare_op::less_equal:
+            return less(a, b) || equal;
+        case compare_op::greater:
+            return less(b, a);
+        default:
+            return less(b, a) || equal;
+    }
+}
+
+const json_value* json_path::resolve(const operand& o, const json_value& current, const json_value& root) const {
+    if (!o.is_query) {
+        return &o.literal;
+    }
+
+    const json_value* node = o.path.absolute ? &root : &current;
+    for (const segment& s : o.path.segments) {
+        const selector& sel = s.selectors[0];
+        if (sel.kind == selector_kind::name) {
+            node = node->is_object() ? node->as_object().find(sel.name) : nullptr;
+        }
+        else if (node->is_array()) {
+            long long size = static_cast<long long>(node->as_array().size());
+            long long index = sel.index < 0 ? size + sel.index : sel.index;
+            node = index >= 0 && index < size ? &node->as_array()[static_cast<size_t>(index)] : nullptr;
+        }
+        else {
+            node = nullptr;
+        }
+
+        if (!node) {
+            return nullptr;
+        }
+    }
+
+    return node;
+}
+
+bool json_path::matches(const selector& s, bool is_object, std::string_view key, size_t position) {
+    long long at = static_cast<long long>(position);
+    switch (s.kind) {
+        case selector_kind::name:
+            return is_object && key == s.name;
+        case selector_kind::wildcard:
+            return true;
+        case selector_kind::index:
+            return !is_object && s.index == at;
+        case selector_kind::slice:
+            return !is_object && s.step > 0 && at >= (s.has_start ? s.index : 0) && (!s.has_end || at < s.end) &&
+                   (at - (s.has_start ? s.index : 0)) % s.step == 0;
+        default:
+            return false;
+    }
+}
+
+bool json_path::needs_length(const selector& s) {
+    if (s.kind == selector_kind::index) {
+        return s.index < 0;
+    }
+
+    return s.kind == selector_kind::slice && (s.step < 0 || (s.has_start && s.index < 0) || (s.has_end && s.end < 0));
+}
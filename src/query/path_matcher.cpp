@@ -0,0 +1,276 @@
+#include "../../include/query/path_matcher.hpp"
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+    // Merges routes to the same state, so the lists stay as short as the
+    // plan however many routes there are
+    template <typename State>
+    void add_state(std::vector<State>& states, size_t state, size_t count) {
+        auto it = std::find_if(states.begin(), states.end(), [state](const State& s) { return s.state == state; });
+        if (it == states.end()) {
+            states.push_back({state, count});
+        }
+        else {
+            it->count = count > std::numeric_limits<size_t>::max() - it->count ? std::numeric_limits<size_t>::max()
+                                                                               : it->count + count;
+        }
+    }
+}
+
+path_matcher::path_matcher(const json_path& path, std::function<void(const json_value&)> on_match,
+                           const parse_options& options)
+    : path_(path), on_match_(std::move(on_match)), skip_depth_(0), builder_(capture_, false, options),
+      capture_depth_(0), failure_(parse_error::none) {
+    if (!path.streams()) {
+        throw std::runtime_error("JSONPath query refers to the root from a filter and cannot stream");
+    }
+}
+
+bool path_matcher::null_value() {
+    return !start_scalar() || finish_scalar(builder_.null_value());
+}
+
+bool path_matcher::boolean_value(bool value) {
+    return !start_scalar() || finish_scalar(builder_.boolean_value(value));
+}
+
+bool path_matcher::number_value(std::string& lexeme) {
+    return !start_scalar() || finish_scalar(builder_.number_value(lexeme));
+}
+
+bool path_matcher::string_value(std::string& value) {
+    return !start_scalar() || finish_scalar(builder_.string_value(value));
+}
+
+bool path_matcher::begin_object() {
+    return begin_container(true);
+}
+
+bool path_matcher::key(std::string& key) {
+    if (capture_depth_ > 0) {
+        return accept(builder_.key(key));
+    }
+
+    if (skip_depth_ == 0) {
+        key_ = key;
+    }
+
+    return true;
+}
+
+bool path_matcher::end_object() {
+    return end_container(true);
+}
+
+bool path_matcher::begin_array() {
+    return begin_container(false);
+}
+
+bool path_matcher::end_array() {
+    return end_container(false);
+}
+
+parse_error path_matcher::failure() const {
+    return failure_;
+}
+
+std::exception_ptr path_matcher::exception() const {
+    return exception_;
+}
+
+// Gathers the states of the value about to start from the container it is
+// in, or the initial state for the root
+bool path_matcher::start_value() {
+    next_.clear();
+    pending_.clear();
+    if (stack_.empty()) {
+        next_.push_back({0, 1});
+        return true;
+    }
+
+    const frame& top = stack_.back();
+    for (size_t i = top.states_begin; i < states_.size(); ++i) {
+        state_count active = states_[i];
+        const json_path::segment& s = path_.plan_.segments[active.state];
+        if (s.descendant) {
+            add_state(next_, active.state, active.count);
+        }
+
+        for (size_t j = 0; j < s.selectors.size(); ++j) {
+            const json_path::selector& sel = s.selectors[j];
+            if (sel.kind == json_path::selector_kind::filter) {
+                pending_.push_back({active.state, j, active.count});
+            }
+            else if (json_path::matches(sel, top.is_object, key_, top.count)) {
+                add_state(next_, active.state + 1, active.count);
+            }
+        }
+    }
+
+    return !next_.empty() || !pending_.empty();
+}
+
+// Returns whether the scalar is to be built, as part of a captured value
+// or on its own
+bool path_matcher::start_scalar() {
+    if (capture_depth_ > 0) {
+        return true;
+    }
+
+    if (skip_depth_ > 0) {
+        return false;
+    }
+
+    if (!start_value()) {
+        finish_value();
+        return false;
+    }
+
+    capture_states_.swap(next_);
+    capture_pending_.swap(pending_);
+    return true;
+}
+
+bool path_matcher::finish_scalar(bool accepted) {
+    if (!accept(accepted)) {
+        return false;
+    }
+
+    if (capture_depth_ == 0) {
+        if (!finish_capture()) {
+            return false;
+        }
+
+        finish_value();
+    }
+
+    return true;
+}
+
+bool path_matcher::begin_container(bool is_object) {
+    if (capture_depth_ > 0) {
+        ++capture_depth_;
+        return accept(is_object ? builder_.begin_object() : builder_.begin_array());
+    }
+
+    if (skip_depth_ > 0) {
+        ++skip_depth_;
+        return true;
+    }
+
+    if (!start_value()) {
+        skip_depth_ = 1;
+        return true;
+    }
+
+    const std::vector<json_path::segment>& segments = path_.plan_.segments;
+    bool capture = !pending_.empty();
+    for (const state_count& s : next_) {
+        capture = capture || s.state == segments.size() ||
+                  (!is_object && std::any_of(segments[s.state].selectors.begin(),
+                                             segments[s.state].selectors.end(), json_path::needs_length));
+    }
+
+    if (capture) {
+        capture_states_.swap(next_);
+        capture_pending_.swap(pending_);
+        capture_depth_ = 1;
+        return accept(is_object ? builder_.begin_object() : builder_.begin_array());
+    }
+
+    stack_.push_back({is_object, 0, states_.size()});
+    states_.insert(states_.end(), next_.begin(), next_.end());
+    return true;
+}
+
+bool path_matcher::end_container(bool is_object) {
+    if (capture_depth_ > 0) {
+        if (!accept(is_object ? builder_.end_object() : builder_.end_array())) {
+            return false;
+        }
+
+        if (--capture_depth_ == 0) {
+            if (!finish_capture()) {
+                return false;
+            }
+
+            finish_value();
+        }
+
+        return true;
+    }
+
+    if (skip_depth_ > 0) {
+        if (--skip_depth_ == 0) {
+            finish_value();
+        }
+
+        return true;
+    }
+
+    states_.resize(stack_.back().states_begin);
+    stack_.pop_back();
+    finish_value();
+    return true;
+}
+
+bool path_matcher::accept(bool accepted) {
+    if (!accepted) {
+        failure_ = builder_.failure();
+    }
+
+    return accepted;
+}
+
+// Runs the rest of the plan over the built value; filters see only the
+// value, since the query does not refer to the root. An exception from
+// on_match stops the parse and is kept for the caller, since the parser
+// cannot pass it through.
+bool path_matcher::finish_capture() {
+    const std::vector<json_path::segment>& segments = path_.plan_.segments;
+    try {
+        for (const pending_filter& filter : capture_pending_) {
+            const json_path::selector& sel = segments[filter.segment].selectors[filter.selector];
+            if (path_.test(sel.filter, capture_, capture_)) {
+                add_state(capture_states_, filter.segment + 1, filter.count);
+            }
+        }
+
+        for (const state_count& s : capture_states_) {
+            if (s.state == segments.size()) {
+                report(capture_, s.count);
+            }
+        }
+
+        for (const state_count& s : capture_states_) {
+            if (s.state < segments.size()) {
+                matches_.clear();
+                path_.run(path_.plan_, s.state, capture_, capture_, matches_);
+                for (const json_value* match : matches_) {
+                    report(*match, s.count);
+                }
+            }
+        }
+    } catch (...) {
+        exception_ = std::current_exception();
+        failure_ = parse_error::rejected_by_handler;
+        return false;
+    }
+
+    capture_ = json_value();
+    return true;
+}
+
+void path_matcher::report(const json_value& match, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        on_match_(match);
+    }
+}
+
+void path_matcher::finish_value() {
+    if (!stack_.empty()) {
+        ++stack_.back().count;
+    }
+}
@@ -0,0 +1,883 @@
+#include "../../include/schema/json_schema.hpp"
+#include "../../include/schema/schema_validator.hpp"
+#include "../../include/parser/parser.hpp"
+#include "../../include/parser/tree_builder.hpp"
+#include "../../include/types/json_array.hpp"
+#include "../../include/types/json_boolean.hpp"
+#include "../../include/types/json_number.hpp"
+#include "../../include/types/json_object.hpp"
+#include "../../include/types/json_string.hpp"
+#include "../../include/utils/json_patch.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <functional>
+#include <stdexcept>
+
+namespace {
+    // In the order of json_schema::type_bits
+    const char* const type_names[] = {"null", "boolean", "integer", "number", "string", "array", "object"};
+
+    bool fail(validation_result* result, const std::string& path, std::string message) {
+        if (result) {
+            *result = validation_result(path, std::move(message));
+        }
+
+        return false;
+    }
+
+    bool is_integer(double value) {
+        return std::isfinite(value) && value == std::floor(value);
+    }
+
+    // Lengths count code points, so continuation bytes are skipped
+    size_t code_points(std::string_view text) {
+        size_t count = 0;
+        for (char c : text) {
+            if ((static_cast<unsigned char>(c) & 0xC0) != 0x80) {
+                ++count;
+            }
+        }
+
+        return count;
+    }
+
+    std::string describe_types(std::uint8_t types) {
+        std::string names;
+        for (size_t bit = 0; bit < 7; ++bit) {
+            if (types & (1u << bit)) {
+                names += names.empty() ? "expected " : " or ";
+                names += type_names[bit];
+            }
+        }
+
+        return names.empty() ? "no type is allowed" : names;
+    }
+
+    std::string format(double value) {
+        std::string out;
+        json_number::write(out, value);
+        return out;
+    }
+
+    std::string quoted(std::string_view text) {
+        return "\"" + std::string(text) + "\"";
+    }
+
+    // A $ref fragment is a JSON Pointer that may be percent-encoded
+    std::string decode_fragment(std::string_view fragment) {
+        std::string decoded;
+        for (size_t i = 0; i < fragment.size(); ++i) {
+            if (fragment[i] == '%' && i + 2 < fragment.size() && std::isxdigit(static_cast<unsigned char>(fragment[i + 1])) &&
+                std::isxdigit(static_cast<unsigned char>(fragment[i + 2]))) {
+                decoded += static_cast<char>(std::stoi(std::string(fragment.substr(i + 1, 2)), nullptr, 16));
+                i += 2;
+            }
+            else {
+                decoded += fragment[i];
+            }
+        }
+
+        return decoded;
+    }
+}
+
+// validation_result implementations
+validation_result::validation_result() : ok_(true) {}
+
+validation_result::validation_result(std::string path, std::string message)
+    : ok_(false), path_(std::move(path)), message_(std::move(message)) {}
+
+bool validation_result::ok() const {
+    return ok_;
+}
+
+validation_result::operator bool() const {
+    return ok_;
+}
+
+const std::string& validation_result::path() const {
+    return path_;
+}
+
+const std::string& validation_result::message() const {
+    return message_;
+}
+
+std::string validation_result::describe() const {
+    if (ok_) {
+        return "Valid";
+    }
+
+    return "Schema violation at " + (path_.empty() ? std::string("document root") : path_) + ": " + message_;
+}
+
+// json_schema implementations
+struct json_schema::compilation {
+    const json_value& document;
+    // Nodes by the JSON Pointer of their subschema, so references to a
+    // subschema share its node and recursive references terminate
+    std::unordered_map<std::string, size_t> compiled;
+};
+
+json_schema::json_schema(const json_value& schema) {
+    compilation state{schema, {}};
+    root_ = compile(schema, "", state);
+    check_cycles();
+}
+
+validation_result json_schema::validate(const json_value& instance) const {
+    validation_result result;
+    std::string path;
+    check(root_, instance, path, &result);
+    return result;
+}
+
+json_value json_schema::parse(const std::string& text, const parse_options& options) const {
+    json_value root;
+    tree_builder builder(root, false, options);
+    schema_validator validator(*this, &builder);
+    parser p(text, options);
+    parse_result result = p.try_parse(validator);
+    if (result.error() == parse_error::schema_violation) {
+        throw std::runtime_error(validator.result().describe() + " (line " + std::to_string(result.line()) +
+                                 ", column " + std::to_string(result.column()) + ")");
+    }
+
+    if (!result) {
+        throw std::runtime_error(result.describe());
+    }
+
+    return root;
+}
+
+validation_result json_schema::validate_text(const std::string& text, const parse_options& options) const {
+    schema_validator validator(*this);
+    parser p(text, options);
+    parse_result result = p.try_parse(validator);
+    if (result.error() == parse_error::schema_violation) {
+        return validator.result();
+    }
+
+    if (!result) {
+        return validation_result("", result.describe());
+    }
+
+    return validation_result();
+}
+
+size_t json_schema::compile(const json_value& schema, const std::string& pointer, compilation& state) {
+    auto known = state.compiled.find(pointer);
+    if (known != state.compiled.end()) {
+        return known->second;
+    }
+
+    size_t index = nodes_.size();
+    nodes_.emplace_back();
+    state.compiled.emplace(pointer, index);
+    if (schema.is_boolean()) {
+        nodes_[index].never = !schema.as_boolean().get_value();
+        return index;
+    }
+
+    auto invalid = [&pointer](std::string_view keyword, const std::string& detail) {
+        return std::runtime_error("Invalid schema at #" + pointer + ": " + std::string(keyword) + " " + detail);
+    };
+
+    if (!schema.is_object()) {
+        throw std::runtime_error("Invalid schema at #" + pointer + ": expected an object or a boolean");
+    }
+
+    const json_object& keywords = schema.as_object();
+    for (const char* keyword : {"$dynamicRef", "$recursiveRef", "unevaluatedItems", "unevaluatedProperties"}) {
+        if (keywords.contains(keyword)) {
+            throw std::runtime_error("Unsupported schema keyword: " + std::string(keyword));
+        }
+    }
+
+    auto location = [&pointer](std::string_view keyword, std::string_view member) {
+        std::string path = pointer;
+        append_key(path, keyword);
+        if (!member.empty()) {
+            append_key(path, member);
+        }
+
+        return path;
+    };
+
+    auto subschema = [&](std::string_view keyword) {
+        const json_value* value = keywords.find(keyword);
+        return value ? compile(*value, location(keyword, {}), state) : none;
+    };
+
+    auto subschemas = [&](std::string_view keyword, std::vector<size_t>& out) {
+        const json_value* value = keywords.find(keyword);
+        if (!value) {
+            return;
+        }
+
+        if (!value->is_array() || value->as_array().empty()) {
+            throw invalid(keyword, "must be a non-empty array");
+        }
+
+        const json_array& list = value->as_array();
+        for (size_t i = 0; i < list.size(); ++i) {
+            std::string path = location(keyword, {});
+            append_index(path, i);
+            out.push_back(compile(list[i], path, state));
+        }
+    };
+
+    auto members = [&](std::string_view keyword) -> const json_object* {
+        const json_value* value = keywords.find(keyword);
+        if (value && !value->is_object()) {
+            throw invalid(keyword, "must be an object");
+        }
+
+        return value ? &value->as_object() : nullptr;
+    };
+
+    auto number = [&](std::string_view keyword, double& out) {
+        const json_value* value = keywords.find(keyword);
+        if (value && !value->is_number()) {
+            throw invalid(keyword, "must be a number");
+        }
+
+        if (value) {
+            out = value->as_number().get_value();
+        }
+
+        return value != nullptr;
+    };
+
+    auto count = [&](std::string_view keyword, size_t& out) {
+        double value = 0.0;
+        if (!number(keyword, value)) {
+            return;
+        }
+
+        if (!is_integer(value) || value < 0) {
+            throw invalid(keyword, "must be a non-negative integer");
+        }
+
+        out = value >= 1.8e19 ? none : static_cast<size_t>(value);
+    };
+
+    auto strings = [&](std::string_view keyword, const json_value& value) {
+        std::vector<std::string> out;
+        if (!value.is_array()) {
+            throw invalid(keyword, "must be an array of strings");
+        }
+
+        for (const json_value& element : value.as_array()) {
+            if (!element.is_string()) {
+                throw invalid(keyword, "must be an array of strings");
+            }
+
+            out.push_back(element.as_string().get_value());
+        }
+
+        return out;
+    };
+
+    auto pattern = [&](std::string_view keyword, const std::string& source) {
+        try {
+            patterns_.emplace_back(source);
+        } catch (const std::runtime_error& e) {
+            throw invalid(keyword, "has an invalid pattern " + quoted(source) + ": " + e.what());
+        }
+
+        return patterns_.size() - 1;
+    };
+
+    node n;
+    if (const json_value* type = keywords.find("type")) {
+        std::vector<std::string> names = type->is_string() ? std::vector<std::string>{type->as_string().get_value()}
+                                                           : strings("type", *type);
+        n.types = 0;
+        for (const std::string& name : names) {
+            auto bit = std::find(std::begin(type_names), std::end(type_names), name);
+            if (bit == std::end(type_names)) {
+                throw invalid("type", "has unknown type " + quoted(name));
+            }
+
+            n.types |= static_cast<std::uint8_t>(1u << (bit - std::begin(type_names)));
+        }
+    }
+
+    if (const json_value* values = keywords.find("enum")) {
+        if (!values->is_array()) {
+            throw invalid("enum", "must be an array");
+        }
+
+        n.has_enum = true;
+        n.enum_values.assign(values->as_array().begin(), values->as_array().end());
+    }
+
+    if (const json_value* value = keywords.find("const")) {
+        n.has_enum = true;
+        n.enum_values.assign(1, *value);
+    }
+
+    number("minimum", n.minimum);
+    number("maximum", n.maximum);
+    // Draft 4 spells these as booleans modifying minimum and maximum
+    double bound = 0.0;
+    if (const json_value* exclusive = keywords.find("exclusiveMinimum"); exclusive && exclusive->is_boolean()) {
+        n.exclusive_minimum = exclusive->as_boolean().get_value();
+    }
+    else if (number("exclusiveMinimum", bound) && bound >= n.minimum) {
+        n.minimum = bound;
+        n.exclusive_minimum = true;
+    }
+
+    if (const json_value* exclusive = keywords.find("exclusiveMaximum"); exclusive && exclusive->is_boolean()) {
+        n.exclusive_maximum = exclusive->as_boolean().get_value();
+    }
+    else if (number("exclusiveMaximum", bound) && bound <= n.maximum) {
+        n.maximum = bound;
+        n.exclusive_maximum = true;
+    }
+
+    if (number("multipleOf", n.multiple_of) && !(n.multiple_of > 0)) {
+        throw invalid("multipleOf", "must be greater than 0");
+    }
+
+    count("minLength", n.min_length);
+    count("maxLength", n.max_length);
+    if (const json_value* source = keywords.find("pattern")) {
+        if (!source->is_string()) {
+            throw invalid("pattern", "must be a string");
+        }
+
+        n.pattern = pattern("pattern", source->as_string().get_value());
+    }
+
+    // Before 2020-12, an array of items was what prefixItems is now
+    const json_value* items = keywords.find("items");
+    if (keywords.contains("prefixItems")) {
+        subschemas("prefixItems", n.prefix_items);
+        n.items = subschema("items");
+    }
+    else if (items && items->is_array()) {
+        subschemas("items", n.prefix_items);
+        n.items = subschema("additionalItems");
+    }
+    else {
+        n.items = subschema("items");
+    }
+
+    count("minItems", n.min_items);
+    count("maxItems", n.max_items);
+    if (const json_value* unique = keywords.find("uniqueItems")) {
+        if (!unique->is_boolean()) {
+            throw invalid("uniqueItems", "must be a boolean");
+        }
+
+        n.unique_items = unique->as_boolean().get_value();
+    }
+
+    n.contains = subschema("contains");
+    count("minContains", n.min_contains);
+    count("maxContains", n.max_contains);
+
+    if (const json_object* properties = members("properties")) {
+        for (const auto& entry : *properties) {
+            n.properties.emplace(entry.first, compile(entry.second, location("properties", entry.first), state));
+        }
+    }
+
+    if (const json_object* properties = members("patternProperties")) {
+        for (const auto& entry : *properties) {
+            size_t source = pattern("patternProperties", entry.first);
+            n.pattern_properties.push_back({source, compile(entry.second, location("patternProperties", entry.first), state)});
+        }
+    }
+
+    n.additional_properties = subschema("additionalProperties");
+    n.property_names = subschema("propertyNames");
+    if (const json_value* required = keywords.find("required")) {
+        n.required = strings("required", *required);
+        for (size_t i = 0; i < n.required.size(); ++i) {
+            n.required_index.emplace(n.required[i], i);
+        }
+    }
+
+    count("minProperties", n.min_properties);
+    count("maxProperties", n.max_properties);
+    if (const json_object* dependencies = members("dependentRequired")) {
+        for (const auto& entry : *dependencies) {
+            n.dependent_required.push_back({entry.first, strings("dependentRequired", entry.second)});
+        }
+    }
+
+    if (const json_object* dependencies = members("dependentSchemas")) {
+        for (const auto& entry : *dependencies) {
+            n.dependent_schemas.push_back({entry.first, compile(entry.second, location("dependentSchemas", entry.first), state)});
+        }
+    }
+
+    // Drafts 4 to 7 combine both in dependencies
+    if (const json_object* dependencies = members("dependencies")) {
+        for (const auto& entry : *dependencies) {
+            if (entry.second.is_array()) {
+                n.dependent_required.push_back({entry.first, strings("dependencies", entry.second)});
+            }
+            else {
+                n.dependent_schemas.push_back({entry.first, compile(entry.second, location("dependencies", entry.first), state)});
+            }
+        }
+    }
+
+    subschemas("allOf", n.all_of);
+    subschemas("anyOf", n.any_of);
+    subschemas("oneOf", n.one_of);
+    n.not_schema = subschema("not");
+    if (keywords.contains("if")) {
+        n.if_schema = subschema("if");
+        n.then_schema = subschema("then");
+        n.else_schema = subschema("else");
+    }
+
+    if (const json_value* ref = keywords.find("$ref")) {
+        if (!ref->is_string()) {
+            throw invalid("$ref", "must be a string");
+        }
+
+        n.all_of.push_back(resolve(ref->as_string().get_value(), state));
+    }
+
+    n.streams = !n.has_enum && !n.unique_items && n.contains == none && n.dependent_required.empty() &&
+                n.dependent_schemas.empty() && n.any_of.empty() && n.one_of.empty() && n.not_schema == none &&
+                n.if_schema == none;
+    nodes_[index] = std::move(n);
+    return index;
+}
+
+// Only references within the schema document are supported
+size_t json_schema::resolve(const std::string& ref, compilation& state) {
+    if (ref.empty() || ref[0] != '#') {
+        throw std::runtime_error("Unsupported schema reference: " + ref);
+    }
+
+    std::string pointer = decode_fragment(std::string_view(ref).substr(1));
+    if (!pointer.empty() && pointer[0] != '/') {
+        throw std::runtime_error("Unsupported schema reference: " + ref);
+    }
+
+    const json_value* target = json_patch::find(state.document, pointer);
+    if (!target) {
+        throw std::runtime_error("Unresolvable schema reference: " + ref);
+    }
+
+    return compile(*target, pointer, state);
+}
+
+// Applicators that evaluate subschemas against the same value must not
+// loop through references, or validation would never terminate
+void json_schema::check_cycles() const {
+    std::vector<std::uint8_t> state(nodes_.size(), 0);
+    std::function<void(size_t)> visit = [&](size_t index) {
+        if (index == none || state[index] == 2) {
+            return;
+        }
+
+        if (state[index] == 1) {
+            throw std::runtime_error("Invalid schema: $ref cycle that does not descend into the instance");
+        }
+
+        state[index] = 1;
+        const node& n = nodes_[index];
+        for (const std::vector<size_t>* list : {&n.all_of, &n.any_of, &n.one_of}) {
+            for (size_t sub : *list) {
+                visit(sub);
+            }
+        }
+
+        for (const auto& dependency : n.dependent_schemas) {
+            visit(dependency.second);
+        }
+
+        visit(n.not_schema);
+        visit(n.if_schema);
+        visit(n.then_schema);
+        visit(n.else_schema);
+        state[index] = 2;
+    };
+
+    for (size_t index = 0; index < nodes_.size(); ++index) {
+        visit(index);
+    }
+}
+
+// Subschemas evaluated only to see whether they match report nothing
+template <typename Evaluate>
+bool json_schema::check_applicators(const node& n, Evaluate evaluate, const std::string& path,
+                                    validation_result* result) const {
+    for (size_t sub : n.all_of) {
+        if (!evaluate(sub, result)) {
+            return false;
+        }
+    }
+
+    if (!n.any_of.empty() &&
+        std::none_of(n.any_of.begin(), n.any_of.end(), [&evaluate](size_t sub) { return evaluate(sub, nullptr); })) {
+        return fail(result, path, "does not match any schema in anyOf");
+    }
+
+    if (!n.one_of.empty()) {
+        size_t matched = 0;
+        for (size_t sub : n.one_of) {
+            matched += evaluate(sub, nullptr) ? 1 : 0;
+        }
+
+        if (matched != 1) {
+            return fail(result, path, "matches " + std::to_string(matched) + " schemas in oneOf instead of one");
+        }
+    }
+
+    if (n.not_schema != none && evaluate(n.not_schema, nullptr)) {
+        return fail(result, path, "matches the schema in not");
+    }
+
+    if (n.if_schema != none) {
+        size_t branch = evaluate(n.if_schema, nullptr) ? n.then_schema : n.else_schema;
+        if (branch != none && !evaluate(branch, result)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool json_schema::check(size_t index, const json_value& value, std::string& path, validation_result* result) const {
+    if (!value.is_array() && !value.is_object()) {
+        scalar s{value.type(), false, 0.0, {}};
+        if (value.is_boolean()) {
+            s.boolean = value.as_boolean().get_value();
+        }
+        else if (value.is_number()) {
+            s.number = value.as_number().get_value();
+        }
+        else if (value.is_string()) {
+            s.text = value.as_string().get_view();
+        }
+
+        return check_scalar(index, s, path, result);
+    }
+
+    const node& n = nodes_[index];
+    bool is_object = value.is_object();
+    if (!check_open(index, is_object, path, result)) {
+        return false;
+    }
+
+    if (n.has_enum && std::find(n.enum_values.begin(), n.enum_values.end(), value) == n.enum_values.end()) {
+        return fail(result, path, "is not one of the allowed values");
+    }
+
+    if (!(is_object ? check_object(index, value, path, result) : check_array(index, value, path, result))) {
+        return false;
+    }
+
+    return check_applicators(n, [this, &value, &path](size_t sub, validation_result* r) {
+        return check(sub, value, path, r);
+    }, path, result);
+}
+
+bool json_schema::check_scalar(size_t index, const scalar& value, const std::string& path,
+                               validation_result* result) const {
+    const node& n = nodes_[index];
+    if (n.never) {
+        return fail(result, path, "is not allowed");
+    }
+
+    bool allowed;
+    switch (value.type) {
+        case json_type::null:
+            allowed = n.types & null_type;
+            break;
+        case json_type::boolean:
+            allowed = n.types & boolean_type;
+            break;
+        case json_type::number:
+            allowed = (n.types & number_type) || ((n.types & integer_type) && is_integer(value.number));
+            break;
+        default:
+            allowed = n.types & string_type;
+            break;
+    }
+
+    if (!allowed) {
+        return fail(result, path, describe_types(n.types));
+    }
+
+    if (n.has_enum) {
+        bool found = std::any_of(n.enum_values.begin(), n.enum_values.end(), [&value](const json_value& candidate) {
+            switch (value.type) {
+                case json_type::null:
+                    return candidate.is_null();
+                case json_type::boolean:
+                    return candidate.is_boolean() && candidate.as_boolean().get_value() == value.boolean;
+                case json_type::number:
+                    return candidate.is_number() && candidate.as_number().get_value() == value.number;
+                default:
+                    return candidate.is_string() && candidate.as_string().get_view() == value.text;
+            }
+        });
+
+        if (!found) {
+            return fail(result, path, "is not one of the allowed values");
+        }
+    }
+
+    if (value.type == json_type::number) {
+        if (value.number < n.minimum || (n.exclusive_minimum && value.number == n.minimum)) {
+            return fail(result, path, (n.exclusive_minimum ? "must be greater than " : "must be at least ") + format(n.minimum));
+        }
+
+        if (value.number > n.maximum || (n.exclusive_maximum && value.number == n.maximum)) {
+            return fail(result, path, (n.exclusive_maximum ? "must be less than " : "must be at most ") + format(n.maximum));
+        }
+
+        // Relative tolerance, so that 0.3 is a multiple of 0.1
+        if (n.multiple_of > 0) {
+            double quotient = value.number / n.multiple_of;
+            if (std::fabs(quotient - std::round(quotient)) > 1e-9 * std::max(1.0, std::fabs(quotient))) {
+                return fail(result, path, "must be a multiple of " + format(n.multiple_of));
+            }
+        }
+    }
+    else if (value.type == json_type::string) {
+        if (n.min_length > 0 || n.max_length != none) {
+            size_t length = code_points(value.text);
+            if (length < n.min_length) {
+                return fail(result, path, "must be at least " + std::to_string(n.min_length) + " characters long");
+            }
+
+            if (length > n.max_length) {
+                return fail(result, path, "must be at most " + std::to_string(n.max_length) + " characters long");
+            }
+        }
+
+        if (n.pattern != none && !patterns_[n.pattern].search(value.text)) {
+            return fail(result, path, "does not match the pattern");
+        }
+    }
+
+    return check_applicators(n, [this, &value, &path](size_t sub, validation_result* r) {
+        return check_scalar(sub, value, path, r);
+    }, path, result);
+}
+
+bool json_schema::check_array(size_t index, const json_value& value, std::string& path,
+                              validation_result* result) const {
+    const node& n = nodes_[index];
+    const json_array& arr = value.as_array();
+    if (!check_close(index, false, arr.size(), nullptr, path, result)) {
+        return false;
+    }
+
+    size_t length = path.size();
+    for (size_t i = 0; i < arr.size(); ++i) {
+        size_t sub = i < n.prefix_items.size() ? n.prefix_items[i] : n.items;
+        if (sub == none) {
+            continue;
+        }
+
+        append_index(path, i);
+        bool ok = check(sub, arr[i], path, result);
+        path.resize(length);
+        if (!ok) {
+            return false;
+        }
+    }
+
+    if (n.unique_items) {
+        std::unordered_map<size_t, std::vector<size_t>> seen;
+        for (size_t i = 0; i < arr.size(); ++i) {
+            std::vector<size_t>& bucket = seen[arr[i].hash()];
+            for (size_t j : bucket) {
+                if (arr[j] == arr[i]) {
+                    return fail(result, path, "has equal items at " + std::to_string(j) + " and " + std::to_string(i));
+                }
+            }
+
+            bucket.push_back(i);
+        }
+    }
+
+    if (n.contains != none) {
+        size_t matches = 0;
+        for (const json_value& element : arr) {
+            matches += check(n.contains, element, path, nullptr) ? 1 : 0;
+        }
+
+        if (matches < n.min_contains) {
+            return fail(result, path, "has " + std::to_string(matches) + " items matching contains, fewer than " +
+                                      std::to_string(n.min_contains));
+        }
+
+        if (matches > n.max_contains) {
+            return fail(result, path, "has " + std::to_string(matches) + " items matching contains, more than " +
+                                      std::to_string(n.max_contains));
+        }
+    }
+
+    return true;
+}
+
+bool json_schema::check_object(size_t index, const json_value& value, std::string& path,
+                               validation_result* result) const {
+    const node& n = nodes_[index];
+    const json_object& obj = value.as_object();
+    if (!check_close(index, true, obj.size(), nullptr, path, result)) {
+        return false;
+    }
+
+    for (const std::string& name : n.required) {
+        if (!obj.contains(name)) {
+            return fail(result, path, "is missing required property " + quoted(name));
+        }
+    }
+
+    for (const auto& dependency : n.dependent_required) {
+        if (!obj.contains(dependency.first)) {
+            continue;
+        }
+
+        for (const std::string& name : dependency.second) {
+            if (!obj.contains(name)) {
+                return fail(result, path, "is missing property " + quoted(name) + ", required with " +
+                                          quoted(dependency.first));
+            }
+        }
+    }
+
+    size_t length = path.size();
+    std::vector<size_t> subs;
+    for (const auto& member : obj) {
+        append_key(path, member.first);
+        bool ok = n.property_names == none ||
+                  check_scalar(n.property_names, {json_type::string, false, 0.0, member.first}, path, result);
+        if (ok) {
+            subs.clear();
+            children(index, true, member.first, 0, subs);
+            ok = std::all_of(subs.begin(), subs.end(), [&](size_t sub) {
+                return check(sub, member.second, path, result);
+            });
+        }
+
+        path.resize(length);
+        if (!ok) {
+            return false;
+        }
+    }
+
+    for (const auto& dependency : n.dependent_schemas) {
+        if (obj.contains(dependency.first) && !check(dependency.second, value, path, result)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Appends the subschemas that apply to a member or element of a value the
+// node applies to
+void json_schema::children(size_t index, bool is_object, const std::string& key, size_t position,
+                           std::vector<size_t>& out) const {
+    const node& n = nodes_[index];
+    if (!is_object) {
+        size_t sub = position < n.prefix_items.size() ? n.prefix_items[position] : n.items;
+        if (sub != none) {
+            out.push_back(sub);
+        }
+
+        return;
+    }
+
+    bool matched = false;
+    auto property = n.properties.find(key);
+    if (property != n.properties.end()) {
+        out.push_back(property->second);
+        matched = true;
+    }
+
+    for (const auto& entry : n.pattern_properties) {
+        if (patterns_[entry.first].search(key)) {
+            out.push_back(entry.second);
+            matched = true;
+        }
+    }
+
+    if (!matched && n.additional_properties != none) {
+        out.push_back(n.additional_properties);
+    }
+}
+
+// Appends the node and, transitively, its allOf members and references
+void json_schema::expand(size_t index, std::vector<size_t>& out) const {
+    out.push_back(index);
+    for (size_t sub : nodes_[index].all_of) {
+        expand(sub, out);
+    }
+}
+
+bool json_schema::check_open(size_t index, bool is_object, const std::string& path, validation_result* result) const {
+    const node& n = nodes_[index];
+    if (n.never) {
+        return fail(result, path, "is not allowed");
+    }
+
+    if (!(n.types & (is_object ? object_type : array_type))) {
+        return fail(result, path, describe_types(n.types));
+    }
+
+    return true;
+}
+
+bool json_schema::check_close(size_t index, bool is_object, size_t count, const std::uint8_t* seen,
+                              const std::string& path, validation_result* result) const {
+    const node& n = nodes_[index];
+    const char* noun = is_object ? " properties" : " items";
+    size_t low = is_object ? n.min_properties : n.min_items;
+    size_t high = is_object ? n.max_properties : n.max_items;
+    if (count < low) {
+        return fail(result, path, "must have at least " + std::to_string(low) + noun);
+    }
+
+    if (count > high) {
+        return fail(result, path, "must have at most " + std::to_string(high) + noun);
+    }
+
+    if (seen) {
+        for (size_t i = 0; i < n.required.size(); ++i) {
+            if (!seen[i]) {
+                return fail(result, path, "is missing required property " + quoted(n.required[i]));
+            }
+        }
+    }
+
+    return true;
+}
+
+void json_schema::append_key(std::string& path, std::string_view key) {
+    path += '/';
+    for (char c : key) {
+        if (c == '~') {
+            path += "~0";
+        }
+        else if (c == '/') {
+            path += "~1";
+        }
+        else {
+            path += c;
+        }
+    }
+}
+
+void json_schema::append_index(std::string& path, size_t index) {
+    path += '/';
+    path += std::to_string(index);
+}
@@ -0,0 +1,737 @@
+#include "../../include/schema/schema_pattern.hpp"
+#include "../../include/utils/utf8.hpp"
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+
+namespace {
+    using range = std::pair<std::uint32_t, std::uint32_t>;
+
+    constexpr std::uint32_t max_code_point = 0x10ffff;
+    constexpr size_t unbounded = static_cast<size_t>(-1);
+    // Counted repetitions are expanded into copies, so the program is capped
+    constexpr size_t max_program = 65536;
+    constexpr size_t max_group_depth = 256;
+
+    void normalize(std::vector<range>& ranges) {
+        std::sort(ranges.begin(), ranges.end());
+        size_t out = 0;
+        for (const range& r : ranges) {
+            if (out > 0 && r.first <= ranges[out - 1].second + 1) {
+                ranges[out - 1].second = std::max(ranges[out - 1].second, r.second);
+            }
+            else {
+                ranges[out++] = r;
+            }
+        }
+
+        ranges.resize(out);
+    }
+
+    // Of normalized ranges
+    std::vector<range> complement(const std::vector<range>& ranges) {
+        std::vector<range> out;
+        std::uint32_t next = 0;
+        for (const range& r : ranges) {
+            if (r.first > next) {
+                out.push_back({next, r.first - 1});
+            }
+
+            next = r.second + 1;
+        }
+
+        if (next <= max_code_point) {
+            out.push_back({next, max_code_point});
+        }
+
+        return out;
+    }
+
+    bool contains(const std::vector<range>& ranges, std::uint32_t c) {
+        auto it = std::upper_bound(ranges.begin(), ranges.end(), range{c, max_code_point});
+        return it != ranges.begin() && std::prev(it)->second >= c;
+    }
+
+    bool is_word(std::uint32_t c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+    }
+
+    bool is_digit(char c) {
+        return c >= '0' && c <= '9';
+    }
+
+    int hex_digit(char c) {
+        if (c >= '0' && c <= '9') {
+            return c - '0';
+        }
+
+        if (c >= 'a' && c <= 'f') {
+            return c - 'a' + 10;
+        }
+
+        if (c >= 'A' && c <= 'F') {
+            return c - 'A' + 10;
+        }
+
+        return -1;
+    }
+
+    // The ranges of \d, \w, \s and their negations
+    std::vector<range> class_escape(char c) {
+        std::vector<range> ranges;
+        switch (c) {
+            case 'd':
+            case 'D':
+                ranges = {{'0', '9'}};
+                break;
+            case 'w':
+            case 'W':
+                ranges = {{'0', '9'}, {'A', 'Z'}, {'_', '_'}, {'a', 'z'}};
+                break;
+            default:
+                ranges = {{'\t', '\r'}, {' ', ' '}, {0xa0, 0xa0}, {0x1680, 0x1680}, {0x2000, 0x200a},
+                          {0x2028, 0x2029}, {0x202f, 0x202f}, {0x205f, 0x205f}, {0x3000, 0x3000}, {0xfeff, 0xfeff}};
+                break;
+        }
+
+        return c >= 'a' ? ranges : complement(ranges);
+    }
+
+    bool is_class_escape(char c) {
+        return c == 'd' || c == 'D' || c == 'w' || c == 'W' || c == 's' || c == 'S';
+    }
+}
+
+// Parses the pattern into a tree of nodes, then emits the program from it;
+// counted repetitions need the tree to copy their operand
+class schema_pattern::compiler {
+public:
+    compiler(std::string_view source, schema_pattern& pattern)
+        : source_(source), pattern_(pattern), pos_(0), depth_(0) {}
+
+    void run() {
+        node root = disjunction();
+        if (pos_ < source_.size()) {
+            fail("unmatched )");
+        }
+
+        emit(root);
+        add(op::match);
+    }
+
+private:
+    enum class kind : std::uint8_t { set, assertion, sequence, alternation, repeat };
+
+    struct node {
+        explicit node(kind type) : type(type) {}
+
+        kind type;
+        // Class index of a set, instruction of an assertion
+        size_t cls = 0;
+        op assertion = op::match;
+        size_t min = 0;
+        size_t max = 0;
+        std::vector<node> children;
+    };
+
+    std::string_view source_;
+    schema_pattern& pattern_;
+    size_t pos_;
+    size_t depth_;
+
+    [[noreturn]] void fail(const std::string& message) const {
+        throw std::runtime_error(message + " at offset " + std::to_string(pos_));
+    }
+
+    bool at(char c) const {
+        return pos_ < source_.size() && source_[pos_] == c;
+    }
+
+    std::uint32_t next_code_point() {
+        std::uint32_t c;
+        size_t length = utf8::decode(source_.data() + pos_, source_.size() - pos_, c);
+        if (length == 0) {
+            fail("invalid UTF-8");
+        }
+
+        pos_ += length;
+        return c;
+    }
+
+    node set(std::vector<range> ranges) {
+        normalize(ranges);
+        pattern_.classes_.push_back(std::move(ranges));
+        node n(kind::set);
+        n.cls = pattern_.classes_.size() - 1;
+        return n;
+    }
+
+    node disjunction() {
+        node n(kind::alternation);
+        n.children.push_back(alternative());
+        while (at('|')) {
+            ++pos_;
+            n.children.push_back(alternative());
+        }
+
+        if (n.children.size() == 1) {
+            return std::move(n.children.front());
+        }
+
+        return n;
+    }
+
+    node alternative() {
+        node n(kind::sequence);
+        while (pos_ < source_.size() && !at('|') && !at(')')) {
+            n.children.push_back(term());
+        }
+
+        return n;
+    }
+
+    node term() {
+        op assertion = op::match;
+        if (at('^')) {
+            assertion = op::line_begin;
+        }
+        else if (at('$')) {
+            assertion = op::line_end;
+        }
+        else if (at('\\') && pos_ + 1 < source_.size() && (source_[pos_ + 1] == 'b' || source_[pos_ + 1] == 'B')) {
+            assertion = source_[pos_ + 1] == 'b' ? op::word_boundary : op::not_word_boundary;
+            ++pos_;
+        }
+
+        size_t min;
+        size_t max;
+        if (assertion != op::match) {
+            ++pos_;
+            if (quantifier(min, max)) {
+                fail("nothing to repeat");
+            }
+
+            node n(kind::assertion);
+            n.assertion = assertion;
+            return n;
+        }
+
+        node operand = atom();
+        if (!quantifier(min, max)) {
+            return operand;
+        }
+
+        node n(kind::repeat);
+        n.min = min;
+        n.max = max;
+        n.children.push_back(std::move(operand));
+        return n;
+    }
+
+    // Consumes a quantifier and a lazy ? after it, if one is next. A { that
+    // does not start a valid count is a literal.
+    bool quantifier(size_t& min, size_t& max) {
+        if (at('*') || at('+') || at('?')) {
+            min = at('+') ? 1 : 0;
+            max = at('?') ? 1 : unbounded;
+            ++pos_;
+        }
+        else if (at('{')) {
+            size_t start = pos_++;
+            if (!count(min)) {
+                pos_ = start;
+                return false;
+            }
+
+            max = min;
+            if (at(',')) {
+                ++pos_;
+                max = unbounded;
+                if (pos_ < source_.size() && is_digit(source_[pos_])) {
+                    count(max);
+                }
+            }
+
+            if (!at('}')) {
+                pos_ = start;
+                return false;
+            }
+
+            ++pos_;
+            if (max < min) {
+                fail("numbers out of order in {} quantifier");
+            }
+        }
+        else {
+            return false;
+        }
+
+        if (at('?')) {
+            ++pos_;
+        }
+
+        return true;
+    }
+
+    // Saturates well above anything that fits in max_program
+    bool count(size_t& value) {
+        if (pos_ >= source_.size() || !is_digit(source_[pos_])) {
+            return false;
+        }
+
+        value = 0;
+        while (pos_ < source_.size() && is_digit(source_[pos_])) {
+            value = std::min<size_t>(value * 10 + static_cast<size_t>(source_[pos_] - '0'), max_program * 2);
+            ++pos_;
+        }
+
+        return true;
+    }
+
+    node atom() {
+        char c = source_[pos_];
+        switch (c) {
+            case '.':
+                ++pos_;
+                return set(complement({{'\n', '\n'}, {'\r', '\r'}, {0x2028, 0x2029}}));
+            case '(':
+                return group();
+            case '[':
+                return character_class();
+            case '\\': {
+                ++pos_;
+                if (pos_ >= source_.size()) {
+                    fail("\\ at end of pattern");
+                }
+
+                char e = source_[pos_];
+                if (is_class_escape(e)) {
+                    ++pos_;
+                    return set(class_escape(e));
+                }
+
+                if (e >= '1' && e <= '9') {
+                    fail("backreferences are not supported");
+                }
+
+                std::uint32_t code_point = character_escape();
+                return set({{code_point, code_point}});
+            }
+            case '*':
+            case '+':
+            case '?':
+                fail("nothing to repeat");
+            case '{': {
+                size_t min;
+                size_t max;
+                if (quantifier(min, max)) {
+                    fail("nothing to repeat");
+                }
+
+                ++pos_;
+                return set({{'{', '{'}});
+            }
+            default: {
+                std::uint32_t code_point = next_code_point();
+                return set({{code_point, code_point}});
+            }
+        }
+    }
+
+    node group() {
+        ++pos_;
+        if (at('?')) {
+            ++pos_;
+            if (at(':')) {
+                ++pos_;
+            }
+            else if (at('=') || at('!') || (at('<') && pos_ + 1 < source_.size() &&
+                                            (source_[pos_ + 1] == '=' || source_[pos_ + 1] == '!'))) {
+                fail("lookaround is not supported");
+            }
+            else if (at('<')) {
+                size_t end = source_.find('>', pos_);
+                if (end == std::string_view::npos || end == pos_ + 1) {
+                    fail("invalid group name");
+                }
+
+                pos_ = end + 1;
+            }
+            else {
+                fail("invalid group");
+            }
+        }
+
+        if (++depth_ > max_group_depth) {
+            fail("groups nest too deeply");
+        }
+
+        node inner = disjunction();
+        if (!at(')')) {
+            fail("missing )");
+        }
+
+        ++pos_;
+        --depth_;
+        return inner;
+    }
+
+    node character_class() {
+        ++pos_;
+        bool negate = at('^');
+        if (negate) {
+            ++pos_;
+        }
+
+        std::vector<range> ranges;
+        while (true) {
+            if (pos_ >= source_.size()) {
+                fail("missing ]");
+            }
+
+            if (at(']')) {
+                ++pos_;
+                break;
+            }
+
+            std::uint32_t low;
+            std::vector<range> escape;
+            bool single = class_atom(low, escape);
+            if (single && at('-') && pos_ + 1 < source_.size() && source_[pos_ + 1] != ']') {
+                ++pos_;
+                std::uint32_t high;
+                if (!class_atom(high, escape)) {
+                    // A class escape as an endpoint makes the - a literal
+                    ranges.push_back({low, low});
+                    ranges.push_back({'-', '-'});
+                    ranges.insert(ranges.end(), escape.begin(), escape.end());
+                    continue;
+                }
+
+                if (high < low) {
+                    fail("range out of order in character class");
+                }
+
+                ranges.push_back({low, high});
+            }
+            else if (single) {
+                ranges.push_back({low, low});
+            }
+            else {
+                ranges.insert(ranges.end(), escape.begin(), escape.end());
+            }
+        }
+
+        normalize(ranges);
+        return set(negate ? complement(ranges) : std::move(ranges));
+    }
+
+    // Reads one character of a class into code_point and returns true, or a
+    // class escape into ranges and returns false
+    bool class_atom(std::uint32_t& code_point, std::vector<range>& ranges) {
+        if (!at('\\')) {
+            code_point = next_code_point();
+            return true;
+        }
+
+        ++pos_;
+        if (pos_ >= source_.size()) {
+            fail("\\ at end of pattern");
+        }
+
+        char e = source_[pos_];
+        if (is_class_escape(e)) {
+            ++pos_;
+            ranges = class_escape(e);
+            return false;
+        }
+
+        if (e == 'b') {
+            ++pos_;
+            code_point = '\b';
+            return true;
+        }
+
+        if (e == '-') {
+            ++pos_;
+            code_point = '-';
+            return true;
+        }
+
+        code_point = character_escape();
+        return true;
+    }
+
+    // The escape after a backslash that stands for one character
+    std::uint32_t character_escape() {
+        char e = source_[pos_++];
+        switch (e) {
+            case 't':
+                return '\t';
+            case 'n':
+                return '\n';
+            case 'r':
+                return '\r';
+            case 'f':
+                return '\f';
+            case 'v':
+                return '\v';
+            case '0':
+                if (pos_ < source_.size() && is_digit(source_[pos_])) {
+                    fail("octal escapes are not supported");
+                }
+
+                return 0;
+            case 'c':
+                if (pos_ < source_.size() && ((source_[pos_] >= 'a' && source_[pos_] <= 'z') ||
+                                              (source_[pos_] >= 'A' && source_[pos_] <= 'Z'))) {
+                    return static_cast<std::uint32_t>(source_[pos_++] % 32);
+                }
+
+                fail("invalid control escape");
+            case 'x':
+                return hex(2);
+            case 'u': {
+                if (at('{')) {
+                    ++pos_;
+                    std::uint32_t value = 0;
+                    size_t digits = 0;
+                    while (pos_ < source_.size() && hex_digit(source_[pos_]) >= 0) {
+                        value = value * 16 + static_cast<std::uint32_t>(hex_digit(source_[pos_++]));
+                        if (value > max_code_point) {
+                            fail("invalid Unicode escape");
+                        }
+
+                        ++digits;
+                    }
+
+                    if (digits == 0 || !at('}')) {
+                        fail("invalid Unicode escape");
+                    }
+
+                    ++pos_;
+                    return value;
+                }
+
+                std::uint32_t unit = hex(4);
+                if (unit >= 0xd800 && unit <= 0xdbff && pos_ + 5 < source_.size() && source_[pos_] == '\\' &&
+                    source_[pos_ + 1] == 'u') {
+                    size_t start = pos_;
+                    pos_ += 2;
+                    std::uint32_t low = hex(4);
+                    if (low >= 0xdc00 && low <= 0xdfff) {
+                        return 0x10000 + ((unit - 0xd800) << 10) + (low - 0xdc00);
+                    }
+
+                    pos_ = start;
+                }
+
+                return unit;
+            }
+            case 'k':
+                fail("backreferences are not supported");
+            case 'p':
+            case 'P':
+                fail("property escapes are not supported");
+            default:
+                if ((e >= 'a' && e <= 'z') || (e >= 'A' && e <= 'Z') || is_digit(e)) {
+                    --pos_;
+                    fail(std::string("invalid escape \\") + e);
+                }
+
+                --pos_;
+                return next_code_point();
+        }
+    }
+
+    std::uint32_t hex(size_t digits) {
+        std::uint32_t value = 0;
+        for (size_t i = 0; i < digits; ++i) {
+            int digit = pos_ < source_.size() ? hex_digit(source_[pos_]) : -1;
+            if (digit < 0) {
+                fail("invalid hexadecimal escape");
+            }
+
+            value = value * 16 + static_cast<std::uint32_t>(digit);
+            ++pos_;
+        }
+
+        return value;
+    }
+
+    size_t add(op kind, size_t x = 0, size_t y = 0) {
+        if (pattern_.program_.size() >= max_program) {
+            throw std::runtime_error("pattern is too large");
+        }
+
+        pattern_.program_.push_back({kind, x, y});
+        return pattern_.program_.size() - 1;
+    }
+
+    // Emits an operand copy; an empty operand makes further copies pointless
+    bool emit_copy(const node& n) {
+        size_t before = pattern_.program_.size();
+        emit(n);
+        return pattern_.program_.size() != before;
+    }
+
+    void emit(const node& n) {
+        std::vector<instruction>& program = pattern_.program_;
+        switch (n.type) {
+            case kind::set:
+                add(op::character, n.cls);
+                break;
+            case kind::assertion:
+                add(n.assertion);
+                break;
+            case kind::sequence:
+                for (const node& child : n.children) {
+                    emit(child);
+                }
+
+                break;
+            case kind::alternation: {
+                std::vector<size_t> jumps;
+                for (size_t i = 0; i + 1 < n.children.size(); ++i) {
+                    size_t split = add(op::split);
+                    program[split].x = split + 1;
+                    emit(n.children[i]);
+                    jumps.push_back(add(op::jump));
+                    program[split].y = program.size();
+                }
+
+                emit(n.children.back());
+                for (size_t jump : jumps) {
+                    program[jump].x = program.size();
+                }
+
+                break;
+            }
+            case kind::repeat: {
+                const node& operand = n.children.front();
+                for (size_t i = 0; i < n.min; ++i) {
+                    if (!emit_copy(operand)) {
+                        return;
+                    }
+                }
+
+                if (n.max == unbounded) {
+                    size_t loop = add(op::split);
+                    program[loop].x = loop + 1;
+                    emit(operand);
+                    add(op::jump, loop);
+                    program[loop].y = program.size();
+                    break;
+                }
+
+                std::vector<size_t> exits;
+                for (size_t i = n.min; i < n.max; ++i) {
+                    size_t split = add(op::split);
+                    program[split].x = split + 1;
+                    exits.push_back(split);
+                    if (!emit_copy(operand)) {
+                        break;
+                    }
+                }
+
+                for (size_t split : exits) {
+                    program[split].y = program.size();
+                }
+
+                break;
+            }
+        }
+    }
+};
+
+schema_pattern::schema_pattern(std::string_view source) {
+    compiler(source, *this).run();
+}
+
+// Runs every thread of the program in lockstep over the code points of text,
+// starting a new one at each position, so each position is visited once
+bool schema_pattern::search(std::string_view text) const {
+    const char* data = text.data();
+    size_t size = text.size();
+    // Character instructions reached at the current position, the ones to
+    // resume after the current code point, and the epsilon closure stack
+    std::vector<size_t> waiting;
+    std::vector<size_t> resumed;
+    std::vector<size_t> stack;
+    std::vector<size_t> visited(program_.size(), 0);
+    std::uint32_t previous = 0;
+    size_t pos = 0;
+    for (size_t generation = 1;; ++generation) {
+        std::uint32_t current = 0;
+        size_t length = 0;
+        if (pos < size) {
+            length = utf8::decode(data + pos, size - pos, current);
+            if (length == 0) {
+                current = static_cast<unsigned char>(data[pos]);
+                length = 1;
+            }
+        }
+
+        bool boundary = (pos > 0 && is_word(previous)) != (pos < size && is_word(current));
+        stack.assign(resumed.rbegin(), resumed.rend());
+        stack.insert(stack.begin(), 0);
+        while (!stack.empty()) {
+            size_t pc = stack.back();
+            stack.pop_back();
+            if (visited[pc] == generation) {
+                continue;
+            }
+
+            visited[pc] = generation;
+            const instruction& in = program_[pc];
+            switch (in.kind) {
+                case op::character:
+                    waiting.push_back(pc);
+                    break;
+                case op::split:
+                    stack.push_back(in.y);
+                    stack.push_back(in.x);
+                    break;
+                case op::jump:
+                    stack.push_back(in.x);
+                    break;
+                case op::line_begin:
+                    if (pos == 0) {
+                        stack.push_back(pc + 1);
+                    }
+
+                    break;
+                case op::line_end:
+                    if (pos == size) {
+                        stack.push_back(pc + 1);
+                    }
+
+                    break;
+                case op::word_boundary:
+                case op::not_word_boundary:
+                    if (boundary == (in.kind == op::word_boundary)) {
+                        stack.push_back(pc + 1);
+                    }
+
+                    break;
+                case op::match:
+                    return true;
+            }
+        }
+
+        if (pos == size) {
+            return false;
+        }
+
+        resumed.clear();
+        for (size_t pc : waiting) {
+            if (contains(classes_[program_[pc].x], current)) {
+                resumed.push_back(pc + 1);
+            }
+        }
+
+        waiting.clear();
+        previous = current;
+        pos += length;
+    }
+}
@@ -0,0 +1,276 @@
+#include "../../include/schema/schema_validator.hpp"
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+
+schema_validator::schema_validator(const json_schema& schema, json_handler* next)
+    : schema_(schema), next_(next), buffer_depth_(0), failure_(parse_error::none) {}
+
+bool schema_validator::null_value() {
+    if (buffer_depth_ > 0) {
+        if (!buffered(builder_->null_value())) {
+            return false;
+        }
+    }
+    else if (!check_scalar({json_type::null, false, 0.0, {}})) {
+        return false;
+    }
+
+    return !next_ || next_->null_value();
+}
+
+bool schema_validator::boolean_value(bool value) {
+    if (buffer_depth_ > 0) {
+        if (!buffered(builder_->boolean_value(value))) {
+            return false;
+        }
+    }
+    else if (!check_scalar({json_type::boolean, value, 0.0, {}})) {
+        return false;
+    }
+
+    return !next_ || next_->boolean_value(value);
+}
+
+bool schema_validator::number_value(std::string& lexeme) {
+    if (buffer_depth_ > 0) {
+        std::string copy(lexeme);
+        if (!buffered(builder_->number_value(copy))) {
+            return false;
+        }
+    }
+    else {
+        errno = 0;
+        double value = std::strtod(lexeme.c_str(), nullptr);
+        if (errno == ERANGE && std::isinf(value)) {
+            failure_ = parse_error::invalid_number;
+            return false;
+        }
+
+        if (!check_scalar({json_type::number, false, value, {}})) {
+            return false;
+        }
+    }
+
+    return !next_ || next_->number_value(lexeme);
+}
+
+bool schema_validator::string_value(std::string& value) {
+    if (buffer_depth_ > 0) {
+        std::string copy(value);
+        if (!buffered(builder_->string_value(copy))) {
+            return false;
+        }
+    }
+    else if (!check_scalar({json_type::string, false, 0.0, value})) {
+        return false;
+    }
+
+    return !next_ || next_->string_value(value);
+}
+
+bool schema_validator::begin_object() {
+    return begin_container(true) && (!next_ || next_->begin_object());
+}
+
+bool schema_validator::key(std::string& key) {
+    if (buffer_depth_ > 0) {
+        std::string copy(key);
+        if (!buffered(builder_->key(copy))) {
+            return false;
+        }
+    }
+    else {
+        const frame& top = stack_.back();
+        size_t seen = top.seen_begin;
+        for (size_t i = top.active_begin; i < active_.size(); ++i) {
+            const json_schema::node& n = schema_.nodes_[active_[i]];
+            auto required = n.required_index.find(key);
+            if (required != n.required_index.end()) {
+                seen_[seen + required->second] = 1;
+            }
+
+            seen += n.required.size();
+            if (n.property_names != json_schema::none) {
+                json_schema::append_key(path_, key);
+                bool ok = schema_.check_scalar(n.property_names, {json_type::string, false, 0.0, key}, path_, &result_);
+                path_.resize(top.path_length);
+                if (!ok) {
+                    return violation();
+                }
+            }
+        }
+
+        key_ = key;
+    }
+
+    return !next_ || next_->key(key);
+}
+
+bool schema_validator::end_object() {
+    return end_container(true) && (!next_ || next_->end_object());
+}
+
+bool schema_validator::begin_array() {
+    return begin_container(false) && (!next_ || next_->begin_array());
+}
+
+bool schema_validator::end_array() {
+    return end_container(false) && (!next_ || next_->end_array());
+}
+
+void schema_validator::container_source(size_t begin, size_t end) {
+    if (next_) {
+        next_->container_source(begin, end);
+    }
+}
+
+parse_error schema_validator::failure() const {
+    if (failure_ != parse_error::none || !next_) {
+        return failure_;
+    }
+
+    return next_->failure();
+}
+
+const validation_result& schema_validator::result() const {
+    return result_;
+}
+
+bool schema_validator::check_scalar(const json_schema::scalar& value) {
+    start_value();
+    for (size_t index : applying_) {
+        if (!schema_.check_scalar(index, value, path_, &result_)) {
+            return violation();
+        }
+    }
+
+    finish_value();
+    return true;
+}
+
+bool schema_validator::begin_container(bool is_object) {
+    if (buffer_depth_ > 0) {
+        ++buffer_depth_;
+        return buffered(is_object ? builder_->begin_object() : builder_->begin_array());
+    }
+
+    start_value();
+    expanded_.clear();
+    for (size_t index : applying_) {
+        schema_.expand(index, expanded_);
+    }
+
+    bool streams = true;
+    for (size_t index : expanded_) {
+        streams = streams && schema_.nodes_[index].streams;
+    }
+
+    if (!streams) {
+        if (!builder_) {
+            builder_ = std::make_unique<tree_builder>(buffer_);
+        }
+
+        buffered_ = applying_;
+        buffer_depth_ = 1;
+        return buffered(is_object ? builder_->begin_object() : builder_->begin_array());
+    }
+
+    for (size_t index : expanded_) {
+        if (!schema_.check_open(index, is_object, path_, &result_)) {
+            return violation();
+        }
+    }
+
+    stack_.push_back({is_object, 0, active_.size(), seen_.size(), path_.size()});
+    for (size_t index : expanded_) {
+        active_.push_back(index);
+        if (is_object) {
+            seen_.resize(seen_.size() + schema_.nodes_[index].required.size(), 0);
+        }
+    }
+
+    return true;
+}
+
+bool schema_validator::end_container(bool is_object) {
+    if (buffer_depth_ > 0) {
+        if (!buffered(is_object ? builder_->end_object() : builder_->end_array())) {
+            return false;
+        }
+
+        if (--buffer_depth_ > 0) {
+            return true;
+        }
+
+        for (size_t index : buffered_) {
+            if (!schema_.check(index, buffer_, path_, &result_)) {
+                return violation();
+            }
+        }
+
+        buffer_ = json_value();
+        finish_value();
+        return true;
+    }
+
+    const frame top = stack_.back();
+    size_t seen = top.seen_begin;
+    for (size_t i = top.active_begin; i < active_.size(); ++i) {
+        const std::uint8_t* flags = top.is_object ? seen_.data() + seen : nullptr;
+        if (!schema_.check_close(active_[i], top.is_object, top.count, flags, path_, &result_)) {
+            return violation();
+        }
+
+        if (top.is_object) {
+            seen += schema_.nodes_[active_[i]].required.size();
+        }
+    }
+
+    active_.resize(top.active_begin);
+    seen_.resize(top.seen_begin);
+    stack_.pop_back();
+    finish_value();
+    return true;
+}
+
+bool schema_validator::buffered(bool accepted) {
+    if (!accepted) {
+        failure_ = builder_->failure();
+    }
+
+    return accepted;
+}
+
+// Gathers the nodes that apply to the next value and extends the path to it
+void schema_validator::start_value() {
+    applying_.clear();
+    if (stack_.empty()) {
+        applying_.push_back(schema_.root_);
+        return;
+    }
+
+    const frame& top = stack_.back();
+    if (top.is_object) {
+        json_schema::append_key(path_, key_);
+    }
+    else {
+        json_schema::append_index(path_, top.count);
+    }
+
+    for (size_t i = top.active_begin; i < active_.size(); ++i) {
+        schema_.children(active_[i], top.is_object, key_, top.count, applying_);
+    }
+}
+
+void schema_validator::finish_value() {
+    if (!stack_.empty()) {
+        ++stack_.back().count;
+        path_.resize(stack_.back().path_length);
+    }
+}
+
+bool schema_validator::violation() {
+    failure_ = parse_error::schema_violation;
+    return false;
+}
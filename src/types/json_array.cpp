@@ -4,9 +4,24 @@
 #include "../../include/types/json_number.hpp"
 #include "../../include/types/json_string.hpp"
 #include "../../include/types/json_object.hpp"
-#include <sstream>
+#include "../../include/utils/json_comparer.hpp"
+#include "../../include/utils/json_dumper.hpp"
+#include "../../include/utils/json_hasher.hpp"
+#include <mutex>
 #include <stdexcept>
 
+namespace {
+    // Serialize the one-time materialization of packed arrays read
+    // concurrently through const access, striped so unrelated arrays
+    // rarely wait for each other
+    constexpr size_t materialize_stripes = 64;
+    std::mutex materialize_mutexes[materialize_stripes];
+
+    std::mutex& materialize_mutex(const void* arr) {
+        return materialize_mutexes[(reinterpret_cast<std::uintptr_t>(arr) >> 4) % materialize_stripes];
+    }
+}
+
 // json_array_proxy implementations
 json_array::json_array_proxy::json_array_proxy(json_array& arr, size_t index)
     : arr_(arr), index_(index) {}
@@ -83,20 +98,59 @@ const json_value& json_array::json_array_proxy::as_value() const {
     return arr_.values_[index_];
 }
 
-// json_array implementations
-json_array::json_array() = default;
-
-json_array::json_array(const array& values) : values_(values) {}
-
-json_array::json_array(std::initializer_list<json_value> values) : values_(values) {}
+std::string_view json_array::json_array_proxy::get_view() const {
+    return arr_.values_[index_].as_string().get_view();
+}
 
-json_array::json_array(const json_array& other) : values_(other.values_) {}
+// json_array implementations
+json_array::json_array()
+    : packing_(packing::none), materialized_(false), hash_(0), sealed_(true), version_(0), rewritten_(0) {}
+
+json_array::json_array(const array& values)
+    : values_(values), packing_(packing::none), materialized_(false), hash_(0), sealed_(true), version_(0),
+      rewritten_(0) {}
+
+json_array::json_array(std::initializer_list<json_value> values)
+    : values_(values), packing_(packing::none), materialized_(false), hash_(0), sealed_(true), version_(0),
+      rewritten_(0) {}
+
+json_array::json_array(const json_array& other)
+    : packing_(other.packing_), numbers_(other.numbers_), booleans_(other.booleans_), materialized_(false),
+      source_(other.source_), hash_(other.sealed_ ? other.hash_.load(std::memory_order_relaxed) : 0), sealed_(true),
+      dump_(other.sealed_ ? std::atomic_load(&other.dump_) : nullptr), version_(0), rewritten_(0) {
+    if (packing_ == packing::none) {
+        values_ = other.values_;
+    }
+}
 
-json_array::json_array(json_array&& other) noexcept : values_(std::move(other.values_)) {}
+json_array::json_array(json_array&& other) noexcept
+    : values_(std::move(other.values_)), packing_(other.packing_), numbers_(std::move(other.numbers_)),
+      booleans_(std::move(other.booleans_)), materialized_(other.materialized_.load()),
+      source_(std::move(other.source_)), hash_(other.hash_.load(std::memory_order_relaxed)), sealed_(other.sealed_),
+      dump_(std::move(other.dump_)), version_(0), rewritten_(0) {
+    other.packing_ = packing::none;
+    other.materialized_ = false;
+    other.hash_.store(0, std::memory_order_relaxed);
+    other.rewrite();
+}
 
 json_array& json_array::operator=(const json_array& other) {
     if (this != &other) {
-        values_ = other.values_;
+        packing_ = other.packing_;
+        numbers_ = other.numbers_;
+        booleans_ = other.booleans_;
+        if (packing_ == packing::none) {
+            values_ = other.values_;
+        }
+        else {
+            values_.clear();
+        }
+
+        materialized_ = false;
+        source_ = other.source_;
+        hash_.store(other.sealed_ ? other.hash_.load(std::memory_order_relaxed) : 0, std::memory_order_relaxed);
+        dump_ = other.sealed_ ? std::atomic_load(&other.dump_) : nullptr;
+        rewrite();
     }
 
     return *this;
@@ -105,55 +159,51 @@ json_array& json_array::operator=(const json_array& other) {
 json_array& json_array::operator=(json_array&& other) noexcept {
     if (this != &other) {
         values_ = std::move(other.values_);
+        packing_ = other.packing_;
+        numbers_ = std::move(other.numbers_);
+        booleans_ = std::move(other.booleans_);
+        materialized_ = other.materialized_.load();
+        source_ = std::move(other.source_);
+        hash_.store(other.hash_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        sealed_ = other.sealed_;
+        dump_ = std::move(other.dump_);
+        other.packing_ = packing::none;
+        other.materialized_ = false;
+        other.hash_.store(0, std::memory_order_relaxed);
+        rewrite();
+        other.rewrite();
     }
     
     return *this;
 }
 
 std::string json_array::dump(int indent, int current_indent) const {
-    std::ostringstream oss;
-    oss << "[";
-
-    if (indent >= 0 && !values_.empty()) {
-        oss << "\n";
-    }
-
-    for (size_t i = 0; i < values_.size(); ++i) {
-        if (indent >= 0) {
-            oss << std::string(current_indent + indent, ' ');
-        }
-
-        oss << values_[i].dump(indent, current_indent + indent);
-        if (i < values_.size() - 1) {
-            oss << ",";
-        }
-
-        if (indent >= 0) {
-            oss << "\n";
-        }
-    }
-
-    if (indent >= 0 && !values_.empty()) {
-        oss << std::string(current_indent, ' ');
-    }
+    std::string out;
+    dump_to(out, indent, current_indent);
+    return out;
+}
 
-    oss << "]";
-    return oss.str();
+void json_array::dump_to(std::string& out, int indent, int current_indent, bool ascii_only, bool memoize) const {
+    json_dumper dumper(out, indent, ascii_only, memoize);
+    dumper.dump(*this, current_indent);
 }
 
 const json_array::array& json_array::get_values() const {
-    return values_;
+    return values();
 }
 
 void json_array::add_value(const json_value& value) {
+    touch(true);
     values_.push_back(value);
 }
 
 void json_array::add_value(json_value&& value) {
+    touch(true);
     values_.push_back(std::move(value));
 }
 
 json_array::json_array_proxy json_array::operator[](size_t index) {
+    touch();
     while (index >= values_.size()) {
         values_.push_back(json_value(nullptr));
     }
@@ -162,14 +212,34 @@ json_array::json_array_proxy json_array::operator[](size_t index) {
 }
 
 const json_value& json_array::operator[](size_t index) const {
-    if (index >= values_.size()) {
+    if (index >= size()) {
+        throw std::out_of_range("Index out of range: " + std::to_string(index));
+    }
+
+    return values()[index];
+}
+
+const json_value& json_array::at(size_t index) const {
+    return (*this)[index];
+}
+
+json_value json_array::element(size_t index) const {
+    if (index >= size()) {
         throw std::out_of_range("Index out of range: " + std::to_string(index));
     }
 
-    return values_[index];
+    switch (packing_) {
+        case packing::numbers:
+            return json_value(numbers_[index]);
+        case packing::booleans:
+            return json_value(booleans_[index] != 0);
+        default:
+            return values_[index];
+    }
 }
 
 void json_array::set_element(size_t index, const json_value& value) {
+    touch();
     while (index >= values_.size()) {
         values_.push_back(json_value(nullptr));
     }
@@ -177,6 +247,7 @@ void json_array::set_element(size_t index, const json_value& value) {
 }
 
 void json_array::set_element(size_t index, json_value&& value) {
+    touch();
     while (index >= values_.size()) {
         values_.push_back(json_value(nullptr));
     }
@@ -184,64 +255,233 @@ void json_array::set_element(size_t index, json_value&& value) {
     values_[index] = std::move(value);
 }
 
+json_value& json_array::insert(size_t index, json_value&& value) {
+    if (index > size()) {
+        throw std::out_of_range("Index out of range: " + std::to_string(index));
+    }
+
+    touch();
+    return *values_.insert(values_.begin() + static_cast<std::ptrdiff_t>(index), std::move(value));
+}
+
+json_value json_array::extract(size_t index) {
+    if (index >= size()) {
+        throw std::out_of_range("Index out of range: " + std::to_string(index));
+    }
+
+    touch();
+    json_value value = std::move(values_[index]);
+    values_.erase(values_.begin() + static_cast<std::ptrdiff_t>(index));
+    return value;
+}
+
 size_t json_array::size() const {
-    return values_.size();
+    switch (packing_) {
+        case packing::numbers:
+            return numbers_.size();
+        case packing::booleans:
+            return booleans_.size();
+        default:
+            return values_.size();
+    }
 }
 
 bool json_array::empty() const {
-    return values_.empty();
+    return size() == 0;
 }
 
 void json_array::clear() {
     values_.clear();
+    numbers_.clear();
+    booleans_.clear();
+    packing_ = packing::none;
+    materialized_ = false;
+    source_.reset();
+    hash_.store(0, std::memory_order_relaxed);
+    dump_.reset();
+    rewrite();
+}
+
+void json_array::resize(size_t count) {
+    touch();
+    values_.resize(count);
 }
 
 void json_array::push_back(const json_value& value) {
+    touch(true);
     values_.push_back(value);
 }
 
 void json_array::push_back(json_value&& value) {
+    touch(true);
+    values_.push_back(std::move(value));
+}
+
+json_value& json_array::emplace_back(json_value&& value) {
+    touch(true);
     values_.push_back(std::move(value));
+    return values_.back();
 }
 
 json_array::iterator json_array::begin() {
+    touch();
     return values_.begin();
 }
 
 json_array::iterator json_array::end() {
+    touch();
     return values_.end();
 }
 
 json_array::const_iterator json_array::begin() const {
-    return values_.begin();
+    return values().begin();
 }
 
 json_array::const_iterator json_array::end() const {
-    return values_.end();
+    return values().end();
 }
 
 json_array::const_iterator json_array::cbegin() const {
-    return values_.cbegin();
+    return values().cbegin();
 }
 
 json_array::const_iterator json_array::cend() const {
-    return values_.cend();
+    return values().cend();
 }
 
-bool json_array::operator==(const json_array& other) const {
-    if (values_.size() != other.values_.size()) {
-        return false;
+json_array::packing json_array::get_packing() const {
+    return packing_;
+}
+
+json_array::span<double> json_array::numbers() const {
+    if (packing_ != packing::numbers) {
+        throw std::runtime_error("Array is not packed numbers");
     }
-    
-    for (size_t i = 0; i < values_.size(); ++i) {
-        if (values_[i] != other.values_[i]) {
-            return false;
-        }
+
+    return span<double>(numbers_.data(), numbers_.size());
+}
+
+json_array::span<std::uint8_t> json_array::booleans() const {
+    if (packing_ != packing::booleans) {
+        throw std::runtime_error("Array is not packed booleans");
+    }
+
+    return span<std::uint8_t>(booleans_.data(), booleans_.size());
+}
+
+void json_array::assign_numbers(const double* data, size_t count) {
+    clear();
+    numbers_.assign(data, data + count);
+    packing_ = packing::numbers;
+}
+
+void json_array::assign_booleans(const std::uint8_t* data, size_t count) {
+    clear();
+    booleans_.assign(data, data + count);
+    packing_ = packing::booleans;
+}
+
+void json_array::unpack() {
+    if (packing_ == packing::none) {
+        return;
     }
 
-    return true;
+    materialize();
+    packing_ = packing::none;
+    materialized_ = false;
+    std::vector<double>().swap(numbers_);
+    std::vector<std::uint8_t>().swap(booleans_);
+}
+
+size_t json_array::hash() const {
+    return json_hasher().hash(*this);
+}
+
+void json_array::seal() {
+    sealed_ = true;
+    hash_.store(0, std::memory_order_relaxed);
+}
+
+std::string_view json_array::source() const {
+    return source_.view();
+}
+
+void json_array::set_source(source_text text) {
+    source_ = std::move(text);
+}
+
+std::uint64_t json_array::version() const {
+    return version_;
+}
+
+std::uint64_t json_array::last_rewrite() const {
+    return rewritten_;
+}
+
+bool json_array::operator==(const json_array& other) const {
+    return json_comparer().equal(*this, other);
 }
 
 bool json_array::operator!=(const json_array& other) const {
     return !(*this == other);
 }
+
+void json_array::touch(bool append) {
+    source_.reset();
+    hash_.store(0, std::memory_order_relaxed);
+    sealed_ = false;
+    dump_.reset();
+    unpack();
+    if (append) {
+        ++version_;
+    }
+    else {
+        rewrite();
+    }
+}
+
+void json_array::rewrite() {
+    rewritten_ = ++version_;
+}
+
+const json_array::array& json_array::values() const {
+    if (packing_ != packing::none && !materialized_.load(std::memory_order_acquire)) {
+        materialize();
+    }
+
+    return values_;
+}
+
+void json_array::materialize() const {
+    std::lock_guard<std::mutex> lock(materialize_mutex(this));
+    if (materialized_.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    array values;
+    values.reserve(size());
+    if (packing_ == packing::numbers) {
+        for (double number : numbers_) {
+            values.emplace_back(number);
+        }
+    }
+    else {
+        for (std::uint8_t boolean : booleans_) {
+            values.emplace_back(boolean != 0);
+        }
+    }
+
+    values_ = std::move(values);
+    materialized_.store(true, std::memory_order_release);
+}
+
+bool json_array::element_equals(size_t index, const json_value& value) const {
+    switch (packing_) {
+        case packing::numbers:
+            return value.is_number() && value.as_number().get_value() == numbers_[index];
+        case packing::booleans:
+            return value.is_boolean() && value.as_boolean().get_value() == (booleans_[index] != 0);
+        default:
+            return values_[index] == value;
+    }
+}
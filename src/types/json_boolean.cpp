@@ -1,4 +1,5 @@
 #include "../../include/types/json_boolean.hpp"
+#include <tuple>
 
 json_boolean::json_boolean(bool value) : value_(value) {}
 
@@ -32,6 +33,14 @@ std::string json_boolean::dump(int indent, int current_indent) const {
     return value_ ? "true" : "false";
 }
 
+void json_boolean::dump_to(std::string& out, int indent, int current_indent, bool ascii_only) const {
+    std::ignore = indent;
+    std::ignore = current_indent;
+    std::ignore = ascii_only;
+
+    out += value_ ? "true" : "false";
+}
+
 bool json_boolean::get_value() const {
     return value_;
 }
@@ -1,4 +1,5 @@
 #include "../../include/types/json_null.hpp"
+#include <tuple>
 
 std::string json_null::dump(int indent, int current_indent) const {
     std::ignore = indent;
@@ -7,6 +8,14 @@ std::string json_null::dump(int indent, int current_indent) const {
     return "null";
 }
 
+void json_null::dump_to(std::string& out, int indent, int current_indent, bool ascii_only) const {
+    std::ignore = indent;
+    std::ignore = current_indent;
+    std::ignore = ascii_only;
+
+    out += "null";
+}
+
 bool json_null::operator==(const json_null&) const {
     return true;
 }
@@ -1,18 +1,90 @@
 #include "../../include/types/json_number.hpp"
-#include <sstream>
 #include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <stdexcept>
+#include <tuple>
+
+namespace {
+    bool is_digit(char c) {
+        return c >= '0' && c <= '9';
+    }
+
+    // -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+    bool is_lexeme(const std::string& text) {
+        size_t pos = 0;
+        size_t size = text.size();
+        if (pos < size && text[pos] == '-') {
+            ++pos;
+        }
+
+        if (pos < size && text[pos] == '0') {
+            ++pos;
+        }
+        else if (pos < size && is_digit(text[pos])) {
+            while (pos < size && is_digit(text[pos])) {
+                ++pos;
+            }
+        }
+        else {
+            return false;
+        }
+
+        if (pos < size && text[pos] == '.') {
+            if (++pos == size || !is_digit(text[pos])) {
+                return false;
+            }
+
+            while (pos < size && is_digit(text[pos])) {
+                ++pos;
+            }
+        }
+
+        if (pos < size && (text[pos] == 'e' || text[pos] == 'E')) {
+            ++pos;
+            if (pos < size && (text[pos] == '+' || text[pos] == '-')) {
+                ++pos;
+            }
+
+            if (pos == size || !is_digit(text[pos])) {
+                return false;
+            }
+
+            while (pos < size && is_digit(text[pos])) {
+                ++pos;
+            }
+        }
+
+        return pos == size;
+    }
+}
 
 json_number::json_number(double value) : value_(value) {}
 
-json_number::json_number(const json_number& other) : value_(other.value_) {}
+json_number json_number::from_lexeme(std::string lexeme) {
+    if (!is_lexeme(lexeme)) {
+        throw std::runtime_error("Invalid number: " + lexeme);
+    }
+
+    json_number number(std::numeric_limits<double>::quiet_NaN());
+    number.lexeme_ = std::move(lexeme);
+    return number;
+}
+
+json_number::json_number(const json_number& other)
+    : lexeme_(other.lexeme_), value_(other.value_.load(std::memory_order_relaxed)) {}
 
-json_number::json_number(json_number&& other) noexcept : value_(other.value_) {
-    other.value_ = 0.0;
+json_number::json_number(json_number&& other) noexcept
+    : lexeme_(std::move(other.lexeme_)), value_(other.value_.load(std::memory_order_relaxed)) {
+    other.lexeme_.clear();
+    other.value_.store(0.0, std::memory_order_relaxed);
 }
 
 json_number& json_number::operator=(const json_number& other) {
     if (this != &other) {
-        value_ = other.value_;
+        lexeme_ = other.lexeme_;
+        value_.store(other.value_.load(std::memory_order_relaxed), std::memory_order_relaxed);
     }
 
     return *this;
@@ -20,33 +92,65 @@ json_number& json_number::operator=(const json_number& other) {
 
 json_number& json_number::operator=(json_number&& other) noexcept {
     if (this != &other) {
-        value_ = other.value_;
-        other.value_ = 0.0;
+        lexeme_ = std::move(other.lexeme_);
+        value_.store(other.value_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        other.lexeme_.clear();
+        other.value_.store(0.0, std::memory_order_relaxed);
     }
     
     return *this;
 }
 
 std::string json_number::dump(int indent, int current_indent) const {
+    std::string out;
+    dump_to(out, indent, current_indent);
+    return out;
+}
+
+void json_number::dump_to(std::string& out, int indent, int current_indent, bool ascii_only) const {
     std::ignore = indent;
     std::ignore = current_indent;
-    std::ostringstream oss;
-    if (std::floor(value_) == value_ && std::abs(value_) < 1e15) {
-        oss << static_cast<long long>(value_);
+    std::ignore = ascii_only;
+    if (!lexeme_.empty()) {
+        out += lexeme_;
+        return;
+    }
+
+    write(out, value_.load(std::memory_order_relaxed));
+}
+
+void json_number::write(std::string& out, double value) {
+    char buffer[32];
+    int length;
+    if (std::floor(value) == value && std::abs(value) < 1e15) {
+        length = std::snprintf(buffer, sizeof(buffer), "%lld", static_cast<long long>(value));
     } 
     else {
-        oss << value_;
+        // Same output as streaming the double with default precision
+        length = std::snprintf(buffer, sizeof(buffer), "%g", value);
     }
-    
-    return oss.str();
+
+    out.append(buffer, static_cast<size_t>(length));
 }
 
+// Every reader converts the same text to the same value, so a race to
+// fill the cache only repeats work
 double json_number::get_value() const {
-    return value_;
+    double value = value_.load(std::memory_order_relaxed);
+    if (std::isnan(value) && !lexeme_.empty()) {
+        value = std::strtod(lexeme_.c_str(), nullptr);
+        value_.store(value, std::memory_order_relaxed);
+    }
+
+    return value;
+}
+
+const std::string& json_number::get_lexeme() const {
+    return lexeme_;
 }
 
 bool json_number::operator==(const json_number& other) const {
-    return value_ == other.value_;
+    return get_value() == other.get_value();
 }
 
 bool json_number::operator!=(const json_number& other) const {
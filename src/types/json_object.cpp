@@ -4,64 +4,69 @@
 #include "../../include/types/json_number.hpp"
 #include "../../include/types/json_string.hpp"
 #include "../../include/types/json_array.hpp"
-#include <sstream>
+#include "../../include/utils/json_comparer.hpp"
+#include "../../include/utils/json_dumper.hpp"
+#include "../../include/utils/json_hasher.hpp"
+#include <mutex>
 #include <stdexcept>
+#include <tuple>
+
+namespace {
+    // Serializes the one-time materialization of shaped objects read
+    // through get_values()
+    std::mutex materialize_mutex;
+}
 
 // json_object_proxy implementations
-json_object::json_object_proxy::json_object_proxy(json_object& obj, const std::string& key)
+json_object::json_object_proxy::json_object_proxy(json_object& obj, std::string_view key)
     : obj_(obj), key_(key) {}
 
 json_object::json_object_proxy& json_object::json_object_proxy::operator=(const std::string& value) {
-    obj_.values_[key_] = json_value(value);
+    resolve() = json_value(value);
     return *this;
 }
 
 json_object::json_object_proxy& json_object::json_object_proxy::operator=(const char* value) {
-    obj_.values_[key_] = json_value(value);
+    resolve() = json_value(value);
     return *this;
 }
 
 json_object::json_object_proxy& json_object::json_object_proxy::operator=(double value) {
-    obj_.values_[key_] = json_value(value);
+    resolve() = json_value(value);
     return *this;
 }
 
 json_object::json_object_proxy& json_object::json_object_proxy::operator=(int value) {
-    obj_.values_[key_] = json_value(value);
+    resolve() = json_value(value);
     return *this;
 }
 
 json_object::json_object_proxy& json_object::json_object_proxy::operator=(bool value) {
-    obj_.values_[key_] = json_value(value);
+    resolve() = json_value(value);
     return *this;
 }
 
 json_object::json_object_proxy& json_object::json_object_proxy::operator=(std::nullptr_t) {
-    obj_.values_[key_] = json_value(nullptr);
+    resolve() = json_value(nullptr);
     return *this;
 }
 
 json_object::json_object_proxy& json_object::json_object_proxy::operator=(const json_value& value) {
-    obj_.values_[key_] = value;
+    resolve() = value;
     return *this;
 }
 
 json_object::json_object_proxy& json_object::json_object_proxy::operator=(json_value&& value) {
-    obj_.values_[key_] = std::move(value);
+    resolve() = std::move(value);
     return *this;
 }
 
 json_object::json_object_proxy::operator json_value&() {
-    return obj_.values_[key_];
+    return resolve();
 }
 
 json_object::json_object_proxy::operator const json_value&() const {
-    auto it = obj_.values_.find(key_);
-    if (it == obj_.values_.end()) {
-        throw std::out_of_range("Key not found: " + key_);
-    }
-    
-    return it->second;
+    return obj_.at(key_);
 }
 
 json_object::json_object_proxy::operator std::string() const {
@@ -81,20 +86,19 @@ json_object::json_object_proxy::operator bool() const {
 }
 
 json_value& json_object::json_object_proxy::as_value() {
-    return obj_.values_[key_];
+    return resolve();
 }
 
 const json_value& json_object::json_object_proxy::as_value() const {
-    auto it = obj_.values_.find(key_);
-    if (it == obj_.values_.end()) {
-        throw std::out_of_range("Key not found: " + key_);
-    }
-    
-    return it->second;
+    return obj_.at(key_);
 }
 
-json_object::json_object_proxy json_object::json_object_proxy::operator[](const std::string& key) {
-    json_value& val = obj_.values_[key_];
+std::string_view json_object::json_object_proxy::get_view() const {
+    return as_value().as_string().get_view();
+}
+
+json_object::json_object_proxy json_object::json_object_proxy::operator[](std::string_view key) {
+    json_value& val = resolve();
     if (!val.is_object()) {
         val = json_value::make_object();
     }
@@ -104,7 +108,7 @@ json_object::json_object_proxy json_object::json_object_proxy::operator[](const
 
 json_object::json_object_proxy json_object::json_object_proxy::operator[](size_t index) {
     std::ignore = index;
-    json_value& val = obj_.values_[key_];
+    json_value& val = resolve();
     if (!val.is_array()) {
         val = json_value::make_array();
     }
@@ -112,24 +116,52 @@ json_object::json_object_proxy json_object::json_object_proxy::operator[](size_t
     return json_object_proxy(obj_, key_);
 }
 
+json_value& json_object::json_object_proxy::resolve() {
+    return obj_.resolve(key_);
+}
+
+// member_key implementations
+json_object::member_key::member_key(std::string name) : name_(std::move(name)), slot_(object_shape::npos) {}
+
+const std::string& json_object::member_key::name() const {
+    return name_;
+}
+
 // json_object implementations
-json_object::json_object() = default;
+json_object::json_object() : materialized_(false), hash_(0), sealed_(true) {}
 
-json_object::json_object(const object& values) : values_(values) {}
+json_object::json_object(const object& values) : values_(values), materialized_(false), hash_(0), sealed_(true) {}
 
-json_object::json_object(std::initializer_list<std::pair<std::string, json_value>> values) {
+json_object::json_object(std::initializer_list<std::pair<std::string, json_value>> values)
+    : materialized_(false), hash_(0), sealed_(true) {
     for (const auto& [key, val] : values) {
         values_[key] = val;
     }
 }
 
-json_object::json_object(const json_object& other) : values_(other.values_) {}
+json_object::json_object(const json_object& other)
+    : values_(other.shape_ ? object() : other.values_), shape_(other.shape_), slots_(other.slots_),
+      materialized_(false), source_(other.source_),
+      hash_(other.sealed_ ? other.hash_.load(std::memory_order_relaxed) : 0), sealed_(true),
+      dump_(other.sealed_ ? std::atomic_load(&other.dump_) : nullptr) {}
 
-json_object::json_object(json_object&& other) noexcept : values_(std::move(other.values_)) {}
+json_object::json_object(json_object&& other) noexcept
+    : values_(std::move(other.values_)), shape_(std::move(other.shape_)), slots_(std::move(other.slots_)),
+      materialized_(other.materialized_.load()), source_(std::move(other.source_)),
+      hash_(other.hash_.load(std::memory_order_relaxed)), sealed_(other.sealed_), dump_(std::move(other.dump_)) {
+    other.materialized_ = false;
+    other.hash_.store(0, std::memory_order_relaxed);
+}
 
 json_object& json_object::operator=(const json_object& other) {
     if (this != &other) {
-        values_ = other.values_;
+        values_ = other.shape_ ? object() : other.values_;
+        shape_ = other.shape_;
+        slots_ = other.slots_;
+        materialized_ = false;
+        source_ = other.source_;
+        hash_.store(other.sealed_ ? other.hash_.load(std::memory_order_relaxed) : 0, std::memory_order_relaxed);
+        dump_ = other.sealed_ ? std::atomic_load(&other.dump_) : nullptr;
     }
     
     return *this;
@@ -138,143 +170,302 @@ json_object& json_object::operator=(const json_object& other) {
 json_object& json_object::operator=(json_object&& other) noexcept {
     if (this != &other) {
         values_ = std::move(other.values_);
+        shape_ = std::move(other.shape_);
+        slots_ = std::move(other.slots_);
+        materialized_ = other.materialized_.load();
+        source_ = std::move(other.source_);
+        hash_.store(other.hash_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        sealed_ = other.sealed_;
+        dump_ = std::move(other.dump_);
+        other.materialized_ = false;
+        other.hash_.store(0, std::memory_order_relaxed);
     }
     
     return *this;
 }
 
 std::string json_object::dump(int indent, int current_indent) const {
-    std::ostringstream oss;
-    oss << "{";
-    if (indent >= 0 && !values_.empty()) {
-        oss << "\n";
+    std::string out;
+    dump_to(out, indent, current_indent);
+    return out;
+}
+
+void json_object::dump_to(std::string& out, int indent, int current_indent, bool ascii_only, bool memoize) const {
+    json_dumper dumper(out, indent, ascii_only, memoize);
+    dumper.dump(*this, current_indent);
+}
+
+const json_object::object& json_object::get_values() const {
+    if (shape_ && !materialized_.load(std::memory_order_acquire)) {
+        materialize();
     }
 
-    size_t i = 0;
-    for (const auto& [key, value] : values_) {
-        if (indent >= 0) {
-            oss << std::string(current_indent + indent, ' ');
-        }
+    return values_;
+}
 
-        oss << "\"" << key << "\":";
-        if (indent >= 0) {
-            oss << " ";
-        }
+void json_object::set_value(const std::string& key, const json_value& value) {
+    resolve(key) = value;
+}
 
-        oss << value.dump(indent, current_indent + indent);
-        if (i++ < values_.size() - 1) {
-            oss << ",";
-        }
+void json_object::set_value(const std::string& key, json_value&& value) {
+    resolve(key) = std::move(value);
+}
 
-        if (indent >= 0) {
-            oss << "\n";
-        }
+json_value& json_object::insert_or_assign(std::string&& key, json_value&& value) {
+    touch();
+    size_t index = slot(key);
+    if (index != object_shape::npos) {
+        return slots_[index] = std::move(value);
     }
 
-    if (indent >= 0 && !values_.empty()) {
-        oss << std::string(current_indent, ' ');
+    unshape();
+    return values_.insert_or_assign(std::move(key), std::move(value)).first->second;
+}
+
+bool json_object::has_key(std::string_view key) const {
+    return find(key) != nullptr;
+}
+
+void json_object::remove_key(std::string_view key) {
+    touch();
+    if (shape_) {
+        if (slot(key) == object_shape::npos) {
+            return;
+        }
+
+        unshape();
     }
 
-    oss << "}";
-    return oss.str();
+    auto it = lookup(key);
+    if (it != values_.end()) {
+        values_.erase(it);
+    }
 }
 
-const json_object::object& json_object::get_values() const {
-    return values_;
+json_object::json_object_proxy json_object::operator[](std::string_view key) {
+    touch();
+    return json_object_proxy(*this, key);
 }
 
-void json_object::set_value(const std::string& key, const json_value& value) {
-    values_[key] = value;
+const json_value& json_object::operator[](std::string_view key) const {
+    const json_value* value = find(key);
+    if (!value) {
+        throw std::out_of_range("Key not found: " + std::string(key));
+    }
+
+    return *value;
 }
 
-void json_object::set_value(const std::string& key, json_value&& value) {
-    values_[key] = std::move(value);
+const json_value& json_object::at(std::string_view key) const {
+    return (*this)[key];
 }
 
-bool json_object::has_key(const std::string& key) const {
-    return values_.find(key) != values_.end();
+const json_value* json_object::find(std::string_view key) const {
+    if (shape_) {
+        size_t index = shape_->find(key);
+        return index != object_shape::npos ? &slots_[index] : nullptr;
+    }
+
+    auto it = lookup(key);
+    return it != values_.end() ? &it->second : nullptr;
 }
 
-void json_object::remove_key(const std::string& key) {
-    values_.erase(key);
+json_value* json_object::find(std::string_view key) {
+    touch();
+    return const_cast<json_value*>(static_cast<const json_object&>(*this).find(key));
 }
 
-json_object::json_object_proxy json_object::operator[](const std::string& key) {
-    return json_object_proxy(*this, key);
+const json_value* json_object::find(const member_key& key) const {
+    if (!shape_) {
+        return find(key.name_);
+    }
+
+    if (key.shape_ != shape_) {
+        key.shape_ = shape_;
+        key.slot_ = shape_->find(key.name_);
+    }
+
+    return key.slot_ != object_shape::npos ? &slots_[key.slot_] : nullptr;
 }
 
-const json_value& json_object::operator[](const std::string& key) const {
-    auto it = values_.find(key);
-    if (it == values_.end()) {
-        throw std::out_of_range("Key not found: " + key);
+json_value json_object::extract(std::string_view key) {
+    touch();
+    if (!has_key(key)) {
+        throw std::out_of_range("Key not found: " + std::string(key));
     }
 
-    return it->second;
+    unshape();
+    auto it = lookup(key);
+    json_value value = std::move(it->second);
+    values_.erase(it);
+    return value;
 }
 
 size_t json_object::size() const {
-    return values_.size();
+    return shape_ ? slots_.size() : values_.size();
 }
 
 bool json_object::empty() const {
-    return values_.empty();
+    return size() == 0;
 }
 
 void json_object::clear() {
+    touch();
+    shape_.reset();
+    slots_.clear();
     values_.clear();
 }
 
-bool json_object::contains(const std::string& key) const {
+bool json_object::contains(std::string_view key) const {
     return has_key(key);
 }
 
-void json_object::erase(const std::string& key) {
+void json_object::erase(std::string_view key) {
     remove_key(key);
 }
 
 json_object::iterator json_object::begin() {
-    return values_.begin();
+    touch();
+    return shape_ ? iterator(shape_->keys().data(), slots_.data()) : iterator(values_.begin());
 }
 
 json_object::iterator json_object::end() {
-    return values_.end();
+    touch();
+    return shape_ ? iterator(shape_->keys().data() + slots_.size(), slots_.data() + slots_.size())
+                  : iterator(values_.end());
 }
 
 json_object::const_iterator json_object::begin() const {
-    return values_.begin();
+    return shape_ ? const_iterator(shape_->keys().data(), slots_.data()) : const_iterator(values_.cbegin());
 }
 
 json_object::const_iterator json_object::end() const {
-    return values_.end();
+    return shape_ ? const_iterator(shape_->keys().data() + slots_.size(), slots_.data() + slots_.size())
+                  : const_iterator(values_.cend());
 }
 
 json_object::const_iterator json_object::cbegin() const {
-    return values_.cbegin();
+    return begin();
 }
 
 json_object::const_iterator json_object::cend() const {
-    return values_.cend();
+    return end();
+}
+
+size_t json_object::hash() const {
+    return json_hasher().hash(*this);
+}
+
+void json_object::seal() {
+    sealed_ = true;
+    hash_.store(0, std::memory_order_relaxed);
+}
+
+std::string_view json_object::source() const {
+    return source_.view();
+}
+
+void json_object::set_source(source_text text) {
+    source_ = std::move(text);
 }
 
 bool json_object::operator==(const json_object& other) const {
-    if (values_.size() != other.values_.size()) {
-        return false;
+    return json_comparer().equal(*this, other);
+}
+
+bool json_object::operator!=(const json_object& other) const {
+    return !(*this == other);
+}
+
+const object_shape* json_object::shape() const {
+    return shape_.get();
+}
+
+void json_object::touch() {
+    source_.reset();
+    hash_.store(0, std::memory_order_relaxed);
+    sealed_ = false;
+    dump_.reset();
+    if (materialized_.load(std::memory_order_relaxed)) {
+        values_.clear();
+        materialized_.store(false, std::memory_order_relaxed);
     }
+}
 
-    for (const auto& [key, val] : values_) {
-        auto it = other.values_.find(key);
-        if (it == other.values_.end()) {
-            return false;
-        }
+void json_object::unshape() {
+    if (!shape_) {
+        return;
+    }
 
-        if (val != it->second) {
-            return false;
-        }
+    object values;
+    values.reserve(slots_.size());
+    for (size_t i = 0; i < slots_.size(); ++i) {
+        values.emplace(shape_->key(i), std::move(slots_[i]));
     }
 
-    return true;
+    values_ = std::move(values);
+    shape_.reset();
+    slots_.clear();
+    slots_.shrink_to_fit();
 }
 
-bool json_object::operator!=(const json_object& other) const {
-    return !(*this == other);
+void json_object::materialize() const {
+    std::lock_guard<std::mutex> lock(materialize_mutex);
+    if (materialized_.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    object values;
+    values.reserve(slots_.size());
+    for (size_t i = 0; i < slots_.size(); ++i) {
+        values.emplace(shape_->key(i), slots_[i]);
+    }
+
+    values_ = std::move(values);
+    materialized_.store(true, std::memory_order_release);
+}
+
+// Position of key in a shaped object, or npos
+size_t json_object::slot(std::string_view key) const {
+    return shape_ ? shape_->find(key) : object_shape::npos;
+}
+
+// Without C++20 heterogeneous lookup the key is copied into a per-thread
+// buffer whose capacity is reused, so steady-state lookups do not allocate
+json_object::object::iterator json_object::lookup(std::string_view key) {
+#if defined(__cpp_lib_generic_unordered_lookup)
+    return values_.find(key);
+#else
+    thread_local std::string scratch;
+    scratch.assign(key.data(), key.size());
+    return values_.find(scratch);
+#endif
+}
+
+json_object::object::const_iterator json_object::lookup(std::string_view key) const {
+#if defined(__cpp_lib_generic_unordered_lookup)
+    return values_.find(key);
+#else
+    thread_local std::string scratch;
+    scratch.assign(key.data(), key.size());
+    return values_.find(scratch);
+#endif
+}
+
+// Looks the key up before inserting so that reading an existing key never
+// calls the map's mutating operator[], and only a miss copies the key
+json_value& json_object::resolve(std::string_view key) {
+    touch();
+    size_t index = slot(key);
+    if (index != object_shape::npos) {
+        return slots_[index];
+    }
+
+    unshape();
+    auto it = lookup(key);
+    if (it != values_.end()) {
+        return it->second;
+    }
+
+    return values_.emplace(std::string(key), json_value()).first->second;
 }
@@ -1,5 +1,6 @@
 #include "../../include/types/json_string.hpp"
-#include <sstream>
+#include "../../include/utils/string_writer.hpp"
+#include <tuple>
 
 json_string::json_string(const std::string& value) : value_(value) {}
 
@@ -28,31 +29,35 @@ json_string& json_string::operator=(json_string&& other) noexcept {
 }
 
 std::string json_string::dump(int indent, int current_indent) const {
+    std::string out;
+    dump_to(out, indent, current_indent);
+    return out;
+}
+
+void json_string::dump_to(std::string& out, int indent, int current_indent, bool ascii_only) const {
     std::ignore = indent;
     std::ignore = current_indent;
-    std::ostringstream oss;
-    oss << "\"";
-    for (char c : value_) {
-        switch (c) {
-            case '"': oss << "\\\""; break;
-            case '\\': oss << "\\\\"; break;
-            case '\b': oss << "\\b"; break;
-            case '\f': oss << "\\f"; break;
-            case '\n': oss << "\\n"; break;
-            case '\r': oss << "\\r"; break;
-            case '\t': oss << "\\t"; break;
-            default: oss << c; break;
-        }
-    }
-    
-    oss << "\"";
-    return oss.str();
+    string_writer::write(out, value_, ascii_only);
 }
 
-std::string json_string::get_value() const {
+const std::string& json_string::get_value() const {
     return value_;
 }
 
+std::string_view json_string::get_view() const {
+    return value_;
+}
+
+void json_string::set_value(const std::string& value) {
+    value_ = value;
+}
+
+std::string json_string::take_value() {
+    std::string value = std::move(value_);
+    value_.clear();
+    return value;
+}
+
 bool json_string::operator==(const json_string& other) const {
     return value_ == other.value_;
 }
@@ -5,7 +5,46 @@
 #include "../../include/types/json_string.hpp"
 #include "../../include/types/json_array.hpp"
 #include "../../include/types/json_object.hpp"
+#include "../../include/utils/structural_hash.hpp"
+#include <atomic>
+#include <cstdint>
+#include <new>
 #include <variant>
+#include <vector>
+
+namespace {
+    // Every json_value owns a heap node, and moving one allocates a fresh
+    // node for the source, so nodes are recycled through a bounded
+    // per-thread free list instead of going back to the global allocator
+    constexpr size_t node_cache_limit = 4096;
+
+    struct free_node {
+        free_node* next;
+    };
+
+    struct node_cache {
+        free_node* head = nullptr;
+        size_t count = 0;
+
+        ~node_cache();
+    };
+
+    // Trivially destructible, so it stays readable while other thread-local
+    // destructors release json_values after the cache itself is gone
+    thread_local bool node_cache_closed = false;
+    thread_local node_cache cached_nodes;
+
+    node_cache::~node_cache() {
+        while (head) {
+            free_node* next = head->next;
+            ::operator delete(head);
+            head = next;
+        }
+
+        count = 0;
+        node_cache_closed = true;
+    }
+}
 
 struct json_value::impl {
     using variant_t = std::variant<
@@ -19,11 +58,44 @@ struct json_value::impl {
     >;
 
     variant_t data;
+    // Set by json_interner; a shared node is never modified, non-const
+    // access copies it first unless this value is its only owner
+    mutable std::atomic<std::uint32_t> owners{1};
+    bool shared = false;
+
+    static void* operator new(std::size_t size) {
+        if (!node_cache_closed && cached_nodes.head) {
+            node_cache& cache = cached_nodes;
+            free_node* node = cache.head;
+            cache.head = node->next;
+            --cache.count;
+            return node;
+        }
+
+        return ::operator new(size);
+    }
+
+    static void operator delete(void* ptr) noexcept {
+        if (!ptr) {
+            return;
+        }
+
+        if (node_cache_closed || cached_nodes.count >= node_cache_limit) {
+            ::operator delete(ptr);
+            return;
+        }
+
+        node_cache& cache = cached_nodes;
+        free_node* node = static_cast<free_node*>(ptr);
+        node->next = cache.head;
+        cache.head = node;
+        ++cache.count;
+    }
 
     impl() : data(json_null{}) {}
     impl(json_null v) : data(v) {}
     impl(json_boolean v) : data(v) {}
-    impl(json_number v) : data(v) {}
+    impl(json_number v) : data(std::move(v)) {}
     impl(json_string v) : data(std::move(v)) {}
     impl(std::unique_ptr<json_array> v) : data(std::move(v)) {}
     impl(std::unique_ptr<json_object> v) : data(std::move(v)) {}
@@ -50,6 +122,73 @@ struct json_value::impl {
         other.data = json_null{};
     }
 
+    // Nested containers are released from a worklist rather than by
+    // recursing once per level, so arbitrarily deep trees can be destroyed
+    // without exhausting the call stack
+    ~impl() {
+        std::vector<impl_ptr> pending;
+        try {
+            detach_nested(pending);
+            while (!pending.empty()) {
+                impl_ptr node = std::move(pending.back());
+                pending.pop_back();
+                node->detach_nested(pending);
+            }
+        } catch (const std::bad_alloc&) {
+            // Anything not yet detached is released recursively
+        }
+    }
+
+    bool is_nonempty_container() const {
+        if (auto* arr = std::get_if<std::unique_ptr<json_array>>(&data)) {
+            return !(*arr)->empty();
+        }
+
+        if (auto* obj = std::get_if<std::unique_ptr<json_object>>(&data)) {
+            return !(*obj)->empty();
+        }
+
+        return false;
+    }
+
+    // A shared child only loses an owner, unless this was its last one
+    void detach_nested(std::vector<impl_ptr>& pending) {
+        auto detach = [&pending](json_value& child) {
+            if (!child.pimpl_) {
+                return;
+            }
+
+            if (child.pimpl_->shared) {
+                if (child.pimpl_->owners.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+                    child.pimpl_.release();
+                    return;
+                }
+
+                child.pimpl_->shared = false;
+            }
+
+            if (child.pimpl_->is_nonempty_container()) {
+                pending.push_back(std::move(child.pimpl_));
+            }
+        };
+
+        if (auto* arr = std::get_if<std::unique_ptr<json_array>>(&data)) {
+            // Packed arrays hold only scalars
+            if ((*arr)->get_packing() != json_array::packing::none) {
+                return;
+            }
+
+            for (json_value& child : **arr) {
+                detach(child);
+            }
+        }
+        else if (auto* obj = std::get_if<std::unique_ptr<json_object>>(&data)) {
+            for (auto entry : **obj) {
+                detach(entry.second);
+            }
+        }
+    }
+
     impl& operator=(const impl& other) {
         if (this != &other) {
             std::visit([this](const auto& val) {
@@ -82,32 +221,85 @@ struct json_value::impl {
     }
 };
 
-json_value::json_value() : pimpl_(std::make_unique<impl>()) {}
+void json_value::impl_release::operator()(impl* node) const noexcept {
+    if (node->shared && node->owners.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+        return;
+    }
 
-json_value::json_value(std::nullptr_t) : pimpl_(std::make_unique<impl>(json_null{})) {}
+    delete node;
+}
 
-json_value::json_value(bool value) : pimpl_(std::make_unique<impl>(json_boolean(value))) {}
+template <typename... Args>
+json_value::impl_ptr json_value::make_impl(Args&&... args) {
+    return impl_ptr(new impl(std::forward<Args>(args)...));
+}
 
-json_value::json_value(int value) : pimpl_(std::make_unique<impl>(json_number(static_cast<double>(value)))) {}
+json_value::impl_ptr json_value::copy_impl(const impl& node) {
+    if (node.shared) {
+        node.owners.fetch_add(1, std::memory_order_relaxed);
+        return impl_ptr(const_cast<impl*>(&node));
+    }
 
-json_value::json_value(double value) : pimpl_(std::make_unique<impl>(json_number(value))) {}
+    return make_impl(node);
+}
 
-json_value::json_value(const char* value) : pimpl_(std::make_unique<impl>(json_string(value))) {}
+// Copies one level: the copy's children are copied through copy_impl, so
+// below an interned node they stay shared
+void json_value::unshare() {
+    if (!pimpl_->shared) {
+        return;
+    }
 
-json_value::json_value(const std::string& value) : pimpl_(std::make_unique<impl>(json_string(value))) {}
+    if (pimpl_->owners.load(std::memory_order_acquire) == 1) {
+        pimpl_->shared = false;
+        return;
+    }
 
-json_value::json_value(std::string&& value) : pimpl_(std::make_unique<impl>(json_string(std::move(value)))) {}
+    pimpl_ = make_impl(*pimpl_);
+}
+
+bool json_value::is_shared() const {
+    return pimpl_->shared;
+}
+
+bool json_value::same_node(const json_value& other) const {
+    return pimpl_ == other.pimpl_;
+}
+
+void json_value::mark_shared() {
+    pimpl_->shared = true;
+}
+
+void json_value::share(const json_value& pooled) {
+    pimpl_ = copy_impl(*pooled.pimpl_);
+}
+
+json_value::json_value() : pimpl_(make_impl()) {}
+
+json_value::json_value(std::nullptr_t) : pimpl_(make_impl(json_null{})) {}
+
+json_value::json_value(bool value) : pimpl_(make_impl(json_boolean(value))) {}
+
+json_value::json_value(int value) : pimpl_(make_impl(json_number(static_cast<double>(value)))) {}
+
+json_value::json_value(double value) : pimpl_(make_impl(json_number(value))) {}
+
+json_value::json_value(const char* value) : pimpl_(make_impl(json_string(value))) {}
+
+json_value::json_value(const std::string& value) : pimpl_(make_impl(json_string(value))) {}
+
+json_value::json_value(std::string&& value) : pimpl_(make_impl(json_string(std::move(value)))) {}
 
 json_value::json_value(const json_value& other)
-    : pimpl_(other.pimpl_ ? std::make_unique<impl>(*other.pimpl_) : std::make_unique<impl>()) {}
+    : pimpl_(other.pimpl_ ? copy_impl(*other.pimpl_) : make_impl()) {}
 
 json_value::json_value(json_value&& other) noexcept : pimpl_(std::move(other.pimpl_)) {
-    other.pimpl_ = std::make_unique<impl>();
+    other.pimpl_ = make_impl();
 }
 
 json_value& json_value::operator=(const json_value& other) {
     if (this != &other) {
-        pimpl_ = other.pimpl_ ? std::make_unique<impl>(*other.pimpl_) : std::make_unique<impl>();
+        pimpl_ = other.pimpl_ ? copy_impl(*other.pimpl_) : make_impl();
     }
 
     return *this;
@@ -116,7 +308,7 @@ json_value& json_value::operator=(const json_value& other) {
 json_value& json_value::operator=(json_value&& other) noexcept {
     if (this != &other) {
         pimpl_ = std::move(other.pimpl_);
-        other.pimpl_ = std::make_unique<impl>();
+        other.pimpl_ = make_impl();
     }
     
     return *this;
@@ -149,19 +341,25 @@ json_type json_value::type() const {
 }
 
 std::string json_value::dump(int indent, int current_indent) const {
-    return std::visit([indent, current_indent](const auto& val) -> std::string {
+    std::string out;
+    dump_to(out, indent, current_indent);
+    return out;
+}
+
+void json_value::dump_to(std::string& out, int indent, int current_indent, bool ascii_only, bool memoize) const {
+    std::visit([&out, indent, current_indent, ascii_only, memoize](const auto& val) {
         using T = std::decay_t<decltype(val)>;
         if constexpr (std::is_same_v<T, std::monostate>) {
-            return json_null{}.dump(indent, current_indent);
+            json_null{}.dump_to(out, indent, current_indent, ascii_only);
         } 
         else if constexpr (std::is_same_v<T, std::unique_ptr<json_array>>) {
-            return val->dump(indent, current_indent);
+            val->dump_to(out, indent, current_indent, ascii_only, memoize);
         } 
         else if constexpr (std::is_same_v<T, std::unique_ptr<json_object>>) {
-            return val->dump(indent, current_indent);
+            val->dump_to(out, indent, current_indent, ascii_only, memoize);
         } 
         else {
-            return val.dump(indent, current_indent);
+            val.dump_to(out, indent, current_indent, ascii_only);
         }
     }, pimpl_->data);
 }
@@ -170,8 +368,16 @@ json_value json_value::clone() const {
     return json_value(*this);
 }
 
+// Values sharing a node are equal without looking inside, and a type
+// mismatch is found by comparing variant indices rather than visiting
 bool json_value::operator==(const json_value& other) const {
-    if (type() != other.type()) return false;
+    if (pimpl_ == other.pimpl_) {
+        return true;
+    }
+
+    if (pimpl_->data.index() != other.pimpl_->data.index()) {
+        return is_null() && other.is_null();
+    }
 
     return std::visit([&other](const auto& val) -> bool {
         using T = std::decay_t<decltype(val)>;
@@ -201,6 +407,27 @@ bool json_value::operator!=(const json_value& other) const {
     return !(*this == other);
 }
 
+size_t json_value::hash() const {
+    return std::visit([](const auto& val) -> size_t {
+        using T = std::decay_t<decltype(val)>;
+        if constexpr (std::is_same_v<T, std::monostate> || std::is_same_v<T, json_null>) {
+            return structural_hash::of_null();
+        }
+        else if constexpr (std::is_same_v<T, json_boolean>) {
+            return structural_hash::of_boolean(val.get_value());
+        }
+        else if constexpr (std::is_same_v<T, json_number>) {
+            return structural_hash::of_number(val.get_value());
+        }
+        else if constexpr (std::is_same_v<T, json_string>) {
+            return structural_hash::of_string(val.get_view());
+        }
+        else {
+            return val->hash();
+        }
+    }, pimpl_->data);
+}
+
 bool json_value::is_null() const { return type() == json_type::null; }
 bool json_value::is_boolean() const { return type() == json_type::boolean; }
 bool json_value::is_number() const { return type() == json_type::number; }
@@ -209,6 +436,7 @@ bool json_value::is_array() const { return type() == json_type::array; }
 bool json_value::is_object() const { return type() == json_type::object; }
 
 json_null& json_value::as_null() {
+    unshare();
     if (auto* p = std::get_if<json_null>(&pimpl_->data)) {
         return *p;
     }
@@ -225,6 +453,7 @@ const json_null& json_value::as_null() const {
 }
 
 json_boolean& json_value::as_boolean() {
+    unshare();
     if (auto* p = std::get_if<json_boolean>(&pimpl_->data)) {
         return *p;
     }
@@ -241,6 +470,7 @@ const json_boolean& json_value::as_boolean() const {
 }
 
 json_number& json_value::as_number() {
+    unshare();
     if (auto* p = std::get_if<json_number>(&pimpl_->data)) {
         return *p;
     }
@@ -257,6 +487,7 @@ const json_number& json_value::as_number() const {
 }
 
 json_string& json_value::as_string() {
+    unshare();
     if (auto* p = std::get_if<json_string>(&pimpl_->data)) {
         return *p;
     }
@@ -273,6 +504,7 @@ const json_string& json_value::as_string() const {
 }
 
 json_array& json_value::as_array() {
+    unshare();
     if (auto* p = std::get_if<std::unique_ptr<json_array>>(&pimpl_->data)) {
         return **p;
     }
@@ -289,6 +521,7 @@ const json_array& json_value::as_array() const {
 }
 
 json_object& json_value::as_object() {
+    unshare();
     if (auto* p = std::get_if<std::unique_ptr<json_object>>(&pimpl_->data)) {
         return **p;
     }
@@ -304,6 +537,28 @@ const json_object& json_value::as_object() const {
     throw std::runtime_error("Value is not object");
 }
 
+json_value json_value::take() {
+    return json_value(std::move(*this));
+}
+
+std::string json_value::take_string() {
+    std::string value = as_string().take_value();
+    pimpl_->data = json_null{};
+    return value;
+}
+
+json_array json_value::take_array() {
+    json_array value = std::move(as_array());
+    pimpl_->data = json_null{};
+    return value;
+}
+
+json_object json_value::take_object() {
+    json_object value = std::move(as_object());
+    pimpl_->data = json_null{};
+    return value;
+}
+
 json_value json_value::make_array() {
     json_value v;
     v.pimpl_->data = std::make_unique<json_array>();
@@ -315,3 +570,9 @@ json_value json_value::make_object() {
     v.pimpl_->data = std::make_unique<json_object>();
     return v;
 }
+
+json_value json_value::make_number(std::string lexeme) {
+    json_value v;
+    v.pimpl_->data = json_number::from_lexeme(std::move(lexeme));
+    return v;
+}
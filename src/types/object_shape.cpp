@@ -0,0 +1,42 @@
+#include "../../include/types/object_shape.hpp"
+
+namespace {
+    // Scanning a few keys compares lengths first and beats hashing
+    constexpr size_t max_scanned = 8;
+}
+
+object_shape::object_shape(std::vector<std::string> keys) : keys_(std::move(keys)) {
+    if (keys_.size() > max_scanned) {
+        index_.reserve(keys_.size());
+        for (size_t i = 0; i < keys_.size(); ++i) {
+            index_.emplace(keys_[i], i);
+        }
+    }
+}
+
+size_t object_shape::size() const {
+    return keys_.size();
+}
+
+const std::string& object_shape::key(size_t slot) const {
+    return keys_[slot];
+}
+
+const std::vector<std::string>& object_shape::keys() const {
+    return keys_;
+}
+
+size_t object_shape::find(std::string_view key) const {
+    if (keys_.size() > max_scanned) {
+        auto it = index_.find(key);
+        return it != index_.end() ? it->second : npos;
+    }
+
+    for (size_t i = 0; i < keys_.size(); ++i) {
+        if (keys_[i] == key) {
+            return i;
+        }
+    }
+
+    return npos;
+}
@@ -0,0 +1,19 @@
+#include "../../include/types/source_text.hpp"
+
+source_text::source_text() = default;
+
+source_text::source_text(std::shared_ptr<const std::string> input, size_t begin, size_t end)
+    : input_(std::move(input)), view_(std::string_view(*input_).substr(begin, end - begin)) {}
+
+bool source_text::empty() const {
+    return view_.empty();
+}
+
+std::string_view source_text::view() const {
+    return view_;
+}
+
+void source_text::reset() {
+    input_.reset();
+    view_ = std::string_view();
+}
@@ -0,0 +1,138 @@
+#include "../../include/utils/json_comparer.hpp"
+#include "../../include/utils/numeric_kernels.hpp"
+#include <cstring>
+
+bool json_comparer::equal(const json_array& a, const json_array& b) {
+    return open(a, b) && run();
+}
+
+bool json_comparer::equal(const json_object& a, const json_object& b) {
+    return open(a, b) && run();
+}
+
+bool json_comparer::open(const json_array& a, const json_array& b) {
+    if (&a == &b) {
+        return true;
+    }
+
+    if (a.size() != b.size()) {
+        return false;
+    }
+
+    // Cached after the first comparison, so unequal sealed arrays are then
+    // told apart in O(1)
+    if (a.sealed_ && b.sealed_ && a.hash() != b.hash()) {
+        return false;
+    }
+
+    if (a.packing_ != json_array::packing::none && a.packing_ == b.packing_) {
+        if (a.packing_ == json_array::packing::numbers) {
+            return numeric_kernels::equal(a.numbers_.data(), b.numbers_.data(), a.numbers_.size());
+        }
+
+        return a.booleans_.empty() || std::memcmp(a.booleans_.data(), b.booleans_.data(), a.booleans_.size()) == 0;
+    }
+
+    // Numbers never equal booleans
+    if (a.packing_ != json_array::packing::none && b.packing_ != json_array::packing::none) {
+        return a.empty();
+    }
+
+    // At most one side is packed here, and it is read from its buffer;
+    // a packed element never equals a container
+    if (a.packing_ != json_array::packing::none || b.packing_ != json_array::packing::none) {
+        const json_array& generic = a.packing_ == json_array::packing::none ? a : b;
+        const json_array& compared = a.packing_ == json_array::packing::none ? b : a;
+        for (size_t i = 0; i < generic.size(); ++i) {
+            if (!compared.element_equals(i, generic.values_[i])) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    stack_.push_back({&a, &b, nullptr, nullptr, 0, {}});
+    return true;
+}
+
+bool json_comparer::open(const json_object& a, const json_object& b) {
+    if (&a == &b) {
+        return true;
+    }
+
+    if (a.size() != b.size()) {
+        return false;
+    }
+
+    if (a.sealed_ && b.sealed_ && a.hash() != b.hash()) {
+        return false;
+    }
+
+    stack_.push_back({nullptr, nullptr, &a, &b, 0, a.begin()});
+    return true;
+}
+
+// Scalars are compared directly; containers are opened
+bool json_comparer::compare(const json_value& a, const json_value& b) {
+    if (a.type() != b.type()) {
+        return false;
+    }
+
+    switch (a.type()) {
+        case json_type::array:
+            return open(a.as_array(), b.as_array());
+        case json_type::object:
+            return open(a.as_object(), b.as_object());
+        default:
+            return a == b;
+    }
+}
+
+bool json_comparer::run() {
+    while (!stack_.empty()) {
+        frame& f = stack_.back();
+        const json_value* a;
+        const json_value* b;
+        if (f.arr) {
+            if (f.index == f.arr->size()) {
+                stack_.pop_back();
+                continue;
+            }
+
+            a = &f.arr->values_[f.index];
+            b = &f.other_arr->values_[f.index];
+            ++f.index;
+        }
+        else if (f.obj->shape_ && f.obj->shape_ == f.other_obj->shape_) {
+            if (f.index == f.obj->slots_.size()) {
+                stack_.pop_back();
+                continue;
+            }
+
+            a = &f.obj->slots_[f.index];
+            b = &f.other_obj->slots_[f.index];
+            ++f.index;
+        }
+        else {
+            if (f.it == f.obj->end()) {
+                stack_.pop_back();
+                continue;
+            }
+
+            a = &f.it->second;
+            b = f.other_obj->find(f.it->first);
+            ++f.it;
+            if (!b) {
+                return false;
+            }
+        }
+
+        // f may dangle once compare() pushes a new frame
+        if (!compare(*a, *b)) {
+            return false;
+        }
+    }
+
+    return true;
+}
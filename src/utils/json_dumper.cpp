@@ -0,0 +1,179 @@
+#include "../../include/utils/json_dumper.hpp"
+#include "../../include/utils/string_writer.hpp"
+#include "../../include/types/json_number.hpp"
+
+json_dumper::json_dumper(std::string& out, int indent, bool ascii_only, bool memoize)
+    : out_(out), indent_(indent), ascii_only_(ascii_only), memoize_(memoize) {}
+
+void json_dumper::dump(const json_array& arr, int current_indent) {
+    open(&arr, nullptr, current_indent, false);
+    run();
+}
+
+void json_dumper::dump(const json_object& obj, int current_indent) {
+    open(nullptr, &obj, current_indent, false);
+    run();
+}
+
+// Writes the opening bracket; non-empty containers are pushed so that
+// run() emits their members, empty ones are closed immediately. Compact
+// dumps copy the parsed text of unmodified containers instead; it may hold
+// non-ASCII bytes, so ascii_only dumps always re-serialize. Memoizing
+// dumps likewise copy what a sealed container cached.
+void json_dumper::open(const json_array* arr, const json_object* obj, int current_indent, bool parent_sealed) {
+    if (indent_ < 0 && !ascii_only_) {
+        std::string_view source = arr ? arr->source() : obj->source();
+        if (!source.empty()) {
+            out_.append(source.data(), source.size());
+            return;
+        }
+    }
+
+    bool sealed = arr ? arr->sealed_ : obj->sealed_;
+    if (memoize_ && sealed && copy_cached(arr, obj, current_indent)) {
+        return;
+    }
+
+    size_t start = out_.size();
+    bool empty = arr ? arr->empty() : obj->empty();
+    out_ += arr ? '[' : '{';
+    if (empty) {
+        out_ += arr ? ']' : '}';
+        return;
+    }
+
+    if (indent_ >= 0) {
+        out_ += '\n';
+    }
+
+    frame f{arr, obj, 0, {}, current_indent, start, memoize_ && sealed && !parent_sealed};
+    if (arr && arr->get_packing() != json_array::packing::none) {
+        write_packed(*arr, current_indent);
+        close(f);
+        return;
+    }
+
+    if (obj) {
+        f.it = obj->begin();
+    }
+
+    stack_.push_back(f);
+}
+
+// Packed elements are written straight from the buffer, without going
+// through a json_value per element
+void json_dumper::write_packed(const json_array& arr, int current_indent) {
+    bool numbers = arr.get_packing() == json_array::packing::numbers;
+    const double* number_data = numbers ? arr.numbers().data() : nullptr;
+    const std::uint8_t* boolean_data = numbers ? nullptr : arr.booleans().data();
+    size_t count = arr.size();
+    for (size_t i = 0; i < count; ++i) {
+        if (i > 0) {
+            out_ += ',';
+        }
+
+        if (indent_ >= 0) {
+            if (i > 0) {
+                out_ += '\n';
+            }
+
+            out_.append(current_indent + indent_, ' ');
+        }
+
+        if (numbers) {
+            json_number::write(out_, number_data[i]);
+        }
+        else {
+            out_ += boolean_data[i] ? "true" : "false";
+        }
+    }
+}
+
+bool json_dumper::copy_cached(const json_array* arr, const json_object* obj, int current_indent) {
+    std::shared_ptr<const dump_cache> cached = std::atomic_load(arr ? &arr->dump_ : &obj->dump_);
+    if (!cached || cached->indent != indent_ || cached->current_indent != current_indent ||
+        cached->ascii_only != ascii_only_) {
+        return false;
+    }
+
+    out_ += cached->text;
+    return true;
+}
+
+void json_dumper::close(const frame& f) {
+    if (indent_ >= 0) {
+        out_ += '\n';
+        out_.append(f.current_indent, ' ');
+    }
+
+    out_ += f.arr ? ']' : '}';
+    if (f.store) {
+        auto text = std::make_shared<const dump_cache>(
+            dump_cache{indent_, f.current_indent, ascii_only_, out_.substr(f.start)});
+        std::atomic_store(f.arr ? &f.arr->dump_ : &f.obj->dump_, std::move(text));
+    }
+}
+
+void json_dumper::run() {
+    while (!stack_.empty()) {
+        frame& f = stack_.back();
+        const json_value* child;
+        const std::string* key = nullptr;
+        if (f.arr) {
+            if (f.index == f.arr->size()) {
+                close(f);
+                stack_.pop_back();
+                continue;
+            }
+
+            child = &f.arr->get_values()[f.index];
+        }
+        else {
+            if (f.it == f.obj->end()) {
+                close(f);
+                stack_.pop_back();
+                continue;
+            }
+
+            key = &f.it->first;
+            child = &f.it->second;
+            ++f.it;
+        }
+
+        if (f.index > 0) {
+            out_ += ',';
+        }
+
+        if (indent_ >= 0) {
+            if (f.index > 0) {
+                out_ += '\n';
+            }
+
+            out_.append(f.current_indent + indent_, ' ');
+        }
+
+        ++f.index;
+        if (key) {
+            string_writer::write(out_, *key, ascii_only_);
+            out_ += ':';
+            if (indent_ >= 0) {
+                out_ += ' ';
+            }
+        }
+
+        // f may dangle once open() pushes a new frame
+        int child_indent = f.current_indent + indent_;
+        bool sealed = f.arr ? f.arr->sealed_ : f.obj->sealed_;
+        switch (child->type()) {
+            case json_type::array:
+                open(&child->as_array(), nullptr, child_indent, sealed);
+                break;
+            case json_type::object:
+                open(nullptr, &child->as_object(), child_indent, sealed);
+                break;
+            default:
+                child->dump_to(out_, indent_, child_indent, ascii_only_);
+                break;
+        }
+    }
+}
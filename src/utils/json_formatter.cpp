@@ -0,0 +1,232 @@
+#include "../../include/utils/json_formatter.hpp"
+#include "../../include/utils/string_scanner.hpp"
+#include <stdexcept>
+
+namespace {
+    // Numbers and the literals true, false and null
+    bool is_token_char(char c) {
+        return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '-' || c == '+' ||
+               c == '.';
+    }
+}
+
+json_formatter::json_formatter(std::string& out, int indent)
+    : out_(out), indent_(indent), expect_(expect::value), in_string_(false), escaped_(false), in_token_(false),
+      offset_(0) {}
+
+void json_formatter::write(std::string_view text) {
+    const char* data = text.data();
+    size_t size = text.size();
+    size_t pos = 0;
+    while (pos < size) {
+        if (in_string_) {
+            pos = write_string(data, size, pos);
+            continue;
+        }
+
+        if (in_token_) {
+            size_t end = pos;
+            while (end < size && is_token_char(data[end])) {
+                ++end;
+            }
+
+            out_.append(data + pos, end - pos);
+            pos = end;
+            if (pos < size) {
+                in_token_ = false;
+                finish_value();
+            }
+
+            continue;
+        }
+
+        char c = data[pos];
+        switch (c) {
+            case ' ':
+            case '\t':
+            case '\n':
+            case '\r':
+                pos += string_scanner::whitespace_prefix(data + pos, size - pos);
+                continue;
+            case '{':
+            case '[':
+                start_value(pos);
+                out_ += c;
+                closers_.push_back(c == '{' ? '}' : ']');
+                expect_ = c == '{' ? expect::key_or_close : expect::value_or_close;
+                break;
+            case '}':
+            case ']':
+                close(c, pos);
+                break;
+            case ',':
+                if (expect_ != expect::comma_or_close) {
+                    fail(pos, "unexpected comma");
+                }
+
+                out_ += ',';
+                line_break(closers_.size());
+                expect_ = closers_.back() == '}' ? expect::key : expect::value;
+                break;
+            case ':':
+                if (expect_ != expect::colon) {
+                    fail(pos, "unexpected colon");
+                }
+
+                out_ += ':';
+                if (indent_ >= 0) {
+                    out_ += ' ';
+                }
+
+                expect_ = expect::value;
+                break;
+            case '"':
+                if (expect_ == expect::key || expect_ == expect::key_or_close) {
+                    if (expect_ == expect::key_or_close) {
+                        line_break(closers_.size());
+                    }
+
+                    expect_ = expect::colon;
+                }
+                else {
+                    start_value(pos);
+                }
+
+                out_ += '"';
+                in_string_ = true;
+                break;
+            default:
+                if (!is_token_char(c)) {
+                    fail(pos, "unexpected character");
+                }
+
+                start_value(pos);
+                in_token_ = true;
+                continue;
+        }
+
+        ++pos;
+    }
+
+    offset_ += size;
+}
+
+void json_formatter::finish() {
+    if (in_token_) {
+        in_token_ = false;
+        finish_value();
+    }
+
+    if (in_string_) {
+        fail(0, "unterminated string");
+    }
+
+    if (expect_ != expect::end) {
+        fail(0, "unexpected end of input");
+    }
+}
+
+std::string json_formatter::minify(std::string_view text) {
+    std::string out;
+    out.reserve(text.size());
+    json_formatter formatter(out);
+    formatter.write(text);
+    formatter.finish();
+    return out;
+}
+
+std::string json_formatter::prettify(std::string_view text, int indent) {
+    std::string out;
+    out.reserve(text.size() + text.size() / 2);
+    json_formatter formatter(out, indent);
+    formatter.write(text);
+    formatter.finish();
+    return out;
+}
+
+// Copies string content up to the closing quote, or the end of the chunk;
+// runs without quotes, escapes or control characters are found with SIMD
+size_t json_formatter::write_string(const char* data, size_t size, size_t pos) {
+    if (escaped_) {
+        out_ += data[pos++];
+        escaped_ = false;
+    }
+
+    size_t plain = string_scanner::plain_prefix(data + pos, size - pos, false);
+    out_.append(data + pos, plain);
+    pos += plain;
+    if (pos == size) {
+        return pos;
+    }
+
+    char c = data[pos];
+    if (static_cast<unsigned char>(c) < 0x20) {
+        fail(pos, "control character in string");
+    }
+
+    out_ += c;
+    if (c == '\\') {
+        escaped_ = true;
+    }
+    else {
+        in_string_ = false;
+        if (expect_ != expect::colon) {
+            finish_value();
+        }
+    }
+
+    return pos + 1;
+}
+
+void json_formatter::start_value(size_t pos) {
+    if (expect_ == expect::value_or_close) {
+        line_break(closers_.size());
+    }
+    else if (expect_ == expect::end) {
+        fail(pos, "unexpected data after the value");
+    }
+    else if (expect_ == expect::key || expect_ == expect::key_or_close) {
+        fail(pos, "expected a key");
+    }
+    else if (expect_ == expect::colon) {
+        fail(pos, "expected a colon");
+    }
+    else if (expect_ == expect::comma_or_close) {
+        fail(pos, "expected a comma or closing bracket");
+    }
+}
+
+void json_formatter::finish_value() {
+    expect_ = closers_.empty() ? expect::end : expect::comma_or_close;
+}
+
+// Empty containers stay on one line, as json_value::dump writes them
+void json_formatter::close(char closer, size_t pos) {
+    if (closers_.empty() || closers_.back() != closer) {
+        fail(pos, "mismatched bracket");
+    }
+
+    bool empty = expect_ == (closer == '}' ? expect::key_or_close : expect::value_or_close);
+    if (!empty && expect_ != expect::comma_or_close) {
+        fail(pos, "unexpected bracket");
+    }
+
+    closers_.pop_back();
+    if (!empty) {
+        line_break(closers_.size());
+    }
+
+    out_ += closer;
+    finish_value();
+}
+
+void json_formatter::line_break(size_t depth) {
+    if (indent_ >= 0) {
+        out_ += '\n';
+        out_.append(depth * static_cast<size_t>(indent_), ' ');
+    }
+}
+
+void json_formatter::fail(size_t pos, const char* message) const {
+    throw std::runtime_error("Malformed JSON at offset " + std::to_string(offset_ + pos) + ": " + message);
+}
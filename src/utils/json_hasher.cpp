@@ -0,0 +1,147 @@
+#include "../../include/utils/json_hasher.hpp"
+#include "../../include/utils/structural_hash.hpp"
+#include <cstdint>
+
+size_t json_hasher::hash(const json_array& arr) {
+    size_t result;
+    if (open(&arr, nullptr, result)) {
+        return result;
+    }
+
+    return run();
+}
+
+size_t json_hasher::hash(const json_object& obj) {
+    size_t result;
+    if (open(nullptr, &obj, result)) {
+        return result;
+    }
+
+    return run();
+}
+
+bool json_hasher::cached(const json_array* arr, const json_object* obj, size_t& result) {
+    bool sealed = arr ? arr->sealed_ : obj->sealed_;
+    result = sealed ? (arr ? arr->hash_ : obj->hash_).load(std::memory_order_relaxed) : 0;
+    return result != 0;
+}
+
+bool json_hasher::open(const json_array* arr, const json_object* obj, size_t& result) {
+    if (cached(arr, obj, result)) {
+        return true;
+    }
+
+    frame f{arr, obj, 0, {}, 0, nullptr};
+    if (obj) {
+        f.it = obj->begin();
+        stack_.push_back(f);
+        return false;
+    }
+
+    f.seed = structural_hash::array_seed(arr->size());
+    // Packed arrays hold only scalars and are hashed from their buffers
+    if (arr->packing_ == json_array::packing::numbers) {
+        for (double number : arr->numbers_) {
+            f.seed = structural_hash::add_element(f.seed, structural_hash::of_number(number));
+        }
+
+        result = close(f);
+        return true;
+    }
+
+    if (arr->packing_ == json_array::packing::booleans) {
+        for (std::uint8_t boolean : arr->booleans_) {
+            f.seed = structural_hash::add_element(f.seed, structural_hash::of_boolean(boolean != 0));
+        }
+
+        result = close(f);
+        return true;
+    }
+
+    stack_.push_back(f);
+    return false;
+}
+
+size_t json_hasher::close(const frame& f) {
+    size_t result;
+    if (f.arr) {
+        result = structural_hash::finish(f.seed);
+        if (f.arr->sealed_) {
+            f.arr->hash_.store(result, std::memory_order_relaxed);
+        }
+    }
+    else {
+        result = structural_hash::finish(structural_hash::object_seed(f.seed, f.obj->size()));
+        if (f.obj->sealed_) {
+            f.obj->hash_.store(result, std::memory_order_relaxed);
+        }
+    }
+
+    return result;
+}
+
+size_t json_hasher::run() {
+    // Hash of the container or scalar just finished, to fold into the frame
+    // on top of the stack
+    size_t value = 0;
+    bool finished = false;
+    while (true) {
+        frame& f = stack_.back();
+        if (finished) {
+            if (f.arr) {
+                f.seed = structural_hash::add_element(f.seed, value);
+            }
+            else {
+                f.seed += structural_hash::member(*f.key, value);
+            }
+
+            finished = false;
+        }
+
+        const json_value* child;
+        if (f.arr) {
+            if (f.index == f.arr->size()) {
+                value = close(f);
+                stack_.pop_back();
+                if (stack_.empty()) {
+                    return value;
+                }
+
+                finished = true;
+                continue;
+            }
+
+            child = &f.arr->values_[f.index++];
+        }
+        else {
+            if (f.it == f.obj->end()) {
+                value = close(f);
+                stack_.pop_back();
+                if (stack_.empty()) {
+                    return value;
+                }
+
+                finished = true;
+                continue;
+            }
+
+            f.key = &f.it->first;
+            child = &f.it->second;
+            ++f.it;
+        }
+
+        // f may dangle once open() pushes a new frame
+        switch (child->type()) {
+            case json_type::array:
+                finished = open(&child->as_array(), nullptr, value);
+                break;
+            case json_type::object:
+                finished = open(nullptr, &child->as_object(), value);
+                break;
+            default:
+                value = child->hash();
+                finished = true;
+                break;
+        }
+    }
+}
@@ -0,0 +1,154 @@
+#include "../../include/utils/json_interner.hpp"
+#include "../../include/types/json_number.hpp"
+#include "../../include/types/json_array.hpp"
+#include "../../include/types/json_object.hpp"
+#include <cstring>
+
+// Visits the tree children first with an explicit stack, so every node is
+// looked up after its children already point at pooled nodes and comparing
+// it with a candidate mostly compares pointers. Nodes that are already
+// shared are immutable and not descended into.
+void json_interner::intern(json_value& value) {
+    std::vector<std::pair<json_value*, bool>> stack;
+    stack.push_back({&value, false});
+    while (!stack.empty()) {
+        json_value* current = stack.back().first;
+        if (stack.back().second || current->is_shared()) {
+            stack.pop_back();
+            intern_node(*current);
+            continue;
+        }
+
+        stack.back().second = true;
+        if (current->is_array()) {
+            json_array& arr = current->as_array();
+            if (arr.get_packing() == json_array::packing::none) {
+                for (json_value& element : arr.values_) {
+                    stack.push_back({&element, false});
+                }
+            }
+        }
+        else if (current->is_object()) {
+            json_object& obj = current->as_object();
+            if (obj.shape_) {
+                for (json_value& slot : obj.slots_) {
+                    stack.push_back({&slot, false});
+                }
+            }
+            else {
+                for (auto& entry : obj.values_) {
+                    stack.push_back({&entry.second, false});
+                }
+            }
+        }
+    }
+}
+
+size_t json_interner::size() const {
+    return size_;
+}
+
+void json_interner::clear() {
+    pool_.clear();
+    size_ = 0;
+}
+
+void json_interner::intern_node(json_value& value) {
+    if (!value.is_shared()) {
+        // Nothing modifies the node through earlier references any more
+        if (value.is_array()) {
+            value.as_array().seal();
+        }
+        else if (value.is_object()) {
+            value.as_object().seal();
+        }
+    }
+
+    std::vector<json_value>& bucket = pool_[value.hash()];
+    for (const json_value& candidate : bucket) {
+        if (candidate.same_node(value)) {
+            return;
+        }
+
+        if (interchangeable(candidate, value)) {
+            value.share(candidate);
+            return;
+        }
+    }
+
+    value.mark_shared();
+    bucket.push_back(value);
+    ++size_;
+}
+
+// Stricter than ==, which ignores how numbers are written (1.5 and 1.50,
+// 0 and -0). The children of both are pooled already, so containers are
+// interchangeable exactly when they hold the same nodes.
+bool json_interner::interchangeable(const json_value& pooled, const json_value& value) {
+    if (pooled.is_number() && value.is_number()) {
+        const json_number& a = pooled.as_number();
+        const json_number& b = value.as_number();
+        if (a.get_lexeme() != b.get_lexeme()) {
+            return false;
+        }
+
+        double x = a.get_value();
+        double y = b.get_value();
+
+        return std::memcmp(&x, &y, sizeof(double)) == 0;
+    }
+
+    if (pooled.is_array() && value.is_array()) {
+        const json_array& a = pooled.as_array();
+        const json_array& b = value.as_array();
+        if (a.get_packing() != b.get_packing() || a.size() != b.size()) {
+            return false;
+        }
+
+        if (a.get_packing() == json_array::packing::numbers) {
+            return a.size() == 0 ||
+                   std::memcmp(a.numbers().data(), b.numbers().data(), a.size() * sizeof(double)) == 0;
+        }
+
+        if (a.get_packing() == json_array::packing::booleans) {
+            return a == b;
+        }
+
+        for (size_t i = 0; i < a.size(); ++i) {
+            if (!a.values_[i].same_node(b.values_[i])) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    if (pooled.is_object() && value.is_object()) {
+        const json_object& a = pooled.as_object();
+        const json_object& b = value.as_object();
+        if (a.size() != b.size()) {
+            return false;
+        }
+
+        if (a.shape_ && a.shape_ == b.shape_) {
+            for (size_t i = 0; i < a.slots_.size(); ++i) {
+                if (!a.slots_[i].same_node(b.slots_[i])) {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        for (const auto& entry : a) {
+            const json_value* match = b.find(entry.first);
+            if (!match || !entry.second.same_node(*match)) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    return pooled == value;
+}
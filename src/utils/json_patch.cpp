@@ -0,0 +1,499 @@
+#include "../../include/utils/json_patch.hpp"
+#include "../../include/types/json_array.hpp"
+#include "../../include/types/json_object.hpp"
+#include "../../include/types/json_string.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+    // Larger edits are matched by position instead: the longest common
+    // subsequence needs a table entry per pair of differing elements
+    constexpr size_t max_lcs_cells = size_t(1) << 22;
+
+    void append_token(std::string& path, std::string_view token) {
+        path += '/';
+        for (char c : token) {
+            if (c == '~') {
+                path += "~0";
+            }
+            else if (c == '/') {
+                path += "~1";
+            }
+            else {
+                path += c;
+            }
+        }
+    }
+
+    void append_index(std::string& path, size_t index) {
+        path += '/';
+        path += std::to_string(index);
+    }
+
+    json_object& add_operation(json_array& ops, const char* op, const std::string& path) {
+        json_object& operation = ops.emplace_back(json_value::make_object()).as_object();
+        operation.insert_or_assign("op", json_value(op));
+        operation.insert_or_assign("path", json_value(path));
+        return operation;
+    }
+
+    void diff_values(const json_value& from, const json_value& to, std::string& path, json_array& ops);
+
+    void diff_objects(const json_object& from, const json_object& to, std::string& path, json_array& ops) {
+        size_t length = path.size();
+        for (const auto& entry : from) {
+            append_token(path, entry.first);
+            const json_value* match = to.find(entry.first);
+            if (match) {
+                diff_values(entry.second, *match, path, ops);
+            }
+            else {
+                add_operation(ops, "remove", path);
+            }
+
+            path.resize(length);
+        }
+
+        for (const auto& entry : to) {
+            if (!from.contains(entry.first)) {
+                append_token(path, entry.first);
+                add_operation(ops, "add", path).insert_or_assign("value", json_value(entry.second));
+                path.resize(length);
+            }
+        }
+    }
+
+    // Keeps the longest common subsequence of the elements between the
+    // common prefix and suffix. Each run of elements in between is paired
+    // up by position and diffed, and the rest is removed or added.
+    void diff_arrays(const json_array& from, const json_array& to, std::string& path, json_array& ops) {
+        // A packed side is diffed through an unpacked copy that lives only
+        // as long as the diff, instead of the mirror its const element
+        // access would keep
+        if (from.get_packing() != json_array::packing::none) {
+            json_array unpacked(from);
+            unpacked.unpack();
+            diff_arrays(unpacked, to, path, ops);
+            return;
+        }
+
+        if (to.get_packing() != json_array::packing::none) {
+            json_array unpacked(to);
+            unpacked.unpack();
+            diff_arrays(from, unpacked, path, ops);
+            return;
+        }
+
+        size_t from_size = from.size();
+        size_t to_size = to.size();
+        size_t prefix = 0;
+        while (prefix < from_size && prefix < to_size && from[prefix] == to[prefix]) {
+            ++prefix;
+        }
+
+        size_t suffix = 0;
+        while (suffix < from_size - prefix && suffix < to_size - prefix &&
+               from[from_size - 1 - suffix] == to[to_size - 1 - suffix]) {
+            ++suffix;
+        }
+
+        size_t rows = from_size - prefix - suffix;
+        size_t columns = to_size - prefix - suffix;
+        std::vector<std::pair<size_t, size_t>> kept;
+        if (rows != 0 && columns != 0 && rows <= max_lcs_cells / columns) {
+            // Equal elements get the same id, so the table compares integers
+            std::unordered_map<size_t, std::vector<std::pair<const json_value*, size_t>>> classes;
+            size_t next_id = 0;
+            auto identify = [&classes, &next_id](const json_value& value) {
+                auto& bucket = classes[value.hash()];
+                for (const auto& candidate : bucket) {
+                    if (*candidate.first == value) {
+                        return candidate.second;
+                    }
+                }
+
+                bucket.push_back({&value, next_id});
+                return next_id++;
+            };
+
+            std::vector<size_t> from_ids(rows);
+            std::vector<size_t> to_ids(columns);
+            for (size_t i = 0; i < rows; ++i) {
+                from_ids[i] = identify(from[prefix + i]);
+            }
+
+            for (size_t j = 0; j < columns; ++j) {
+                to_ids[j] = identify(to[prefix + j]);
+            }
+
+            // Length of the common subsequence of the remaining elements
+            std::vector<std::uint32_t> table((rows + 1) * (columns + 1), 0);
+            auto cell = [&table, columns](size_t i, size_t j) -> std::uint32_t& {
+                return table[i * (columns + 1) + j];
+            };
+
+            for (size_t i = rows; i-- > 0;) {
+                for (size_t j = columns; j-- > 0;) {
+                    cell(i, j) = from_ids[i] == to_ids[j] ? cell(i + 1, j + 1) + 1
+                                                          : std::max(cell(i + 1, j), cell(i, j + 1));
+                }
+            }
+
+            size_t i = 0;
+            size_t j = 0;
+            while (i < rows && j < columns) {
+                if (from_ids[i] == to_ids[j]) {
+                    kept.push_back({i++, j++});
+                }
+                else if (cell(i + 1, j) >= cell(i, j + 1)) {
+                    ++i;
+                }
+                else {
+                    ++j;
+                }
+            }
+        }
+
+        // Paths index the array as already patched up to that operation
+        kept.push_back({rows, columns});
+        size_t length = path.size();
+        size_t position = prefix;
+        size_t i = 0;
+        size_t j = 0;
+        for (const auto& match : kept) {
+            size_t removed = match.first - i;
+            size_t added = match.second - j;
+            size_t paired = std::min(removed, added);
+            for (size_t k = 0; k < paired; ++k) {
+                append_index(path, position++);
+                diff_values(from[prefix + i + k], to[prefix + j + k], path, ops);
+                path.resize(length);
+            }
+
+            for (size_t k = paired; k < removed; ++k) {
+                append_index(path, position);
+                add_operation(ops, "remove", path);
+                path.resize(length);
+            }
+
+            for (size_t k = paired; k < added; ++k) {
+                append_index(path, position++);
+                add_operation(ops, "add", path).insert_or_assign("value", json_value(to[prefix + j + k]));
+                path.resize(length);
+            }
+
+            i = match.first + 1;
+            j = match.second + 1;
+            ++position;
+        }
+    }
+
+    void diff_values(const json_value& from, const json_value& to, std::string& path, json_array& ops) {
+        if (from == to) {
+            return;
+        }
+
+        if (from.is_object() && to.is_object()) {
+            diff_objects(from.as_object(), to.as_object(), path, ops);
+            return;
+        }
+
+        if (from.is_array() && to.is_array()) {
+            diff_arrays(from.as_array(), to.as_array(), path, ops);
+            return;
+        }
+
+        add_operation(ops, "replace", path).insert_or_assign("value", json_value(to));
+    }
+
+    std::vector<std::string> split_pointer(std::string_view pointer) {
+        std::vector<std::string> tokens;
+        if (pointer.empty()) {
+            return tokens;
+        }
+
+        if (pointer[0] != '/') {
+            throw std::runtime_error("Invalid JSON pointer: " + std::string(pointer));
+        }
+
+        std::string token;
+        for (size_t i = 1; i <= pointer.size(); ++i) {
+            if (i == pointer.size() || pointer[i] == '/') {
+                tokens.push_back(token);
+                token.clear();
+            }
+            else if (pointer[i] == '~') {
+                char escaped = i + 1 < pointer.size() ? pointer[i + 1] : '\0';
+                if (escaped != '0' && escaped != '1') {
+                    throw std::runtime_error("Invalid JSON pointer: " + std::string(pointer));
+                }
+
+                token += escaped == '0' ? '~' : '/';
+                ++i;
+            }
+            else {
+                token += pointer[i];
+            }
+        }
+
+        return tokens;
+    }
+
+    // Decimal without leading zeros, as RFC 6901 requires
+    bool parse_index(const std::string& token, size_t& index) {
+        if (token.empty() || token.size() > 19 || (token[0] == '0' && token.size() > 1)) {
+            return false;
+        }
+
+        index = 0;
+        for (char c : token) {
+            if (c < '0' || c > '9') {
+                return false;
+            }
+
+            index = index * 10 + static_cast<size_t>(c - '0');
+        }
+
+        return true;
+    }
+
+    // "-" names the position after the last element, where only add can go
+    size_t array_index(const std::string& token, size_t size, bool allow_end, std::string_view pointer) {
+        size_t index = 0;
+        if (allow_end && token == "-") {
+            return size;
+        }
+
+        if (!parse_index(token, index) || index > size || (index == size && !allow_end)) {
+            throw std::out_of_range("Path not found: " + std::string(pointer));
+        }
+
+        return index;
+    }
+
+    const json_value* child(const json_value& parent, const std::string& token) {
+        if (parent.is_object()) {
+            return parent.as_object().find(token);
+        }
+
+        size_t index = 0;
+        if (parent.is_array() && parse_index(token, index) && index < parent.as_array().size()) {
+            return &parent.as_array()[index];
+        }
+
+        return nullptr;
+    }
+
+    // Mutable access along the path unshares and unseals only the
+    // containers on it
+    json_value& locate(json_value& root, const std::vector<std::string>& tokens, size_t count,
+                       std::string_view pointer) {
+        json_value* current = &root;
+        for (size_t i = 0; i < count; ++i) {
+            if (current->is_object()) {
+                current = current->as_object().find(tokens[i]);
+            }
+            else if (current->is_array()) {
+                json_array& arr = current->as_array();
+                current = &arr[array_index(tokens[i], arr.size(), false, pointer)].as_value();
+            }
+            else {
+                current = nullptr;
+            }
+
+            if (!current) {
+                throw std::out_of_range("Path not found: " + std::string(pointer));
+            }
+        }
+
+        return *current;
+    }
+
+    void add_at(json_value& root, const std::vector<std::string>& tokens, std::string_view pointer,
+                json_value&& value) {
+        if (tokens.empty()) {
+            root = std::move(value);
+            return;
+        }
+
+        json_value& parent = locate(root, tokens, tokens.size() - 1, pointer);
+        if (parent.is_object()) {
+            parent.as_object().insert_or_assign(std::string(tokens.back()), std::move(value));
+            return;
+        }
+
+        if (!parent.is_array()) {
+            throw std::out_of_range("Path not found: " + std::string(pointer));
+        }
+
+        json_array& arr = parent.as_array();
+        arr.insert(array_index(tokens.back(), arr.size(), true, pointer), std::move(value));
+    }
+
+    json_value remove_at(json_value& root, const std::vector<std::string>& tokens, std::string_view pointer) {
+        if (tokens.empty()) {
+            throw std::runtime_error("Invalid patch: cannot remove the document root");
+        }
+
+        json_value& parent = locate(root, tokens, tokens.size() - 1, pointer);
+        if (parent.is_object() && parent.as_object().contains(tokens.back())) {
+            return parent.as_object().extract(tokens.back());
+        }
+
+        if (!parent.is_array()) {
+            throw std::out_of_range("Path not found: " + std::string(pointer));
+        }
+
+        json_array& arr = parent.as_array();
+        return arr.extract(array_index(tokens.back(), arr.size(), false, pointer));
+    }
+
+    const json_value& operand(const json_object& op, std::string_view name) {
+        const json_value* value = op.find(name);
+        if (!value) {
+            throw std::runtime_error("Invalid patch operation: missing " + std::string(name));
+        }
+
+        return *value;
+    }
+
+    const std::string& text_operand(const json_object& op, std::string_view name) {
+        const json_value& value = operand(op, name);
+        if (!value.is_string()) {
+            throw std::runtime_error("Invalid patch operation: " + std::string(name) + " is not a string");
+        }
+
+        return value.as_string().get_value();
+    }
+}
+
+json_value json_patch::diff(const json_value& from, const json_value& to) {
+    json_value ops = json_value::make_array();
+    std::string path;
+    diff_values(from, to, path, ops.as_array());
+    return ops;
+}
+
+void json_patch::apply(json_value& target, const json_value& patch) {
+    for (const json_value& operation : patch.as_array()) {
+        const json_object& op = operation.as_object();
+        const std::string& name = text_operand(op, "op");
+        const std::string& path = text_operand(op, "path");
+        std::vector<std::string> tokens = split_pointer(path);
+        if (name == "add") {
+            add_at(target, tokens, path, json_value(operand(op, "value")));
+        }
+        else if (name == "remove") {
+            remove_at(target, tokens, path);
+        }
+        else if (name == "replace") {
+            json_value value = operand(op, "value");
+            locate(target, tokens, tokens.size(), path) = std::move(value);
+        }
+        else if (name == "move") {
+            const std::string& from = text_operand(op, "from");
+            if (path.size() > from.size() && path.compare(0, from.size(), from) == 0 && path[from.size()] == '/') {
+                throw std::runtime_error("Invalid patch: cannot move " + from + " into itself");
+            }
+
+            std::vector<std::string> from_tokens = split_pointer(from);
+            if (from == path) {
+                if (!find(target, from)) {
+                    throw std::out_of_range("Path not found: " + from);
+                }
+
+                continue;
+            }
+
+            add_at(target, tokens, path, remove_at(target, from_tokens, from));
+        }
+        else if (name == "copy") {
+            const std::string& from = text_operand(op, "from");
+            const json_value* source = find(target, from);
+            if (!source) {
+                throw std::out_of_range("Path not found: " + from);
+            }
+
+            add_at(target, tokens, path, json_value(*source));
+        }
+        else if (name == "test") {
+            const json_value* current = find(target, path);
+            if (!current || *current != operand(op, "value")) {
+                throw std::runtime_error("Patch test failed: " + path);
+            }
+        }
+        else {
+            throw std::runtime_error("Invalid patch operation: " + name);
+        }
+    }
+}
+
+json_value json_patch::merge_diff(const json_value& from, const json_value& to) {
+    if (!from.is_object() || !to.is_object()) {
+        return to;
+    }
+
+    json_value result = json_value::make_object();
+    json_object& members = result.as_object();
+    const json_object& before = from.as_object();
+    const json_object& after = to.as_object();
+    for (const auto& entry : before) {
+        if (!after.contains(entry.first)) {
+            members.insert_or_assign(std::string(entry.first), json_value(nullptr));
+        }
+    }
+
+    for (const auto& entry : after) {
+        const json_value* previous = before.find(entry.first);
+        if (!previous) {
+            members.insert_or_assign(std::string(entry.first), json_value(entry.second));
+        }
+        else if (*previous != entry.second) {
+            members.insert_or_assign(std::string(entry.first), merge_diff(*previous, entry.second));
+        }
+    }
+
+    return result;
+}
+
+void json_patch::merge(json_value& target, const json_value& patch) {
+    if (!patch.is_object()) {
+        target = patch;
+        return;
+    }
+
+    if (!target.is_object()) {
+        target = json_value::make_object();
+    }
+
+    json_object& members = target.as_object();
+    for (const auto& entry : patch.as_object()) {
+        if (entry.second.is_null()) {
+            members.remove_key(entry.first);
+            continue;
+        }
+
+        json_value* slot = members.find(entry.first);
+        if (!slot) {
+            slot = &members.insert_or_assign(std::string(entry.first), json_value());
+        }
+
+        merge(*slot, entry.second);
+    }
+}
+
+const json_value* json_patch::find(const json_value& root, std::string_view pointer) {
+    const json_value* current = &root;
+    for (const std::string& token : split_pointer(pointer)) {
+        current = child(*current, token);
+        if (!current) {
+            return nullptr;
+        }
+    }
+
+    return current;
+}
@@ -0,0 +1,261 @@
+#include "../../include/utils/json_writer.hpp"
+#include "../../include/utils/string_writer.hpp"
+#include "../../include/types/json_number.hpp"
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <stdexcept>
+#include <unistd.h>
+
+namespace {
+    // Buffered sinks are written out once this much output is pending
+    constexpr size_t flush_threshold = 64 * 1024;
+}
+
+json_writer::json_writer(std::string& out, int indent, bool ascii_only)
+    : sink_(sink_kind::string), out_(out), stream_(nullptr), fd_(-1), indent_(indent), ascii_only_(ascii_only),
+      has_key_(false), complete_(false) {}
+
+json_writer::json_writer(std::ostream& stream, int indent, bool ascii_only)
+    : sink_(sink_kind::stream), out_(buffer_), stream_(&stream), fd_(-1), indent_(indent), ascii_only_(ascii_only),
+      has_key_(false), complete_(false) {}
+
+json_writer::json_writer(int fd, int indent, bool ascii_only)
+    : sink_(sink_kind::fd), out_(buffer_), stream_(nullptr), fd_(fd), indent_(indent), ascii_only_(ascii_only),
+      has_key_(false), complete_(false) {}
+
+json_writer::~json_writer() {
+    try {
+        flush();
+    } catch (const std::exception&) {
+        // Call flush() explicitly to observe write errors
+    }
+}
+
+json_writer& json_writer::begin_object() {
+    open(true);
+    return *this;
+}
+
+json_writer& json_writer::end_object() {
+    close(true);
+    return *this;
+}
+
+json_writer& json_writer::begin_array() {
+    open(false);
+    return *this;
+}
+
+json_writer& json_writer::end_array() {
+    close(false);
+    return *this;
+}
+
+json_writer& json_writer::key(std::string_view key) {
+    if (stack_.empty() || !stack_.back().is_object) {
+        throw std::runtime_error("Key written outside an object");
+    }
+
+    if (has_key_) {
+        throw std::runtime_error("Key written twice without a value");
+    }
+
+    frame& top = stack_.back();
+    if (top.count > 0) {
+        out_ += ',';
+    }
+
+    newline(stack_.size());
+    string_writer::write(out_, key, ascii_only_);
+    out_ += ':';
+    if (indent_ >= 0) {
+        out_ += ' ';
+    }
+
+    has_key_ = true;
+    return *this;
+}
+
+json_writer& json_writer::value(std::nullptr_t) {
+    before_value();
+    out_ += "null";
+    after_value();
+    return *this;
+}
+
+json_writer& json_writer::value(bool value) {
+    before_value();
+    out_ += value ? "true" : "false";
+    after_value();
+    return *this;
+}
+
+json_writer& json_writer::value(double value) {
+    if (!std::isfinite(value)) {
+        throw std::runtime_error("Number is not finite");
+    }
+
+    before_value();
+    json_number::write(out_, value);
+    after_value();
+    return *this;
+}
+
+json_writer& json_writer::value(std::string_view value) {
+    before_value();
+    string_writer::write(out_, value, ascii_only_);
+    after_value();
+    return *this;
+}
+
+json_writer& json_writer::value(const char* value) {
+    return this->value(std::string_view(value));
+}
+
+json_writer& json_writer::value(const std::string& value) {
+    return this->value(std::string_view(value));
+}
+
+json_writer& json_writer::value(const json_value& value) {
+    before_value();
+    value.dump_to(out_, indent_, indent_ >= 0 ? static_cast<int>(stack_.size()) * indent_ : 0, ascii_only_);
+    after_value();
+    return *this;
+}
+
+bool json_writer::complete() const {
+    return complete_;
+}
+
+void json_writer::flush() {
+    if (sink_ == sink_kind::string || buffer_.empty()) {
+        return;
+    }
+
+    if (sink_ == sink_kind::stream) {
+        stream_->write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+        buffer_.clear();
+        if (!*stream_) {
+            throw std::runtime_error("Failed to write JSON output");
+        }
+
+        return;
+    }
+
+    size_t written = 0;
+    while (written < buffer_.size()) {
+        ssize_t result = ::write(fd_, buffer_.data() + written, buffer_.size() - written);
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            buffer_.erase(0, written);
+            throw std::runtime_error("Failed to write JSON output");
+        }
+
+        written += static_cast<size_t>(result);
+    }
+
+    buffer_.clear();
+}
+
+// Checks that a value may start here and writes the separator and
+// indentation that precede it
+void json_writer::before_value() {
+    if (complete_) {
+        throw std::runtime_error("Document already complete");
+    }
+
+    if (stack_.empty()) {
+        return;
+    }
+
+    frame& top = stack_.back();
+    if (top.is_object) {
+        if (!has_key_) {
+            throw std::runtime_error("Value written in an object without a key");
+        }
+
+        return;
+    }
+
+    if (top.count > 0) {
+        out_ += ',';
+    }
+
+    newline(stack_.size());
+}
+
+void json_writer::after_value() {
+    has_key_ = false;
+    if (stack_.empty()) {
+        complete_ = true;
+    }
+    else {
+        ++stack_.back().count;
+    }
+
+    maybe_flush();
+}
+
+void json_writer::open(bool is_object) {
+    before_value();
+    out_ += is_object ? '{' : '[';
+    stack_.push_back({is_object, 0});
+    has_key_ = false;
+}
+
+void json_writer::close(bool is_object) {
+    if (stack_.empty() || stack_.back().is_object != is_object) {
+        throw std::runtime_error(is_object ? "end_object without matching begin_object"
+                                           : "end_array without matching begin_array");
+    }
+
+    if (has_key_) {
+        throw std::runtime_error("Key written without a value");
+    }
+
+    bool empty = stack_.back().count == 0;
+    stack_.pop_back();
+    if (!empty) {
+        newline(stack_.size());
+    }
+
+    out_ += is_object ? '}' : ']';
+    after_value();
+}
+
+// Pretty printing only: line break and indentation for the given depth,
+// matching json_value::dump
+void json_writer::newline(size_t depth) {
+    if (indent_ < 0) {
+        return;
+    }
+
+    out_ += '\n';
+    out_.append(depth * static_cast<size_t>(indent_), ' ');
+}
+
+void json_writer::write_integer(long long value) {
+    before_value();
+    char buffer[32];
+    int length = std::snprintf(buffer, sizeof(buffer), "%lld", value);
+    out_.append(buffer, static_cast<size_t>(length));
+    after_value();
+}
+
+void json_writer::write_unsigned(unsigned long long value) {
+    before_value();
+    char buffer[32];
+    int length = std::snprintf(buffer, sizeof(buffer), "%llu", value);
+    out_.append(buffer, static_cast<size_t>(length));
+    after_value();
+}
+
+void json_writer::maybe_flush() {
+    if (sink_ != sink_kind::string && buffer_.size() >= flush_threshold) {
+        flush();
+    }
+}
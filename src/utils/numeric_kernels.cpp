@@ -0,0 +1,217 @@
+#include "../../include/utils/numeric_kernels.hpp"
+#include <algorithm>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+    constexpr std::uint64_t full_word = ~std::uint64_t(0);
+
+    double sum_range(const double* data, size_t count) {
+        size_t i = 0;
+        double result = 0.0;
+#if defined(__SSE2__)
+        __m128d first = _mm_setzero_pd();
+        __m128d second = _mm_setzero_pd();
+        for (; i + 4 <= count; i += 4) {
+            first = _mm_add_pd(first, _mm_loadu_pd(data + i));
+            second = _mm_add_pd(second, _mm_loadu_pd(data + i + 2));
+        }
+
+        double lanes[2];
+        _mm_storeu_pd(lanes, _mm_add_pd(first, second));
+        result = lanes[0] + lanes[1];
+#endif
+        for (; i < count; ++i) {
+            result += data[i];
+        }
+
+        return result;
+    }
+
+    // Folds data[0, count) into result with op, which is std::min or std::max
+    template <typename scalar_op, typename vector_op>
+    double reduce_range(const double* data, size_t count, double result, scalar_op op, vector_op vop) {
+        size_t i = 0;
+#if defined(__SSE2__)
+        if (count >= 2) {
+            __m128d acc = _mm_set1_pd(result);
+            for (; i + 2 <= count; i += 2) {
+                acc = vop(acc, _mm_loadu_pd(data + i));
+            }
+
+            double lanes[2];
+            _mm_storeu_pd(lanes, acc);
+            result = op(lanes[0], lanes[1]);
+        }
+#else
+        (void)vop;
+#endif
+        for (; i < count; ++i) {
+            result = op(result, data[i]);
+        }
+
+        return result;
+    }
+
+    // Applies fn to every selected run: full 64-element words as a range,
+    // other words bit by bit
+    template <typename range_fn, typename element_fn>
+    void for_each_selected(const std::uint64_t* mask, size_t count, range_fn on_range, element_fn on_element) {
+        if (!mask) {
+            on_range(0, count);
+            return;
+        }
+
+        size_t words = (count + 63) / 64;
+        for (size_t w = 0; w < words; ++w) {
+            std::uint64_t bits = mask[w];
+            size_t base = w * 64;
+            if (bits == full_word && base + 64 <= count) {
+                on_range(base, 64);
+                continue;
+            }
+
+            while (bits != 0) {
+                size_t index = base + static_cast<size_t>(__builtin_ctzll(bits));
+                if (index >= count) {
+                    break;
+                }
+
+                on_element(index);
+                bits &= bits - 1;
+            }
+        }
+    }
+
+    template <typename scalar_op, typename vector_op>
+    bool reduce(const double* data, const std::uint64_t* mask, size_t count, double& result, scalar_op op, vector_op vop) {
+        bool found = false;
+        for_each_selected(mask, count,
+            [&](size_t begin, size_t length) {
+                if (length == 0) {
+                    return;
+                }
+
+                double seed = found ? result : data[begin];
+                result = reduce_range(data + begin, length, seed, op, vop);
+                found = true;
+            },
+            [&](size_t index) {
+                result = found ? op(result, data[index]) : data[index];
+                found = true;
+            });
+
+        return found;
+    }
+
+    bool holds(double lhs, numeric_kernels::comparison op, double rhs) {
+        switch (op) {
+            case numeric_kernels::comparison::less: return lhs < rhs;
+            case numeric_kernels::comparison::less_equal: return lhs <= rhs;
+            case numeric_kernels::comparison::equal: return lhs == rhs;
+            case numeric_kernels::comparison::not_equal: return lhs != rhs;
+            case numeric_kernels::comparison::greater_equal: return lhs >= rhs;
+            case numeric_kernels::comparison::greater: return lhs > rhs;
+        }
+
+        return false;
+    }
+
+#if defined(__SSE2__)
+    __m128d compare_pair(__m128d values, numeric_kernels::comparison op, __m128d operand) {
+        switch (op) {
+            case numeric_kernels::comparison::less: return _mm_cmplt_pd(values, operand);
+            case numeric_kernels::comparison::less_equal: return _mm_cmple_pd(values, operand);
+            case numeric_kernels::comparison::equal: return _mm_cmpeq_pd(values, operand);
+            case numeric_kernels::comparison::not_equal: return _mm_cmpneq_pd(values, operand);
+            case numeric_kernels::comparison::greater_equal: return _mm_cmpge_pd(values, operand);
+            case numeric_kernels::comparison::greater: return _mm_cmpgt_pd(values, operand);
+        }
+
+        return _mm_setzero_pd();
+    }
+#endif
+}
+
+bool numeric_kernels::equal(const double* a, const double* b, size_t count) {
+    size_t i = 0;
+#if defined(__SSE2__)
+    for (; i + 4 <= count; i += 4) {
+        __m128d first = _mm_cmpeq_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i));
+        __m128d second = _mm_cmpeq_pd(_mm_loadu_pd(a + i + 2), _mm_loadu_pd(b + i + 2));
+        if (_mm_movemask_pd(_mm_and_pd(first, second)) != 0x3) {
+            return false;
+        }
+    }
+#endif
+    for (; i < count; ++i) {
+        if (a[i] != b[i]) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+double numeric_kernels::sum(const double* data, const std::uint64_t* mask, size_t count) {
+    double result = 0.0;
+    for_each_selected(mask, count,
+        [&](size_t begin, size_t length) { result += sum_range(data + begin, length); },
+        [&](size_t index) { result += data[index]; });
+
+    return result;
+}
+
+bool numeric_kernels::min(const double* data, const std::uint64_t* mask, size_t count, double& result) {
+#if defined(__SSE2__)
+    auto vop = [](__m128d a, __m128d b) { return _mm_min_pd(a, b); };
+#else
+    auto vop = 0;
+#endif
+    return reduce(data, mask, count, result, [](double a, double b) { return std::min(a, b); }, vop);
+}
+
+bool numeric_kernels::max(const double* data, const std::uint64_t* mask, size_t count, double& result) {
+#if defined(__SSE2__)
+    auto vop = [](__m128d a, __m128d b) { return _mm_max_pd(a, b); };
+#else
+    auto vop = 0;
+#endif
+    return reduce(data, mask, count, result, [](double a, double b) { return std::max(a, b); }, vop);
+}
+
+size_t numeric_kernels::count(const std::uint64_t* mask, size_t count) {
+    size_t result = 0;
+    size_t full = count / 64;
+    for (size_t w = 0; w < full; ++w) {
+        result += static_cast<size_t>(__builtin_popcountll(mask[w]));
+    }
+
+    size_t rest = count % 64;
+    if (rest != 0) {
+        std::uint64_t last = mask[full] & ((std::uint64_t(1) << rest) - 1);
+        result += static_cast<size_t>(__builtin_popcountll(last));
+    }
+
+    return result;
+}
+
+void numeric_kernels::compare(const double* data, size_t count, comparison op, double value, std::uint64_t* out) {
+    size_t words = (count + 63) / 64;
+    std::fill(out, out + words, std::uint64_t(0));
+    size_t i = 0;
+#if defined(__SSE2__)
+    __m128d operand = _mm_set1_pd(value);
+    for (; i + 2 <= count; i += 2) {
+        int bits = _mm_movemask_pd(compare_pair(_mm_loadu_pd(data + i), op, operand));
+        // i is even, so both bits land in the same word
+        out[i / 64] |= static_cast<std::uint64_t>(bits) << (i % 64);
+    }
+#endif
+    for (; i < count; ++i) {
+        if (holds(data[i], op, value)) {
+            out[i / 64] |= std::uint64_t(1) << (i % 64);
+        }
+    }
+}
@@ -0,0 +1,66 @@
+#include "../../include/utils/string_scanner.hpp"
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+size_t string_scanner::plain_prefix(const char* data, size_t size, bool stop_at_non_ascii) {
+    size_t pos = 0;
+#if defined(__SSE2__)
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i last_control = _mm_set1_epi8(0x1f);
+    for (; pos + 16 <= size; pos += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+        // saturating subtract leaves zero exactly for bytes <= 0x1f
+        __m128i control = _mm_cmpeq_epi8(_mm_subs_epu8(chunk, last_control), _mm_setzero_si128());
+        __m128i special = _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash));
+        int mask = _mm_movemask_epi8(_mm_or_si128(control, special));
+        if (stop_at_non_ascii) {
+            mask |= _mm_movemask_epi8(chunk);
+        }
+
+        if (mask != 0) {
+            return pos + static_cast<size_t>(__builtin_ctz(static_cast<unsigned>(mask)));
+        }
+    }
+#endif
+    while (pos < size) {
+        unsigned char c = static_cast<unsigned char>(data[pos]);
+        if (c < 0x20 || c == '"' || c == '\\' || (stop_at_non_ascii && c >= 0x80)) {
+            break;
+        }
+
+        ++pos;
+    }
+
+    return pos;
+}
+
+size_t string_scanner::whitespace_prefix(const char* data, size_t size) {
+    size_t pos = 0;
+#if defined(__SSE2__)
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i line_feed = _mm_set1_epi8('\n');
+    const __m128i carriage_return = _mm_set1_epi8('\r');
+    for (; pos + 16 <= size; pos += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+        __m128i blank = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, space), _mm_cmpeq_epi8(chunk, tab)),
+                                     _mm_or_si128(_mm_cmpeq_epi8(chunk, line_feed), _mm_cmpeq_epi8(chunk, carriage_return)));
+        int mask = ~_mm_movemask_epi8(blank) & 0xffff;
+        if (mask != 0) {
+            return pos + static_cast<size_t>(__builtin_ctz(static_cast<unsigned>(mask)));
+        }
+    }
+#endif
+    while (pos < size) {
+        char c = data[pos];
+        if (c != ' ' && c != '\t' && c != '\n' && c != '\r') {
+            break;
+        }
+
+        ++pos;
+    }
+
+    return pos;
+}
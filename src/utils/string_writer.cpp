@@ -0,0 +1,73 @@
+#include "../../include/utils/string_writer.hpp"
+#include "../../include/utils/string_scanner.hpp"
+#include "../../include/utils/utf8.hpp"
+
+namespace {
+    const char hex_digits[] = "0123456789abcdef";
+}
+
+void string_writer::write(std::string& out, std::string_view value, bool ascii_only) {
+    out.reserve(out.size() + value.size() + 2);
+    out += '"';
+
+    const char* data = value.data();
+    size_t size = value.size();
+    size_t pos = 0;
+    while (pos < size) {
+        size_t clean = string_scanner::plain_prefix(data + pos, size - pos, ascii_only);
+        out.append(data + pos, clean);
+        pos += clean;
+        if (pos >= size) {
+            break;
+        }
+
+        unsigned char c = static_cast<unsigned char>(data[pos]);
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\b': out += "\\b"; break;
+            case '\f': out += "\\f"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (c < 0x80) {
+                    write_unicode_escape(out, c);
+                    break;
+                }
+
+                std::uint32_t code_point;
+                size_t length = utf8::decode(data + pos, size - pos, code_point);
+                if (length == 0) {
+                    write_unicode_escape(out, 0xfffd);
+                    length = 1;
+                }
+                else if (code_point >= 0x10000) {
+                    code_point -= 0x10000;
+                    write_unicode_escape(out, 0xd800 + (code_point >> 10));
+                    write_unicode_escape(out, 0xdc00 + (code_point & 0x3ff));
+                }
+                else {
+                    write_unicode_escape(out, code_point);
+                }
+
+                pos += length;
+                continue;
+        }
+
+        ++pos;
+    }
+
+    out += '"';
+}
+
+void string_writer::write_unicode_escape(std::string& out, unsigned code_unit) {
+    char buffer[6] = {
+        '\\', 'u',
+        hex_digits[(code_unit >> 12) & 0xf],
+        hex_digits[(code_unit >> 8) & 0xf],
+        hex_digits[(code_unit >> 4) & 0xf],
+        hex_digits[code_unit & 0xf]
+    };
+    out.append(buffer, sizeof(buffer));
+}
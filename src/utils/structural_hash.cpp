@@ -0,0 +1,66 @@
+#include "../../include/utils/structural_hash.hpp"
+#include <cstdint>
+#include <cstring>
+#include <functional>
+
+namespace {
+    constexpr std::uint64_t null_tag = 0x6e756c6cULL;
+    constexpr std::uint64_t boolean_tag = 0x626f6f6cULL;
+    constexpr std::uint64_t number_tag = 0x6e756d62ULL;
+    constexpr std::uint64_t string_tag = 0x73747269ULL;
+    constexpr std::uint64_t array_tag = 0x61727261ULL;
+    constexpr std::uint64_t object_tag = 0x6f626a65ULL;
+
+    // splitmix64 finalizer
+    size_t mix(std::uint64_t value) {
+        value ^= value >> 30;
+        value *= 0xbf58476d1ce4e5b9ULL;
+        value ^= value >> 27;
+        value *= 0x94d049bb133111ebULL;
+        value ^= value >> 31;
+        return static_cast<size_t>(value);
+    }
+}
+
+size_t structural_hash::of_null() {
+    return mix(null_tag);
+}
+
+size_t structural_hash::of_boolean(bool value) {
+    return mix(boolean_tag + (value ? 1 : 0));
+}
+
+size_t structural_hash::of_number(double value) {
+    if (value == 0.0) {
+        value = 0.0;
+    }
+
+    std::uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return mix(number_tag ^ mix(bits));
+}
+
+size_t structural_hash::of_string(std::string_view value) {
+    return mix(string_tag ^ std::hash<std::string_view>()(value));
+}
+
+size_t structural_hash::array_seed(size_t size) {
+    return mix(array_tag + size);
+}
+
+size_t structural_hash::add_element(size_t seed, size_t element) {
+    return mix(seed * 31 + element);
+}
+
+size_t structural_hash::member(std::string_view key, size_t value) {
+    return mix(std::hash<std::string_view>()(key) * 31 + value);
+}
+
+size_t structural_hash::object_seed(size_t member_sum, size_t size) {
+    return mix(object_tag + size) ^ member_sum;
+}
+
+size_t structural_hash::finish(size_t seed) {
+    size_t result = mix(seed);
+    return result != 0 ? result : 1;
+}
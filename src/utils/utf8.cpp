@@ -0,0 +1,81 @@
+#include "../../include/utils/utf8.hpp"
+
+size_t utf8::decode(const char* data, size_t size, std::uint32_t& code_point) {
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+    if (size == 0) {
+        return 0;
+    }
+
+    unsigned char lead = bytes[0];
+    if (lead < 0x80) {
+        code_point = lead;
+        return 1;
+    }
+
+    size_t length;
+    unsigned char low = 0x80;
+    unsigned char high = 0xbf;
+    if (lead >= 0xc2 && lead <= 0xdf) {
+        length = 2;
+        code_point = lead & 0x1f;
+    }
+    else if (lead >= 0xe0 && lead <= 0xef) {
+        length = 3;
+        code_point = lead & 0x0f;
+        if (lead == 0xe0) {
+            low = 0xa0;
+        }
+        else if (lead == 0xed) {
+            high = 0x9f;
+        }
+    }
+    else if (lead >= 0xf0 && lead <= 0xf4) {
+        length = 4;
+        code_point = lead & 0x07;
+        if (lead == 0xf0) {
+            low = 0x90;
+        }
+        else if (lead == 0xf4) {
+            high = 0x8f;
+        }
+    }
+    else {
+        return 0;
+    }
+
+    if (size < length || bytes[1] < low || bytes[1] > high) {
+        return 0;
+    }
+
+    code_point = (code_point << 6) | (bytes[1] & 0x3f);
+    for (size_t i = 2; i < length; ++i) {
+        if ((bytes[i] & 0xc0) != 0x80) {
+            return 0;
+        }
+
+        code_point = (code_point << 6) | (bytes[i] & 0x3f);
+    }
+
+    return length;
+}
+
+void utf8::encode(std::string& out, std::uint32_t code_point) {
+    if (code_point < 0x80) {
+        out += static_cast<char>(code_point);
+    }
+    else if (code_point < 0x800) {
+        out += static_cast<char>(0xc0 | (code_point >> 6));
+        out += static_cast<char>(0x80 | (code_point & 0x3f));
+    }
+    else if (code_point < 0x10000) {
+        out += static_cast<char>(0xe0 | (code_point >> 12));
+        out += static_cast<char>(0x80 | ((code_point >> 6) & 0x3f));
+        out += static_cast<char>(0x80 | (code_point & 0x3f));
+    }
+    else {
+        out += static_cast<char>(0xf0 | (code_point >> 18));
+        out += static_cast<char>(0x80 | ((code_point >> 12) & 0x3f));
+        out += static_cast<char>(0x80 | ((code_point >> 6) & 0x3f));
+        out += static_cast<char>(0x80 | (code_point & 0x3f));
+    }
+}